@@ -0,0 +1,349 @@
+// Measures how fast each sampler converges: renders every scene once with
+// many samples per pixel as a reference, then with each sampler at powers
+// of two up to `--max-spp`, and reports the root mean square error of the
+// linear radiance of every render against the reference, over a few
+// trials with different seeds, since a few bright paths can dominate the
+// error of a single render. The reference is rendered with a seed of its
+// own, so that its noise is not shared with the renders it is compared to.
+//
+// The scenes are the built-in one and a closed box lit by a small area
+// light, or the given scene file. The results go to standard output as JSON
+// and to standard error as a table, followed by the samples each sampler
+// needs to reach the error of independent sampling at the most samples.
+//
+// Usage: convergence_bench [--scene <file>] [--width <n>] [--height <n>]
+//                          [--max-spp <n>] [--reference-spp <n>]
+//                          [--trials <n>] [--threads <n>]
+
+#include "film.h"
+#include "radiance.h"
+#include "renderer.h"
+#include "sampler.h"
+#include "scene-file.h"
+#include "scene.h"
+#include "thread-pool.h"
+#include "transform.h"
+#include "triangle-mesh.h"
+#include "vector3.h"
+
+#include <cmath>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+
+using namespace ray_tracing;
+
+static constexpr std::uint64_t reference_seed{~std::uint64_t{0}};
+
+struct ConvergenceSettings {
+    const char* scene_filename{nullptr};
+
+    std::size_t image_width{128};
+
+    std::size_t image_height{72};
+
+    std::size_t max_samples_per_pixel{64};
+
+    std::size_t reference_samples_per_pixel{1024};
+
+    std::size_t num_trials{4};
+
+    std::size_t num_threads{0};
+};
+
+struct SamplerName {
+    SamplerType type;
+
+    const char* name;
+};
+
+static const SamplerName samplers[]{{SamplerType::independent, "independent"},
+                                    {SamplerType::stratified, "stratified"},
+                                    {SamplerType::sobol, "sobol"},
+                                    {SamplerType::blue_noise, "blue-noise"}};
+
+struct Result {
+    std::string scene;
+
+    const char* sampler;
+
+    std::size_t samples_per_pixel;
+
+    double rmse;
+};
+
+static bool parse_arguments(int argc,
+                            char* argv[],
+                            ConvergenceSettings& settings) {
+    for (auto i{1}; i < argc; ++i) {
+        if (i + 1 == argc) {
+            return false;
+        }
+        if (std::strcmp(argv[i], "--scene") == 0) {
+            settings.scene_filename = argv[++i];
+            continue;
+        }
+        std::size_t* value{nullptr};
+        if (std::strcmp(argv[i], "--width") == 0) {
+            value = &settings.image_width;
+        } else if (std::strcmp(argv[i], "--height") == 0) {
+            value = &settings.image_height;
+        } else if (std::strcmp(argv[i], "--max-spp") == 0) {
+            value = &settings.max_samples_per_pixel;
+        } else if (std::strcmp(argv[i], "--reference-spp") == 0) {
+            value = &settings.reference_samples_per_pixel;
+        } else if (std::strcmp(argv[i], "--trials") == 0) {
+            value = &settings.num_trials;
+        } else if (std::strcmp(argv[i], "--threads") == 0) {
+            value = &settings.num_threads;
+        }
+        if (!value) {
+            return false;
+        }
+        *value = std::strtoull(argv[++i], nullptr, 10);
+        if (*value == 0) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static std::shared_ptr<const TriangleMesh> make_quad(const Vector3& p0,
+                                                     const Vector3& p1,
+                                                     const Vector3& p2,
+                                                     const Vector3& p3,
+                                                     std::uint32_t material) {
+    return std::make_shared<TriangleMesh>(
+            MeshData{{p0, p1, p2, p3}, {0, 1, 2, 0, 2, 3}},
+            material);
+}
+
+// A closed box with colored side walls, lit only by a small square light
+// under its ceiling, with a diffuse and a metal sphere on the floor and the
+// camera inside the front wall.
+static void box_scene(Scene& scene, ThreadPool& pool) {
+    using Type = Scene::MaterialRecord::Type;
+    auto white{scene.add_material({Type::lambertian, 0, {0.73, 0.73, 0.73}})};
+    auto red{scene.add_material({Type::lambertian, 0, {0.65, 0.05, 0.05}})};
+    auto green{scene.add_material({Type::lambertian, 0, {0.12, 0.45, 0.15}})};
+    auto steel{scene.add_material({Type::metal, 0, {0.8, 0.8, 0.8, 0.2}})};
+    auto lamp{scene.add_material({Type::diffuse_light, 0, {15, 15, 15}})};
+
+    // Wound to face into the box.
+    const Vector3 corners[]{{-1, 0, -1},
+                            {1, 0, -1},
+                            {1, 0, 1},
+                            {-1, 0, 1},
+                            {-1, 2, -1},
+                            {1, 2, -1},
+                            {1, 2, 1},
+                            {-1, 2, 1}};
+    auto add{[&](int a, int b, int c, int d, std::uint32_t material) {
+        scene.instances.add(make_quad(corners[a],
+                                      corners[b],
+                                      corners[c],
+                                      corners[d],
+                                      material),
+                            Transform{});
+    }};
+    add(0, 3, 2, 1, white);
+    add(4, 5, 6, 7, white);
+    add(3, 7, 6, 2, white);
+    add(0, 1, 5, 4, white);
+    add(0, 4, 7, 3, red);
+    add(1, 2, 6, 5, green);
+    scene.instances.add(make_quad(Vector3{-0.25, 1.99, -0.25},
+                                  Vector3{0.25, 1.99, -0.25},
+                                  Vector3{0.25, 1.99, 0.25},
+                                  Vector3{-0.25, 1.99, 0.25},
+                                  lamp),
+                        Transform{});
+    scene.spheres.add(Vector3{-0.4, 0.35, 0.3}, 0.35, white);
+    scene.spheres.add(Vector3{0.45, 0.3, -0.2}, 0.3, steel);
+
+    scene.lookfrom = Vector3{0, 1, -0.98};
+    scene.lookat = Vector3{0, 1, 1};
+    scene.vertical_fov = 70;
+    scene.aperture = 0;
+    scene.max_depth = 8;
+    scene.build(pool);
+}
+
+static std::vector<Radiance> render(const Scene& scene,
+                                    ThreadPool& pool,
+                                    SamplerType sampler,
+                                    std::size_t samples_per_pixel,
+                                    std::uint64_t seed) {
+    auto camera{scene.camera()};
+    auto world{scene.world()};
+    Renderer renderer{camera,
+                      world,
+                      scene.materials,
+                      scene.lights,
+                      RenderSettings{scene.image_width,
+                                     scene.image_height,
+                                     samples_per_pixel,
+                                     scene.max_depth,
+                                     16,
+                                     false,
+                                     0,
+                                     sampler,
+                                     seed}};
+    Film film{scene.image_width, scene.image_height};
+    renderer.render(pool, 0, scene.image_height, film);
+    std::vector<Radiance> means;
+    means.reserve(film.pixels.size());
+    for (const auto& pixel : film.pixels) {
+        means.emplace_back(pixel.mean());
+    }
+    return means;
+}
+
+static double squared_error(const std::vector<Radiance>& image,
+                            const std::vector<Radiance>& reference) {
+    double sum{0};
+    for (std::size_t i{0}; i < image.size(); ++i) {
+        double dr{image[i].r - reference[i].r};
+        double dg{image[i].g - reference[i].g};
+        double db{image[i].b - reference[i].b};
+        sum += dr * dr + dg * dg + db * db;
+    }
+    return sum / (3 * image.size());
+}
+
+static void bench_scene(const std::string& scene_name,
+                        Scene& scene,
+                        ThreadPool& pool,
+                        const ConvergenceSettings& settings,
+                        std::vector<Result>& results) {
+    scene.image_width = settings.image_width;
+    scene.image_height = settings.image_height;
+    std::cerr << scene_name << ": rendering the reference at "
+              << settings.reference_samples_per_pixel << " spp.\n";
+    auto reference{render(scene,
+                          pool,
+                          SamplerType::sobol,
+                          settings.reference_samples_per_pixel,
+                          reference_seed)};
+
+    std::cerr << std::left << std::setw(16) << "spp";
+    for (const auto& sampler : samplers) {
+        std::cerr << std::setw(14) << sampler.name;
+    }
+    std::cerr << '\n';
+    auto first{results.size()};
+    for (std::size_t spp{1}; spp <= settings.max_samples_per_pixel;
+         spp *= 2) {
+        std::cerr << std::setw(16) << spp;
+        for (const auto& sampler : samplers) {
+            double sum{0};
+            for (std::size_t seed{0}; seed < settings.num_trials; ++seed) {
+                sum += squared_error(
+                        render(scene, pool, sampler.type, spp, seed),
+                        reference);
+            }
+            auto error{std::sqrt(sum / settings.num_trials)};
+            results.emplace_back(Result{scene_name, sampler.name, spp, error});
+            std::cerr << std::setw(14) << std::setprecision(5)
+                      << std::defaultfloat << error;
+        }
+        std::cerr << '\n';
+    }
+
+    // The fewest samples at which each sampler does as well as independent
+    // sampling does with the most, interpolated in the log of both.
+    double target{0};
+    for (auto i{first}; i < results.size(); ++i) {
+        if (results[i].sampler == samplers[0].name) {
+            target = results[i].rmse;
+        }
+    }
+    std::cerr << "Samples per pixel to reach the error of independent "
+                 "sampling at the most samples:\n";
+    for (const auto& sampler : samplers) {
+        const Result* previous{nullptr};
+        double needed{0};
+        for (auto i{first}; i < results.size(); ++i) {
+            const auto& result{results[i]};
+            if (result.sampler != sampler.name) {
+                continue;
+            }
+            if (result.rmse <= target) {
+                needed = static_cast<double>(result.samples_per_pixel);
+                if (previous && previous->rmse > target) {
+                    auto t{std::log(previous->rmse / target)
+                           / std::log(previous->rmse / result.rmse)};
+                    needed = previous->samples_per_pixel
+                             * std::pow(2.0, t);
+                }
+                break;
+            }
+            previous = &result;
+        }
+        std::cerr << "  " << std::setw(14) << sampler.name;
+        if (needed > 0) {
+            std::cerr << std::fixed << std::setprecision(1) << needed << '\n';
+        } else {
+            std::cerr << "more than " << settings.max_samples_per_pixel
+                      << '\n';
+        }
+    }
+}
+
+static void write_json(const std::vector<Result>& results,
+                       const ConvergenceSettings& settings) {
+    std::cout << "{\n  \"context\": {\"width\": " << settings.image_width
+              << ", \"height\": " << settings.image_height
+              << ", \"reference_spp\": "
+              << settings.reference_samples_per_pixel
+              << ", \"trials\": " << settings.num_trials
+              << "},\n  \"results\": [\n";
+    for (std::size_t i{0}; i < results.size(); ++i) {
+        const auto& result{results[i]};
+        std::cout << "    {\"scene\": \"" << result.scene
+                  << "\", \"sampler\": \"" << result.sampler
+                  << "\", \"spp\": " << result.samples_per_pixel
+                  << std::setprecision(6) << std::defaultfloat
+                  << ", \"rmse\": " << result.rmse << '}'
+                  << (i + 1 < results.size() ? ",\n" : "\n");
+    }
+    std::cout << "  ]\n}\n";
+}
+
+int main(int argc, char* argv[]) {
+    ConvergenceSettings settings;
+    if (!parse_arguments(argc, argv, settings)) {
+        std::cerr << "Usage: " << argv[0]
+                  << " [--scene <file>] [--width <n>] [--height <n>]"
+                     " [--max-spp <n>] [--reference-spp <n>]"
+                     " [--trials <n>] [--threads <n>]\n";
+        return 1;
+    }
+
+    ThreadPool pool{settings.num_threads ? settings.num_threads
+                                         : ThreadPool::default_size()};
+    std::vector<Result> results;
+    if (settings.scene_filename) {
+        Scene scene;
+        if (!load_scene(settings.scene_filename, pool, scene)) {
+            return 1;
+        }
+        bench_scene(settings.scene_filename, scene, pool, settings, results);
+    } else {
+        Scene random;
+        random_scene(random, pool);
+        bench_scene("random", random, pool, settings, results);
+        Scene box;
+        box_scene(box, pool);
+        bench_scene("box", box, pool, settings, results);
+    }
+
+    write_json(results, settings);
+    return 0;
+}
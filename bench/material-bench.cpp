@@ -0,0 +1,224 @@
+// Measures what hit records and material dispatch cost per ray: plain hit
+// records holding an index into the material table, dispatched on the
+// material variant, against the shared_ptr hit records and virtual `scatter`
+// they replaced, which are reproduced here. Each ray copies the record of a
+// hit, as a hittable does for every closer hit it finds, and scatters off it.
+//
+// Usage: material_bench [threads]
+
+#include "hittable.h"
+#include "material.h"
+#include "radiance.h"
+#include "random-generator.h"
+#include "ray.h"
+#include "sampler.h"
+#include "utils.h"
+#include "vector3.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include <cstdlib>
+
+using namespace ray_tracing;
+
+class VirtualMaterial {
+public:
+    virtual ~VirtualMaterial() = default;
+
+    virtual bool scatter(const Ray& incident,
+                         const Hittable::HitInfo& hit_info,
+                         const ScatterSample& sample,
+                         Ray& scattered,
+                         Radiance& attenuation) const
+            = 0;
+};
+
+template <typename T>
+class VirtualAdapter : public VirtualMaterial {
+public:
+    VirtualAdapter(const T& material) : material{material} {}
+
+    bool scatter(const Ray& incident,
+                 const Hittable::HitInfo& hit_info,
+                 const ScatterSample& sample,
+                 Ray& scattered,
+                 Radiance& attenuation) const override {
+        return material.scatter(incident,
+                                hit_info,
+                                sample,
+                                scattered,
+                                attenuation);
+    }
+
+private:
+    T material;
+};
+
+struct SharedHitInfo {
+    Hittable::HitInfo hit_info;
+
+    std::shared_ptr<VirtualMaterial> material_ptr;
+};
+
+static constexpr std::size_t num_materials{64};
+
+static constexpr std::size_t num_hits{1 << 12};
+
+static constexpr std::size_t num_rays_per_thread{1 << 21};
+
+// Each variant is measured this many times, alternating, and the fastest
+// run is reported to keep out the noise of other processes.
+static constexpr std::size_t num_rounds{5};
+
+static Material random_material(RandomGenerator& generator) {
+    auto albedo{Radiance{random_float(generator),
+                         random_float(generator),
+                         random_float(generator)}};
+    auto material_choice{random_double(generator)};
+    if (material_choice < 0.6) {
+        return Lambertian{albedo};
+    }
+    if (material_choice < 0.9) {
+        return Metal{albedo, random_float(generator, 0, 0.5)};
+    }
+    return Dielectric{1.5};
+}
+
+static ScatterSample random_scatter_sample(RandomGenerator& generator) {
+    auto u{random_double(generator)};
+    auto v{random_double(generator)};
+    auto choice{random_double(generator)};
+    return ScatterSample{{u, v}, choice};
+}
+
+// Runs `trace_ray(ray_index, generator)` on every thread and returns the
+// wall time per ray of each thread, in nanoseconds.
+template <typename TraceRay>
+static double measure(std::size_t num_threads, const TraceRay& trace_ray) {
+    std::atomic<double> sink{0};
+    std::vector<std::thread> threads;
+    auto start{std::chrono::steady_clock::now()};
+    for (auto thread_index{decltype(num_threads){0}};
+         thread_index < num_threads;
+         ++thread_index) {
+        threads.emplace_back([&, thread_index] {
+            RandomGenerator generator{thread_index};
+            double sum{0};
+            for (auto i{decltype(num_rays_per_thread){0}};
+                 i < num_rays_per_thread;
+                 ++i) {
+                sum += trace_ray(i, generator);
+            }
+            sink = sink + sum;
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    std::chrono::duration<double, std::nano> elapsed{
+            std::chrono::steady_clock::now() - start};
+    if (sink == -1) {
+        std::cerr << "Unexpected result.\n";
+    }
+    return elapsed.count() / num_rays_per_thread;
+}
+
+int main(int argc, char* argv[]) {
+    auto num_threads{std::size_t{1}};
+    if (argc > 1) {
+        num_threads = std::strtoull(argv[1], nullptr, 10);
+    }
+    if (num_threads == 0) {
+        std::cerr << "Usage: " << argv[0] << " [threads]\n";
+        return 1;
+    }
+
+    RandomGenerator generator{42};
+    std::vector<Material> materials;
+    std::vector<std::shared_ptr<VirtualMaterial>> material_ptrs;
+    for (auto i{decltype(num_materials){0}}; i < num_materials; ++i) {
+        materials.emplace_back(random_material(generator));
+        material_ptrs.emplace_back(std::visit(
+                [](const auto& material)
+                        -> std::shared_ptr<VirtualMaterial> {
+                    using Type = std::decay_t<decltype(material)>;
+                    return std::make_shared<VirtualAdapter<Type>>(material);
+                },
+                materials.back()));
+    }
+
+    std::vector<Ray> incident_rays;
+    std::vector<Hittable::HitInfo> hit_infos;
+    std::vector<SharedHitInfo> shared_hit_infos;
+    for (auto i{decltype(num_hits){0}}; i < num_hits; ++i) {
+        auto normal{random_unit_vector(generator)};
+        auto direction{random_unit_vector(generator)};
+        if (Vector3::dot(direction, normal) > 0) {
+            direction = -direction;
+        }
+        auto point{Vector3::random(generator, -10, 10)};
+        auto material_id{static_cast<std::uint32_t>(
+                generator.next_uint32() % num_materials)};
+        incident_rays.emplace_back(point - direction, direction);
+        hit_infos.emplace_back(
+                Hittable::HitInfo{point, normal, 1, material_id, 0});
+        shared_hit_infos.emplace_back(
+                SharedHitInfo{hit_infos.back(), material_ptrs[material_id]});
+    }
+
+    auto trace_indexed{[&](auto i, auto& generator) {
+        auto hit_index{i % num_hits};
+        Hittable::HitInfo hit_info;
+        hit_info = hit_infos[hit_index];
+        Ray scattered;
+        Radiance attenuation;
+        auto scattered_any{scatter(materials[hit_info.material_id],
+                                   incident_rays[hit_index],
+                                   hit_info,
+                                   random_scatter_sample(generator),
+                                   scattered,
+                                   attenuation)};
+        return scattered_any ? attenuation.r + scattered.direction.x : 0;
+    }};
+
+    auto trace_shared{[&](auto i, auto& generator) {
+        auto hit_index{i % num_hits};
+        SharedHitInfo hit_info;
+        hit_info = shared_hit_infos[hit_index];
+        Ray scattered;
+        Radiance attenuation;
+        auto scattered_any{hit_info.material_ptr->scatter(
+                incident_rays[hit_index],
+                hit_info.hit_info,
+                random_scatter_sample(generator),
+                scattered,
+                attenuation)};
+        return scattered_any ? attenuation.r + scattered.direction.x : 0;
+    }};
+
+    auto indexed_ns{std::numeric_limits<double>::infinity()};
+    auto shared_ns{std::numeric_limits<double>::infinity()};
+    for (auto round{decltype(num_rounds){0}}; round < num_rounds; ++round) {
+        indexed_ns = std::min(indexed_ns,
+                              measure(num_threads, trace_indexed));
+        shared_ns = std::min(shared_ns, measure(num_threads, trace_shared));
+    }
+
+    std::cout << std::fixed << std::setprecision(2)
+              << "Threads: " << num_threads << '\n'
+              << "shared_ptr hit record, virtual scatter: " << shared_ns
+              << " ns/ray\n"
+              << "indexed hit record, variant scatter:    " << indexed_ns
+              << " ns/ray\n"
+              << "Saving: " << shared_ns - indexed_ns << " ns/ray ("
+              << 100 * (shared_ns - indexed_ns) / shared_ns << " %)\n";
+    return 0;
+}
@@ -0,0 +1,213 @@
+// Compares the header-inline Vector3 and Color against the out-of-line
+// implementation they replaced, kept in math-reference.cpp, on the kinds of
+// expressions the renderer evaluates per ray. Each kernel is written once
+// and instantiated for both, so the only differences are whether the
+// operators can be inlined and, for colors, the SSE2/AVX path.
+//
+// Usage: math_bench
+
+#include "color.h"
+#include "math-reference.h"
+#include "random-generator.h"
+#include "utils.h"
+#include "vector3.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <vector>
+
+static constexpr std::size_t num_elements{1 << 12};
+
+static constexpr std::size_t num_repetitions{256};
+
+// Each kernel is measured this many times, alternating between the two
+// implementations, and the fastest run is reported.
+static constexpr std::size_t num_rounds{5};
+
+template <typename Vector3>
+struct Inputs {
+    std::vector<Vector3> origins;
+
+    std::vector<Vector3> directions;
+
+    std::vector<Vector3> normals;
+
+    std::vector<typename Vector3::ValueType> scalars;
+};
+
+template <typename Vector3>
+static Inputs<Vector3> make_inputs() {
+    ray_tracing::RandomGenerator generator{42};
+    auto random_vector{[&] {
+        return Vector3{ray_tracing::random_float(generator, -1, 1),
+                       ray_tracing::random_float(generator, -1, 1),
+                       ray_tracing::random_float(generator, -1, 1)};
+    }};
+
+    Inputs<Vector3> inputs;
+    for (auto i{decltype(num_elements){0}}; i < num_elements; ++i) {
+        inputs.origins.emplace_back(random_vector());
+        inputs.directions.emplace_back(random_vector());
+        inputs.normals.emplace_back(random_vector().normalized());
+        inputs.scalars.emplace_back(ray_tracing::random_float(generator));
+    }
+    return inputs;
+}
+
+// The body of Sphere::hit, up to the nearest root.
+template <typename Vector3>
+static double sphere_hit(const Inputs<Vector3>& inputs) {
+    const auto center{Vector3{0, 0, 2}};
+    double sum{0};
+    for (auto i{decltype(num_elements){0}}; i < num_elements; ++i) {
+        const auto& origin{inputs.origins[i]};
+        const auto& direction{inputs.directions[i]};
+        auto radius{inputs.scalars[i]};
+        auto oc{origin - center};
+        auto a{direction.magnitude_sqaured()};
+        auto half_b{Vector3::dot(oc, direction)};
+        auto c{oc.magnitude_sqaured() - radius * radius};
+        auto discriminant{half_b * half_b - a * c};
+        if (discriminant >= 0) {
+            sum += (-half_b - std::sqrt(discriminant)) / a;
+        }
+    }
+    return sum;
+}
+
+// The body of Camera::generate_ray, with a fixed lens offset.
+template <typename Vector3>
+static double camera_ray(const Inputs<Vector3>& inputs) {
+    const auto lookfrom{Vector3{13, 2, -3}};
+    const auto horizontal{Vector3{3.2f, 0, 0.7f}};
+    const auto vertical{Vector3{0.1f, 1.8f, 0.2f}};
+    const auto lower_left_corner{Vector3{-1.6f, -0.9f, 10}};
+    double sum{0};
+    for (auto i{decltype(num_elements){0}}; i < num_elements; ++i) {
+        auto s{inputs.scalars[i]};
+        auto t{inputs.scalars[num_elements - 1 - i]};
+        auto offset{0.05f * inputs.origins[i]};
+        auto direction{lower_left_corner + s * horizontal + t * vertical
+                       - lookfrom - offset};
+        sum += direction.normalized().z;
+    }
+    return sum;
+}
+
+template <typename Vector3>
+static double reflect_refract(const Inputs<Vector3>& inputs) {
+    double sum{0};
+    for (auto i{decltype(num_elements){0}}; i < num_elements; ++i) {
+        const auto& direction{inputs.directions[i]};
+        const auto& normal{inputs.normals[i]};
+        sum += reflect(direction, normal).x
+               + refract(direction, normal, 0.67f).y;
+    }
+    return sum;
+}
+
+template <typename Vector3>
+static double cross_normalize(const Inputs<Vector3>& inputs) {
+    double sum{0};
+    for (auto i{decltype(num_elements){0}}; i < num_elements; ++i) {
+        sum += Vector3::cross(inputs.directions[i], inputs.normals[i])
+                       .normalized()
+                       .z;
+    }
+    return sum;
+}
+
+// The sky color of the path integrator, weighted and accumulated.
+template <typename Vector3, typename Color>
+static double color_mix(const Inputs<Vector3>& inputs) {
+    const auto sky{Color{0.5, 0.7, 1, 1}};
+    auto sum{Color::black};
+    for (auto i{decltype(num_elements){0}}; i < num_elements; ++i) {
+        auto t{inputs.scalars[i]};
+        sum += 0.25 * Color::lerp(Color::white, sky, 0.5 * (t + 1));
+    }
+    return sum.r + sum.g + sum.b;
+}
+
+// Returns the fastest time of one call of `kernel`, in nanoseconds per
+// element.
+template <typename Kernel>
+static double measure(const Kernel& kernel, double& sink) {
+    auto start{std::chrono::steady_clock::now()};
+    for (auto i{decltype(num_repetitions){0}}; i < num_repetitions; ++i) {
+        sink += kernel();
+    }
+    std::chrono::duration<double, std::nano> elapsed{
+            std::chrono::steady_clock::now() - start};
+    return elapsed.count() / (num_repetitions * num_elements);
+}
+
+template <typename ReferenceKernel, typename InlineKernel>
+static void compare(const char* name,
+                    const ReferenceKernel& reference_kernel,
+                    const InlineKernel& inline_kernel,
+                    double& sink) {
+    auto reference_ns{std::numeric_limits<double>::infinity()};
+    auto inline_ns{std::numeric_limits<double>::infinity()};
+    for (auto round{decltype(num_rounds){0}}; round < num_rounds; ++round) {
+        reference_ns = std::min(reference_ns, measure(reference_kernel, sink));
+        inline_ns = std::min(inline_ns, measure(inline_kernel, sink));
+    }
+    std::cout << std::left << std::setw(18) << name << std::right
+              << std::fixed << std::setprecision(2) << std::setw(10)
+              << reference_ns << std::setw(10) << inline_ns << std::setw(9)
+              << reference_ns / inline_ns << "x\n";
+}
+
+int main() {
+    using ReferenceVector3 = reference::Vector3;
+    using ReferenceColor = reference::Color;
+    using InlineVector3 = ray_tracing::BasicVector3<float>;
+    using InlineColor = ray_tracing::BasicColor<double>;
+
+    auto reference_inputs{make_inputs<ReferenceVector3>()};
+    auto inline_inputs{make_inputs<InlineVector3>()};
+
+    std::cout << "Nanoseconds per element, out-of-line (before) and inline "
+                 "(after):\n";
+    double sink{0};
+    compare(
+            "sphere_hit",
+            [&] { return sphere_hit(reference_inputs); },
+            [&] { return sphere_hit(inline_inputs); },
+            sink);
+    compare(
+            "camera_ray",
+            [&] { return camera_ray(reference_inputs); },
+            [&] { return camera_ray(inline_inputs); },
+            sink);
+    compare(
+            "reflect_refract",
+            [&] { return reflect_refract(reference_inputs); },
+            [&] { return reflect_refract(inline_inputs); },
+            sink);
+    compare(
+            "cross_normalize",
+            [&] { return cross_normalize(reference_inputs); },
+            [&] { return cross_normalize(inline_inputs); },
+            sink);
+    compare(
+            "color_mix",
+            [&] {
+                return color_mix<ReferenceVector3, ReferenceColor>(
+                        reference_inputs);
+            },
+            [&] {
+                return color_mix<InlineVector3, InlineColor>(inline_inputs);
+            },
+            sink);
+
+    if (std::isnan(sink)) {
+        std::cerr << "Unexpected result.\n";
+    }
+    return 0;
+}
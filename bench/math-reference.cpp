@@ -0,0 +1,206 @@
+#include "math-reference.h"
+
+#include <cmath>
+
+namespace reference {
+
+Vector3::Vector3(ValueType x, ValueType y, ValueType z) : x{x}, y{y}, z{z} {}
+
+Vector3::ValueType Vector3::dot(const Vector3& lhs, const Vector3& rhs) {
+    return lhs.x * rhs.x + lhs.y * rhs.y + lhs.z * rhs.z;
+}
+
+Vector3 Vector3::cross(const Vector3& lhs, const Vector3& rhs) {
+    return Vector3{lhs.y * rhs.z - lhs.z * rhs.y,
+                   lhs.z * rhs.x - lhs.x * rhs.z,
+                   lhs.x * rhs.y - lhs.y * rhs.x};
+}
+
+Vector3::ValueType Vector3::magnitude_sqaured() const {
+    return x * x + y * y + z * z;
+}
+
+Vector3::ValueType Vector3::magnitude() const {
+    return std::sqrt(magnitude_sqaured());
+}
+
+Vector3 Vector3::normalized() const {
+    return *this / magnitude();
+}
+
+Vector3::ValueType Vector3::operator[](int axis) const {
+    return axis == 0 ? x : axis == 1 ? y : z;
+}
+
+Vector3 operator-(const Vector3& vec) {
+    return Vector3{-vec.x, -vec.y, -vec.z};
+}
+
+Vector3 operator+(const Vector3& lhs, const Vector3& rhs) {
+    return Vector3{lhs.x + rhs.x, lhs.y + rhs.y, lhs.z + rhs.z};
+}
+
+Vector3 operator-(const Vector3& lhs, const Vector3& rhs) {
+    return lhs + -rhs;
+}
+
+Vector3 operator*(Vector3::ValueType lhs, const Vector3& rhs) {
+    return Vector3{lhs * rhs.x, lhs * rhs.y, lhs * rhs.z};
+}
+
+Vector3 operator*(const Vector3& lhs, Vector3::ValueType rhs) {
+    return rhs * lhs;
+}
+
+Vector3 operator/(const Vector3& lhs, Vector3::ValueType rhs) {
+    return (1 / rhs) * lhs;
+}
+
+Vector3& operator+=(Vector3& lhs, const Vector3& rhs) {
+    lhs.x += rhs.x;
+    lhs.y += rhs.y;
+    lhs.z += rhs.z;
+    return lhs;
+}
+
+Vector3& operator-=(Vector3& lhs, const Vector3& rhs) {
+    lhs += -rhs;
+    return lhs;
+}
+
+Vector3& operator*=(Vector3& lhs, Vector3::ValueType rhs) {
+    lhs.x *= rhs;
+    lhs.y *= rhs;
+    lhs.z *= rhs;
+    return lhs;
+}
+
+Vector3& operator/=(Vector3& lhs, Vector3::ValueType rhs) {
+    lhs *= (1 / rhs);
+    return lhs;
+}
+
+const Vector3 Vector3::zero{0, 0, 0};
+
+const Vector3 Vector3::one{1, 1, 1};
+
+const Vector3 Vector3::up{0, 1, 0};
+
+const Vector3 Vector3::down{0, -1, 0};
+
+const Vector3 Vector3::left{-1, 0, 0};
+
+const Vector3 Vector3::right{1, 0, 0};
+
+const Vector3 Vector3::forward{0, 0, 1};
+
+const Vector3 Vector3::back{0, 0, -1};
+
+Color::Color(ValueType r, ValueType g, ValueType b, ValueType a)
+    : r{std::fmax(0.0, std::fmin(1.0, r))},
+      g{std::fmax(0.0, std::fmin(1.0, g))},
+      b{std::fmax(0.0, std::fmin(1.0, b))},
+      a{std::fmax(0.0, std::fmin(1.0, a))} {}
+
+Color Color::lerp_unclamped(const Color& c0, const Color& c1, ValueType t) {
+    return (1 - t) * c0 + t * c1;
+}
+
+Color Color::lerp(const Color& c0, const Color& c1, ValueType t) {
+    return lerp_unclamped(c0, c1, std::fmax(0.0, std::fmin(1.0, t)));
+}
+
+Color Color::gamma() const {
+    constexpr auto gamma{1.0f / 2.2f};
+    return Color{std::pow(r, gamma),
+                 std::pow(g, gamma),
+                 std::pow(b, gamma),
+                 std::pow(a, gamma)};
+}
+
+Color operator-(const Color& color) {
+    return Color{-color.r, -color.g, -color.b, -color.a};
+}
+
+Color operator+(const Color& lhs, const Color& rhs) {
+    return Color{lhs.r + rhs.r, lhs.g + rhs.g, lhs.b + rhs.b, lhs.a + rhs.a};
+}
+
+Color operator-(const Color& lhs, const Color& rhs) {
+    return lhs + -rhs;
+}
+
+Color operator*(Color::ValueType lhs, const Color& rhs) {
+    return Color{lhs * rhs.r, lhs * rhs.g, lhs * rhs.b, lhs * rhs.a};
+}
+
+Color operator*(const Color& lhs, Color::ValueType rhs) {
+    return rhs * lhs;
+}
+
+Color operator/(const Color& lhs, Color::ValueType rhs) {
+    return (1 / rhs) * lhs;
+}
+
+Color& operator+=(Color& lhs, const Color& rhs) {
+    lhs.r += rhs.r;
+    lhs.g += rhs.g;
+    lhs.b += rhs.b;
+    lhs.a += rhs.a;
+    return lhs;
+}
+
+Color& operator-=(Color& lhs, const Color& rhs) {
+    lhs += -rhs;
+    return lhs;
+}
+
+Color& operator*=(Color& lhs, Color::ValueType rhs) {
+    lhs.r *= rhs;
+    lhs.g *= rhs;
+    lhs.b *= rhs;
+    lhs.a *= rhs;
+    return lhs;
+}
+
+Color& operator/=(Color& lhs, Color::ValueType rhs) {
+    lhs *= (1 / rhs);
+    return lhs;
+}
+
+const Color Color::clear{0, 0, 0, 0};
+
+const Color Color::black{0, 0, 0, 1};
+
+const Color Color::white{1, 1, 1, 1};
+
+const Color Color::gray{0.5, 0.5, 0.5, 1};
+
+const Color Color::red{1, 0, 0, 1};
+
+const Color Color::green{0, 1, 0, 1};
+
+const Color Color::blue{0, 0, 1, 1};
+
+const Color Color::cyan{0, 1, 1, 1};
+
+const Color Color::magenta{1, 0, 1, 1};
+
+const Color Color::yellow{1, 1, 0, 1};
+
+Vector3 reflect(const Vector3& v, const Vector3& n) {
+    return v - 2 * Vector3::dot(v, n) * n;
+}
+
+Vector3 refract(const Vector3& v,
+                const Vector3& n,
+                Vector3::ValueType refraction_ratio) {
+    auto uv{v.normalized()};
+    auto cos_theta{std::fmin(Vector3::dot(-uv, n), 1)};
+    auto r_out_perp{refraction_ratio * (uv + cos_theta * n)};
+    auto r_out_parallel{
+            -std::sqrt(std::fabs(1 - r_out_perp.magnitude_sqaured())) * n};
+    return r_out_perp + r_out_parallel;
+}
+
+}
@@ -0,0 +1,141 @@
+#ifndef MATH_REFERENCE_H
+#define MATH_REFERENCE_H
+
+// The Vector3 and Color of before the math became header-inline, kept for
+// `math_bench` to compare against. Everything is defined out of line in
+// math-reference.cpp, as it was then.
+namespace reference {
+
+struct Vector3 {
+    using ValueType = float;
+
+    Vector3() = default;
+
+    Vector3(ValueType x, ValueType y, ValueType z);
+
+    static ValueType dot(const Vector3& lhs, const Vector3& rhs);
+
+    static Vector3 cross(const Vector3& lhs, const Vector3& rhs);
+
+    ValueType magnitude_sqaured() const;
+
+    ValueType magnitude() const;
+
+    Vector3 normalized() const;
+
+    ValueType operator[](int axis) const;
+
+    static const Vector3 zero;
+
+    static const Vector3 one;
+
+    static const Vector3 up;
+
+    static const Vector3 down;
+
+    static const Vector3 left;
+
+    static const Vector3 right;
+
+    static const Vector3 forward;
+
+    static const Vector3 back;
+
+    ValueType x;
+
+    ValueType y;
+
+    ValueType z;
+};
+
+Vector3 operator-(const Vector3& vec);
+
+Vector3 operator+(const Vector3& lhs, const Vector3& rhs);
+
+Vector3 operator-(const Vector3& lhs, const Vector3& rhs);
+
+Vector3 operator*(Vector3::ValueType lhs, const Vector3& rhs);
+
+Vector3 operator*(const Vector3& lhs, Vector3::ValueType rhs);
+
+Vector3 operator/(const Vector3& lhs, Vector3::ValueType rhs);
+
+Vector3& operator+=(Vector3& lhs, const Vector3& rhs);
+
+Vector3& operator-=(Vector3& lhs, const Vector3& rhs);
+
+Vector3& operator*=(Vector3& lhs, Vector3::ValueType rhs);
+
+Vector3& operator/=(Vector3& lhs, Vector3::ValueType rhs);
+
+struct Color {
+    using ValueType = double;
+
+    Color() = default;
+
+    Color(ValueType r, ValueType g, ValueType b, ValueType a);
+
+    static Color lerp_unclamped(const Color& c0, const Color& c1, ValueType t);
+
+    static Color lerp(const Color& c0, const Color& c1, ValueType t);
+
+    Color gamma() const;
+
+    static const Color clear;
+
+    static const Color black;
+
+    static const Color white;
+
+    static const Color gray;
+
+    static const Color red;
+
+    static const Color green;
+
+    static const Color blue;
+
+    static const Color cyan;
+
+    static const Color magenta;
+
+    static const Color yellow;
+
+    ValueType r;
+
+    ValueType g;
+
+    ValueType b;
+
+    ValueType a;
+};
+
+Color operator-(const Color& color);
+
+Color operator+(const Color& lhs, const Color& rhs);
+
+Color operator-(const Color& lhs, const Color& rhs);
+
+Color operator*(Color::ValueType lhs, const Color& rhs);
+
+Color operator*(const Color& lhs, Color::ValueType rhs);
+
+Color operator/(const Color& lhs, Color::ValueType rhs);
+
+Color& operator+=(Color& lhs, const Color& rhs);
+
+Color& operator-=(Color& lhs, const Color& rhs);
+
+Color& operator*=(Color& lhs, Color::ValueType rhs);
+
+Color& operator/=(Color& lhs, Color::ValueType rhs);
+
+Vector3 reflect(const Vector3& v, const Vector3& n);
+
+Vector3 refract(const Vector3& v,
+                const Vector3& n,
+                Vector3::ValueType refraction_ratio);
+
+}
+
+#endif
@@ -0,0 +1,690 @@
+// A suite of benchmarks for tracking the performance of the renderer across
+// commits, from the innermost kernels to whole renders: random numbers,
+// camera rays, ray-sphere intersection, traversal of a plain list against
+// the accelerated structures, building and refitting the BVH over moving
+// instances, material scattering, and the rays per second of the built-in
+// scenes at several image sizes.
+//
+// Each benchmark is run for long enough to be timed reliably, a few times
+// over, and the fastest round is reported. The results go to standard
+// output as JSON and to standard error as a table. Given the JSON of an
+// earlier run with `--baseline`, the table compares against it, and the
+// exit status is 1 if any benchmark got slower by more than `--tolerance`,
+// 0.1 by default.
+//
+// Usage: trace_bench [--filter <text>] [--threads <n>] [--quick]
+//                    [--baseline <file.json>] [--tolerance <fraction>]
+
+#include "bvh.h"
+#include "camera.h"
+#include "film.h"
+#include "hittable-list.h"
+#include "hittable.h"
+#include "material.h"
+#include "radiance.h"
+#include "random-generator.h"
+#include "ray-packet.h"
+#include "ray.h"
+#include "renderer.h"
+#include "sampler.h"
+#include "scene.h"
+#include "sphere-set.h"
+#include "sphere.h"
+#include "thread-pool.h"
+#include "top-level-bvh.h"
+#include "transform.h"
+#include "triangle-mesh.h"
+#include "utils.h"
+#include "vector3.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <map>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+
+using namespace ray_tracing;
+
+// The inputs of the kernels are drawn up front and cycled through.
+static constexpr std::size_t num_inputs{1 << 12};
+
+static constexpr double seconds_per_round{0.1};
+
+static constexpr double quick_seconds_per_round{0.02};
+
+static constexpr std::size_t num_rounds{5};
+
+static constexpr std::size_t quick_num_rounds{2};
+
+static const std::size_t num_spheres_list[]{16, 256, 4096};
+
+static const std::size_t num_instances_list[]{1024, 16384, 131072};
+
+struct RenderSize {
+    std::size_t image_width;
+
+    std::size_t image_height;
+};
+
+static const RenderSize render_sizes[]{{160, 90}, {320, 180}, {640, 360}};
+
+static constexpr std::size_t render_samples_per_pixel{4};
+
+static constexpr std::size_t render_max_depth{50};
+
+struct BenchSettings {
+    const char* filter{nullptr};
+
+    std::size_t num_threads{0};
+
+    bool quick{false};
+
+    const char* baseline_filename{nullptr};
+
+    double tolerance{0.1};
+};
+
+struct Result {
+    std::string name;
+
+    // What one operation is, such as a ray.
+    const char* unit;
+
+    // The number of operations timed in each round.
+    std::uint64_t num_operations;
+
+    double ns_per_operation;
+};
+
+class Bench {
+public:
+    Bench(const BenchSettings& settings) : settings{settings} {}
+
+    bool enabled(const std::string& name) const {
+        return !settings.filter
+               || name.find(settings.filter) != std::string::npos;
+    }
+
+    // Times `kernel(num_iterations)`, which performs `operations_per_call`
+    // operations per iteration and returns a checksum of its results so
+    // that none of the work can be optimized away.
+    template <typename Kernel>
+    void measure(const std::string& name,
+                 const char* unit,
+                 double operations_per_call,
+                 const Kernel& kernel) {
+        if (!enabled(name)) {
+            return;
+        }
+
+        auto seconds{settings.quick ? quick_seconds_per_round
+                                    : seconds_per_round};
+        auto rounds{settings.quick ? quick_num_rounds : num_rounds};
+
+        // Doubles the number of iterations until a round takes long enough,
+        // which also warms up the caches.
+        std::uint64_t num_iterations{1};
+        auto elapsed{time(kernel, num_iterations)};
+        while (elapsed < seconds) {
+            num_iterations *= 2;
+            elapsed = time(kernel, num_iterations);
+        }
+
+        auto best{elapsed};
+        for (auto round{decltype(rounds){1}}; round < rounds; ++round) {
+            best = std::min(best, time(kernel, num_iterations));
+        }
+
+        auto num_operations{num_iterations * operations_per_call};
+        results.emplace_back(
+                Result{name,
+                       unit,
+                       static_cast<std::uint64_t>(num_operations),
+                       1e9 * best / num_operations});
+        std::cerr << std::left << std::setw(32) << name << std::right
+                  << std::fixed << std::setprecision(2) << std::setw(12)
+                  << results.back().ns_per_operation << " ns/" << unit
+                  << '\n';
+    }
+
+    const std::vector<Result>& all_results() const {
+        return results;
+    }
+
+    double checksum() const {
+        return sink;
+    }
+
+private:
+    template <typename Kernel>
+    double time(const Kernel& kernel, std::uint64_t num_iterations) {
+        auto start{std::chrono::steady_clock::now()};
+        sink += kernel(num_iterations);
+        std::chrono::duration<double> elapsed{
+                std::chrono::steady_clock::now() - start};
+        return elapsed.count();
+    }
+
+    const BenchSettings& settings;
+
+    std::vector<Result> results;
+
+    double sink{0};
+};
+
+// Counts the rays traced through the wrapped hittable, to turn the time of
+// a render into rays per second.
+class CountingHittable : public Hittable {
+public:
+    CountingHittable(const Hittable& hittable) : hittable{hittable} {}
+
+    bool hit(const Ray& ray,
+             HitInfo& hit_info,
+             Vector3::ValueType min_distance,
+             Vector3::ValueType max_distance) const override {
+        num_rays.fetch_add(1, std::memory_order_relaxed);
+        return hittable.hit(ray, hit_info, min_distance, max_distance);
+    }
+
+    void hit_packet(const RayPacket& packet,
+                    HitInfo* hit_infos,
+                    bool* hits) const override {
+        num_rays.fetch_add(packet.size, std::memory_order_relaxed);
+        hittable.hit_packet(packet, hit_infos, hits);
+    }
+
+    BoundingBox bounding_box() const override {
+        return hittable.bounding_box();
+    }
+
+    std::uint64_t count() const {
+        return num_rays;
+    }
+
+private:
+    const Hittable& hittable;
+
+    mutable std::atomic<std::uint64_t> num_rays{0};
+};
+
+static bool parse_arguments(int argc, char* argv[], BenchSettings& settings) {
+    for (auto i{1}; i < argc; ++i) {
+        auto has_value{i + 1 < argc};
+        if (std::strcmp(argv[i], "--quick") == 0) {
+            settings.quick = true;
+        } else if (std::strcmp(argv[i], "--filter") == 0 && has_value) {
+            settings.filter = argv[++i];
+        } else if (std::strcmp(argv[i], "--threads") == 0 && has_value) {
+            settings.num_threads = std::strtoull(argv[++i], nullptr, 10);
+            if (settings.num_threads == 0) {
+                return false;
+            }
+        } else if (std::strcmp(argv[i], "--baseline") == 0 && has_value) {
+            settings.baseline_filename = argv[++i];
+        } else if (std::strcmp(argv[i], "--tolerance") == 0 && has_value) {
+            char* end;
+            settings.tolerance = std::strtod(argv[++i], &end);
+            if (*end != '\0' || !(settings.tolerance >= 0)) {
+                return false;
+            }
+        } else {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Reads the nanoseconds per operation of each benchmark from the JSON this
+// program writes, which has one benchmark per line.
+static bool read_baseline(const char* filename,
+                          std::map<std::string, double>& baseline) {
+    std::ifstream file{filename};
+    if (!file) {
+        std::cerr << "Could not open baseline file '" << filename << "'.\n";
+        return false;
+    }
+    const std::string name_key{"\"name\": \""};
+    const std::string ns_key{"\"ns_per_op\": "};
+    std::string line;
+    while (std::getline(file, line)) {
+        auto name_position{line.find(name_key)};
+        auto ns_position{line.find(ns_key)};
+        if (name_position == std::string::npos
+            || ns_position == std::string::npos) {
+            continue;
+        }
+        name_position += name_key.size();
+        auto name_end{line.find('"', name_position)};
+        baseline[line.substr(name_position, name_end - name_position)]
+                = std::strtod(line.c_str() + ns_position + ns_key.size(),
+                              nullptr);
+    }
+    if (baseline.empty()) {
+        std::cerr << "No benchmarks in baseline file '" << filename << "'.\n";
+        return false;
+    }
+    return true;
+}
+
+static void write_json(const std::vector<Result>& results,
+                       const BenchSettings& settings,
+                       std::size_t num_threads) {
+#ifdef USE_SIMD
+    constexpr auto simd{"true"};
+#else
+    constexpr auto simd{"false"};
+#endif
+#ifdef __AVX2__
+    constexpr auto avx2{"true"};
+#else
+    constexpr auto avx2{"false"};
+#endif
+#ifdef USE_DOUBLE
+    constexpr auto double_precision{"true"};
+#else
+    constexpr auto double_precision{"false"};
+#endif
+    std::cout << "{\n  \"context\": {\"threads\": " << num_threads
+              << ", \"simd\": " << simd << ", \"avx2\": " << avx2
+              << ", \"double\": " << double_precision
+              << ", \"quick\": " << (settings.quick ? "true" : "false")
+              << "},\n  \"benchmarks\": [\n";
+    for (std::size_t i{0}; i < results.size(); ++i) {
+        const auto& result{results[i]};
+        std::cout << "    {\"name\": \"" << result.name << "\", \"unit\": \""
+                  << result.unit
+                  << "\", \"operations\": " << result.num_operations
+                  << std::setprecision(6) << std::defaultfloat
+                  << ", \"ns_per_op\": " << result.ns_per_operation
+                  << ", \"ops_per_second\": "
+                  << 1e9 / result.ns_per_operation << '}'
+                  << (i + 1 < results.size() ? ",\n" : "\n");
+    }
+    std::cout << "  ]\n}\n";
+}
+
+// Returns false if any benchmark in both got slower than `tolerance` allows.
+static bool compare(const std::vector<Result>& results,
+                    const std::map<std::string, double>& baseline,
+                    double tolerance) {
+    std::cerr << "\nAgainst the baseline, in time per operation:\n";
+    auto passed{true};
+    for (const auto& result : results) {
+        auto found{baseline.find(result.name)};
+        if (found == baseline.end()) {
+            continue;
+        }
+        auto ratio{result.ns_per_operation / found->second};
+        auto regressed{ratio > 1 + tolerance};
+        std::cerr << std::left << std::setw(32) << result.name << std::right
+                  << std::fixed << std::setprecision(3) << std::setw(10)
+                  << ratio << 'x' << (regressed ? "  slower" : "") << '\n';
+        passed = passed && !regressed;
+    }
+    return passed;
+}
+
+// Rays from a sphere around the scene towards random points inside it, so
+// that some hit and some miss.
+static std::vector<Ray> make_rays(RandomGenerator& generator) {
+    std::vector<Ray> rays;
+    for (std::size_t i{0}; i < num_inputs; ++i) {
+        auto origin{30 * random_unit_vector(generator)};
+        auto target{Vector3::random(generator, -10, 10)};
+        rays.emplace_back(origin, (target - origin).normalized());
+    }
+    return rays;
+}
+
+static void bench_random_numbers(Bench& bench) {
+    RandomGenerator generator{42};
+    bench.measure("rng/next_uint32", "number", 1, [&](auto n) {
+        std::uint32_t sum{0};
+        for (decltype(n) i{0}; i < n; ++i) {
+            sum += generator.next_uint32();
+        }
+        return static_cast<double>(sum);
+    });
+    bench.measure("rng/next_float", "number", 1, [&](auto n) {
+        double sum{0};
+        for (decltype(n) i{0}; i < n; ++i) {
+            sum += generator.next_float();
+        }
+        return sum;
+    });
+}
+
+static void bench_camera(Bench& bench, const Camera& camera) {
+    RandomGenerator generator{42};
+    std::vector<Vector3::ValueType> coordinates;
+    for (std::size_t i{0}; i < num_inputs; ++i) {
+        coordinates.emplace_back(random_float(generator));
+    }
+    bench.measure("camera/generate_ray", "ray", 1, [&](auto n) {
+        double sum{0};
+        for (decltype(n) i{0}; i < n; ++i) {
+            auto s{coordinates[i % num_inputs]};
+            auto t{coordinates[(i + 1) % num_inputs]};
+            SamplePoint lens_point{coordinates[(i + 2) % num_inputs],
+                                   coordinates[(i + 3) % num_inputs]};
+            sum += camera.generate_ray(s, t, lens_point).direction.z;
+        }
+        return sum;
+    });
+}
+
+// Called through `Hittable`, as the renderer does.
+static auto trace_rays(const Hittable& world, const std::vector<Ray>& rays) {
+    return [&](std::uint64_t n) {
+        double sum{0};
+        Hittable::HitInfo hit_info;
+        for (decltype(n) i{0}; i < n; ++i) {
+            if (world.hit(rays[i % num_inputs], hit_info)) {
+                sum += hit_info.distance;
+            }
+        }
+        return sum;
+    };
+}
+
+static void bench_intersection(Bench& bench) {
+    RandomGenerator generator{42};
+    auto rays{make_rays(generator)};
+
+    Sphere sphere{Vector3::zero, 5, 0};
+    bench.measure("sphere/hit", "ray", 1, trace_rays(sphere, rays));
+
+    std::vector<RayPacket> packets(num_inputs / RayPacket::max_size);
+    for (std::size_t i{0}; i < num_inputs; ++i) {
+        auto& packet{packets[i / RayPacket::max_size]};
+        packet.rays[packet.size++] = rays[i];
+    }
+
+    for (auto num_spheres : num_spheres_list) {
+        // Keeps the spheres filling about 5 % of the box, whatever their
+        // number.
+        auto radius{static_cast<Vector3::ValueType>(
+                std::cbrt(6000 * 0.05 / (pi * num_spheres)))};
+        HittableList list;
+        SphereSet sphere_set;
+        for (std::size_t i{0}; i < num_spheres; ++i) {
+            auto center{Vector3::random(generator, -10, 10)};
+            list.add(std::make_shared<Sphere>(center, radius, 0));
+            sphere_set.add(center, radius, 0);
+        }
+        Bvh bvh{list};
+        sphere_set.build();
+
+        auto suffix{'/' + std::to_string(num_spheres)};
+        bench.measure("traverse/list" + suffix,
+                      "ray",
+                      1,
+                      trace_rays(list, rays));
+        bench.measure("traverse/bvh" + suffix, "ray", 1, trace_rays(bvh, rays));
+        bench.measure("traverse/sphere_set" + suffix,
+                      "ray",
+                      1,
+                      trace_rays(sphere_set, rays));
+        bench.measure("traverse/sphere_set_packet" + suffix,
+                      "ray",
+                      RayPacket::max_size,
+                      [&](auto n) {
+                          double sum{0};
+                          Hittable::HitInfo hit_infos[RayPacket::max_size];
+                          bool hits[RayPacket::max_size];
+                          for (decltype(n) i{0}; i < n; ++i) {
+                              sphere_set.hit_packet(packets[i % packets.size()],
+                                                    hit_infos,
+                                                    hits);
+                              sum += hits[0] ? hit_infos[0].distance : 0;
+                          }
+                          return sum;
+                      });
+    }
+}
+
+// An octahedron, instanced all over the box the rays aim at.
+static std::shared_ptr<const TriangleMesh> make_octahedron() {
+    MeshData mesh;
+    mesh.positions = {Vector3{1, 0, 0},
+                      Vector3{-1, 0, 0},
+                      Vector3{0, 1, 0},
+                      Vector3{0, -1, 0},
+                      Vector3{0, 0, 1},
+                      Vector3{0, 0, -1}};
+    mesh.indices = {0, 2, 4, 2, 1, 4, 1, 3, 4, 3, 0, 4,
+                    2, 0, 5, 1, 2, 5, 3, 1, 5, 0, 3, 5};
+    return std::make_shared<const TriangleMesh>(std::move(mesh), 0);
+}
+
+static Transform random_placement(RandomGenerator& generator,
+                                  Vector3::ValueType size) {
+    return Transform::translation(Vector3::random(generator, -10, 10))
+           * Transform::rotation(random_unit_vector(generator),
+                                 random_float(generator) * 2 * pi)
+           * Transform::scaling(Vector3{size, size, size});
+}
+
+static void bench_instances(Bench& bench, ThreadPool& pool) {
+    RandomGenerator generator{42};
+    auto rays{make_rays(generator)};
+    auto octahedron{make_octahedron()};
+
+    for (auto num_instances : num_instances_list) {
+        auto suffix{'/' + std::to_string(num_instances)};
+        if (!bench.enabled("tlas/build" + suffix)
+            && !bench.enabled("tlas/refit" + suffix)
+            && !bench.enabled("traverse/tlas" + suffix)) {
+            continue;
+        }
+
+        // Keeps the instances filling about the same part of the box,
+        // whatever their number.
+        auto size{static_cast<Vector3::ValueType>(
+                std::cbrt(6000 * 0.05 / num_instances))};
+        TopLevelBvh instances;
+        std::vector<Transform> placements;
+        for (std::size_t i{0}; i < num_instances; ++i) {
+            placements.emplace_back(random_placement(generator, size));
+            instances.add(octahedron, placements.back());
+        }
+
+        bench.measure("tlas/build" + suffix,
+                      "instance",
+                      num_instances,
+                      [&](auto n) {
+                          for (decltype(n) i{0}; i < n; ++i) {
+                              instances.build(pool);
+                          }
+                          return static_cast<double>(
+                                  instances.bounding_box().max.x);
+                      });
+        instances.build(pool);
+        bench.measure("traverse/tlas" + suffix,
+                      "ray",
+                      1,
+                      trace_rays(instances, rays));
+
+        // As from one frame of an animation to the next, every instance
+        // moves by up to its size.
+        for (std::size_t i{0}; i < num_instances; ++i) {
+            instances.set_transform(
+                    i,
+                    Transform::translation(
+                            Vector3::random(generator, -size, size))
+                            * placements[i]);
+        }
+        bench.measure("tlas/refit" + suffix,
+                      "instance",
+                      num_instances,
+                      [&](auto n) {
+                          for (decltype(n) i{0}; i < n; ++i) {
+                              instances.refit(pool);
+                          }
+                          return static_cast<double>(
+                                  instances.bounding_box().max.x);
+                      });
+    }
+}
+
+static void bench_materials(Bench& bench) {
+    RandomGenerator generator{42};
+    std::vector<Ray> incident_rays;
+    std::vector<Hittable::HitInfo> hit_infos;
+    for (std::size_t i{0}; i < num_inputs; ++i) {
+        auto normal{random_unit_vector(generator)};
+        auto direction{random_unit_vector(generator)};
+        if (Vector3::dot(direction, normal) > 0) {
+            direction = -direction;
+        }
+        auto point{Vector3::random(generator, -10, 10)};
+        incident_rays.emplace_back(point - direction, direction);
+        hit_infos.emplace_back(Hittable::HitInfo{point, normal, 1, 0, 0});
+    }
+
+    auto albedo{Radiance{0.7f, 0.6f, 0.5f}};
+    const std::pair<const char*, Material> materials[]{
+            {"scatter/lambertian", Lambertian{albedo}},
+            {"scatter/metal", Metal{albedo, 0.3f}},
+            {"scatter/dielectric", Dielectric{1.5f}}};
+    for (const auto& [name, material] : materials) {
+        bench.measure(name, "ray", 1, [&](auto n) {
+            double sum{0};
+            Ray scattered;
+            Radiance attenuation;
+            for (decltype(n) i{0}; i < n; ++i) {
+                auto index{i % num_inputs};
+                auto u{random_double(generator)};
+                auto v{random_double(generator)};
+                auto choice{random_double(generator)};
+                if (scatter(material,
+                            incident_rays[index],
+                            hit_infos[index],
+                            ScatterSample{{u, v}, choice},
+                            scattered,
+                            attenuation)) {
+                    sum += attenuation.r + scattered.direction.x;
+                }
+            }
+            return sum;
+        });
+    }
+}
+
+// The scene of the example in the README: three large spheres, one of each
+// material, on the ground.
+static void simple_scene(Scene& scene, ThreadPool& pool) {
+    using Type = Scene::MaterialRecord::Type;
+    auto ground{scene.add_material({Type::lambertian, 0, {0.5, 0.5, 0.5}})};
+    auto steel{scene.add_material({Type::metal, 0, {0.7, 0.6, 0.5, 0.1}})};
+    auto glass{scene.add_material({Type::dielectric, 0, {1.5}})};
+    scene.spheres.add(Vector3{0, -1000, 0}, 1000, ground);
+    scene.spheres.add(Vector3{0, 1, 0}, 1, glass);
+    scene.spheres.add(Vector3{4, 1, 0}, 1, steel);
+    scene.build(pool);
+}
+
+static void bench_render(Bench& bench,
+                         ThreadPool& pool,
+                         const char* scene_name,
+                         Scene& scene) {
+    for (const auto& size : render_sizes) {
+        auto name{std::string{"render/"} + scene_name + '/'
+                  + std::to_string(size.image_width) + 'x'
+                  + std::to_string(size.image_height)};
+        if (!bench.enabled(name)) {
+            continue;
+        }
+
+        scene.image_width = size.image_width;
+        scene.image_height = size.image_height;
+        auto camera{scene.camera()};
+        auto world{scene.world()};
+        RenderSettings settings{size.image_width,
+                                size.image_height,
+                                render_samples_per_pixel,
+                                render_max_depth,
+                                16,
+                                false,
+                                0};
+
+        // Every sample draws its random numbers from its own pixel and
+        // index, so each render traces exactly the rays counted here.
+        CountingHittable counter{world};
+        Film counting_film{size.image_width, size.image_height};
+        Renderer{camera, counter, scene.materials, scene.lights, settings}
+                .render(pool, 0, size.image_height, counting_film);
+
+        Renderer renderer{camera,
+                          world,
+                          scene.materials,
+                          scene.lights,
+                          settings};
+        bench.measure(name, "ray", counter.count(), [&](auto n) {
+            double sum{0};
+            for (decltype(n) i{0}; i < n; ++i) {
+                Film film{size.image_width, size.image_height};
+                renderer.render(pool, 0, size.image_height, film);
+                sum += film.pixels.front().r;
+            }
+            return sum;
+        });
+    }
+}
+
+int main(int argc, char* argv[]) {
+    BenchSettings settings;
+    if (!parse_arguments(argc, argv, settings)) {
+        std::cerr << "Usage: " << argv[0]
+                  << " [--filter <text>] [--threads <n>] [--quick]"
+                     " [--baseline <file.json>] [--tolerance <fraction>]\n";
+        return 1;
+    }
+
+    std::map<std::string, double> baseline;
+    if (settings.baseline_filename
+        && !read_baseline(settings.baseline_filename, baseline)) {
+        return 1;
+    }
+
+    auto num_threads{settings.num_threads ? settings.num_threads
+                                          : ThreadPool::default_size()};
+    ThreadPool pool{num_threads};
+
+    Scene random;
+    random_scene(random, pool);
+    Scene simple;
+    simple_scene(simple, pool);
+
+    Bench bench{settings};
+    bench_random_numbers(bench);
+    bench_camera(bench, random.camera());
+    bench_intersection(bench);
+    bench_instances(bench, pool);
+    bench_materials(bench);
+    bench_render(bench, pool, "random", random);
+    bench_render(bench, pool, "simple", simple);
+
+    if (std::isnan(bench.checksum())) {
+        std::cerr << "Unexpected result.\n";
+    }
+
+    write_json(bench.all_results(), settings, num_threads);
+    if (!baseline.empty()
+        && !compare(bench.all_results(), baseline, settings.tolerance)) {
+        return 1;
+    }
+    return 0;
+}
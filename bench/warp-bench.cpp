@@ -0,0 +1,285 @@
+// Checks that the warps turn uniform points of the unit square, or cube,
+// into the distributions they are meant to, and measures what they cost
+// against rejection sampling. The samplers need the warps, whatever they
+// cost, since a point taking a fixed count of numbers is what keeps their
+// stratification; the timings decide what the generator-driven helpers of
+// utils.h use, which only the benches call. Both sides draw floats, so that
+// they pay the same for each number.
+//
+// Each warp's points are binned by coordinates that the intended
+// distribution makes uniform, such as the square of the distance from the
+// center and the angle around it for the unit disk, and Pearson's
+// chi-square test compares the counts with the even ones expected. The
+// points come once from independent numbers and once from a pixel of the
+// Sobol sampler, which should give counts far more even than chance would.
+// The exit status is 1 if any test rejects its distribution, or any point
+// lands outside its domain.
+//
+// Usage: warp_bench [samples]
+
+#include "random-generator.h"
+#include "sampler.h"
+#include "utils.h"
+#include "vector3.h"
+#include "warp.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <string>
+#include <vector>
+
+#include <cstdlib>
+
+using namespace ray_tracing;
+
+// Tests whose p-value is below this reject the distribution.
+static constexpr double significance{1e-3};
+
+// How far from the domain a point may be from rounding.
+static constexpr double tolerance{1e-4};
+
+static constexpr std::size_t num_timed_samples{1 << 22};
+
+// Each warp is timed this many times, alternating with rejection sampling,
+// and the fastest run is reported.
+static constexpr std::size_t num_rounds{5};
+
+struct CubePoint {
+    double u;
+
+    double v;
+
+    double w;
+};
+
+// Returns the bin of the warped point, or -1 if it is outside the domain.
+using Binning = std::function<int(const CubePoint& point)>;
+
+struct WarpTest {
+    const char* name;
+
+    int num_bins;
+
+    Binning bin;
+};
+
+// The bin of `value`, in [0, 1], among `count` bins.
+static int bin_of(double value, int count) {
+    return std::clamp(static_cast<int>(value * count), 0, count - 1);
+}
+
+// The angle around the z axis, scaled to [0, 1].
+static double turn(const Vector3& point) {
+    return (std::atan2(point.y, point.x) + pi) / (2 * pi);
+}
+
+static std::vector<WarpTest> make_tests() {
+    constexpr int n{16};
+    std::vector<WarpTest> tests;
+    tests.push_back({"concentric_disk", n * n, [](const CubePoint& point) {
+        auto p{square_to_concentric_disk(point.u, point.v)};
+        auto radius_squared{p.x * p.x + p.y * p.y};
+        if (radius_squared > 1 + tolerance || p.z != 0) {
+            return -1;
+        }
+        return bin_of(radius_squared, n) * n + bin_of(turn(p), n);
+    }});
+    tests.push_back({"uniform_sphere", n * n, [](const CubePoint& point) {
+        auto p{square_to_uniform_sphere(point.u, point.v)};
+        if (std::abs(p.magnitude() - 1) > tolerance) {
+            return -1;
+        }
+        return bin_of((p.z + 1) / 2, n) * n + bin_of(turn(p), n);
+    }});
+    // Cosine-weighted directions project to uniform points of the disk.
+    tests.push_back({"cosine_hemisphere", n * n, [](const CubePoint& point) {
+        auto p{square_to_cosine_hemisphere(point.u, point.v)};
+        if (std::abs(p.magnitude() - 1) > tolerance || p.z < 0) {
+            return -1;
+        }
+        return bin_of(p.x * p.x + p.y * p.y, n) * n + bin_of(turn(p), n);
+    }});
+    // The cube of the distance from the center is uniform in the ball.
+    tests.push_back({"uniform_ball", 8 * 8 * 8, [](const CubePoint& point) {
+        auto p{cube_to_uniform_ball(point.u, point.v, point.w)};
+        auto radius{p.magnitude()};
+        if (radius > 1 + tolerance) {
+            return -1;
+        }
+        auto height{radius > 0 ? p.z / radius : 0};
+        return (bin_of(radius * radius * radius, 8) * 8
+                + bin_of((height + 1) / 2, 8))
+                       * 8
+               + bin_of(turn(p), 8);
+    }});
+    // The sum of the weights is distributed like the distance from a
+    // corner of a triangle, and the share of the third corner is uniform
+    // given it.
+    tests.push_back({"triangle", n * n, [](const CubePoint& point) {
+        Vector3::ValueType weight1;
+        Vector3::ValueType weight2;
+        square_to_triangle(point.u, point.v, weight1, weight2);
+        auto sum{weight1 + weight2};
+        if (weight1 < 0 || weight2 < 0 || sum > 1 + tolerance) {
+            return -1;
+        }
+        auto share{sum > 0 ? weight2 / sum : 0};
+        return bin_of(sum * sum, n) * n + bin_of(share, n);
+    }});
+    return tests;
+}
+
+// The probability that a chi-square variable with `dof` degrees of freedom
+// is at least `statistic`, by the Wilson-Hilferty approximation, which is
+// close for the hundreds of bins used here.
+static double chi_square_p_value(double statistic, double dof) {
+    auto mean{1 - 2 / (9 * dof)};
+    auto deviation{std::sqrt(2 / (9 * dof))};
+    auto z{(std::cbrt(statistic / dof) - mean) / deviation};
+    return 0.5 * std::erfc(z / std::sqrt(2.0));
+}
+
+// Runs `test` on `num_samples` points from `next_point` and prints the
+// result. Returns whether the distribution passed.
+template <typename NextPoint>
+static bool run_test(const WarpTest& test,
+                     const char* source,
+                     std::size_t num_samples,
+                     NextPoint&& next_point) {
+    std::vector<std::size_t> counts(test.num_bins);
+    std::size_t num_outside{0};
+    for (std::size_t i{0}; i < num_samples; ++i) {
+        auto bin{test.bin(next_point(i))};
+        if (bin < 0) {
+            ++num_outside;
+        } else {
+            ++counts[bin];
+        }
+    }
+
+    auto expected{static_cast<double>(num_samples) / test.num_bins};
+    double statistic{0};
+    for (auto count : counts) {
+        auto difference{count - expected};
+        statistic += difference * difference / expected;
+    }
+    auto dof{static_cast<double>(test.num_bins - 1)};
+    auto p_value{chi_square_p_value(statistic, dof)};
+    auto passed{num_outside == 0 && p_value >= significance};
+
+    std::cout << std::left << std::setw(20) << test.name << std::setw(14)
+              << source << std::right << std::fixed << std::setprecision(1)
+              << std::setw(12) << statistic << std::setw(8)
+              << test.num_bins - 1 << std::setprecision(4) << std::setw(10)
+              << p_value << std::setw(10) << num_outside
+              << (passed ? "" : "  failed") << '\n';
+    return passed;
+}
+
+// Runs `sample(generator)` `num_timed_samples` times and returns the time
+// per sample, in nanoseconds.
+template <typename Sample>
+static double time_per_sample(Sample&& sample, double& sink) {
+    RandomGenerator generator{42};
+    auto start{std::chrono::steady_clock::now()};
+    double sum{0};
+    for (std::size_t i{0}; i < num_timed_samples; ++i) {
+        sum += sample(generator).x;
+    }
+    std::chrono::duration<double, std::nano> elapsed{
+            std::chrono::steady_clock::now() - start};
+    sink += sum;
+    return elapsed.count() / num_timed_samples;
+}
+
+template <typename Rejection, typename Warp>
+static void time_warp(const char* name,
+                      Rejection&& rejection,
+                      Warp&& warp,
+                      double& sink) {
+    auto rejection_ns{std::numeric_limits<double>::infinity()};
+    auto warp_ns{std::numeric_limits<double>::infinity()};
+    for (std::size_t round{0}; round < num_rounds; ++round) {
+        rejection_ns = std::min(rejection_ns, time_per_sample(rejection, sink));
+        warp_ns = std::min(warp_ns, time_per_sample(warp, sink));
+    }
+    std::cout << std::left << std::setw(20) << name << std::right
+              << std::fixed << std::setprecision(2) << std::setw(12)
+              << rejection_ns << std::setw(12) << warp_ns << '\n';
+}
+
+int main(int argc, char* argv[]) {
+    std::size_t num_samples{1 << 20};
+    if (argc > 2 || (argc == 2 && !(num_samples = std::atol(argv[1])))) {
+        std::cerr << "Usage: " << argv[0] << " [samples]\n";
+        return 1;
+    }
+
+    std::cout << std::left << std::setw(20) << "warp" << std::setw(14)
+              << "source" << std::right << std::setw(12) << "chi-square"
+              << std::setw(8) << "dof" << std::setw(10) << "p-value"
+              << std::setw(10) << "outside" << '\n';
+    auto passed{true};
+    Sampler sampler{SamplerType::sobol, 1, num_samples};
+    for (const auto& test : make_tests()) {
+        RandomGenerator generator{42};
+        passed &= run_test(test, "independent", num_samples, [&](auto) {
+            auto u{random_double(generator)};
+            auto v{random_double(generator)};
+            auto w{random_double(generator)};
+            return CubePoint{u, v, w};
+        });
+        passed &= run_test(test, "sobol", num_samples, [&](auto i) {
+            auto stream{sampler.start(0, 0, i)};
+            auto [u, v]{stream.next_2d()};
+            auto w{stream.next_1d()};
+            return CubePoint{u, v, w};
+        });
+    }
+
+    std::cout << "\nNanoseconds per sample, with the numbers drawn:\n"
+              << std::left << std::setw(20) << "warp" << std::right
+              << std::setw(12) << "rejection" << std::setw(12) << "warp"
+              << '\n';
+    double sink{0};
+    time_warp(
+            "disk",
+            random_vector_in_unit_disk,
+            [](auto& generator) {
+                auto u{random_float(generator)};
+                auto v{random_float(generator)};
+                return square_to_concentric_disk(u, v);
+            },
+            sink);
+    time_warp(
+            "ball",
+            random_vector_in_unit_sphere,
+            [](auto& generator) {
+                auto u{random_float(generator)};
+                auto v{random_float(generator)};
+                auto w{random_float(generator)};
+                return cube_to_uniform_ball(u, v, w);
+            },
+            sink);
+    time_warp(
+            "sphere",
+            [](auto& generator) {
+                return random_vector_in_unit_sphere(generator).normalized();
+            },
+            random_unit_vector,
+            sink);
+    if (std::isnan(sink)) {
+        std::cerr << "Unexpected result.\n";
+    }
+
+    if (!passed) {
+        std::cerr << "Some warps do not give their distribution.\n";
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,61 @@
+#include "alias-table.h"
+
+#include <algorithm>
+#include <numeric>
+
+namespace ray_tracing {
+
+AliasTable::AliasTable(const std::vector<double>& weights)
+    : slots(weights.size()), probabilities(weights.size()) {
+    auto total{std::accumulate(weights.begin(), weights.end(), 0.0)};
+    auto num_slots{static_cast<double>(weights.size())};
+
+    // Scaled so that a full slot is 1, and split by whether they fill
+    // their own slot.
+    std::vector<double> scaled(weights.size());
+    std::vector<std::uint32_t> small;
+    std::vector<std::uint32_t> large;
+    for (std::uint32_t i{0}; i < weights.size(); ++i) {
+        probabilities[i] = weights[i] / total;
+        scaled[i] = probabilities[i] * num_slots;
+        (scaled[i] < 1 ? small : large).emplace_back(i);
+    }
+
+    // Each slot that is too small is topped up from one that is too large.
+    while (!small.empty() && !large.empty()) {
+        auto less{small.back()};
+        auto more{large.back()};
+        small.pop_back();
+        slots[less] = Slot{scaled[less], more};
+        scaled[more] -= 1 - scaled[less];
+        if (scaled[more] < 1) {
+            large.pop_back();
+            small.emplace_back(more);
+        }
+    }
+
+    // Whatever is left is full, up to rounding.
+    for (auto i : large) {
+        slots[i] = Slot{1, i};
+    }
+    for (auto i : small) {
+        slots[i] = Slot{1, i};
+    }
+}
+
+std::size_t AliasTable::size() const {
+    return slots.size();
+}
+
+std::size_t AliasTable::sample(double u) const {
+    auto position{u * slots.size()};
+    auto index{std::min(static_cast<std::size_t>(position), slots.size() - 1)};
+    const auto& slot{slots[index]};
+    return position - index < slot.threshold ? index : slot.alias;
+}
+
+double AliasTable::probability(std::size_t index) const {
+    return probabilities[index];
+}
+
+}
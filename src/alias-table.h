@@ -0,0 +1,43 @@
+#ifndef ALIAS_TABLE_H
+#define ALIAS_TABLE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace ray_tracing {
+
+// Draws indices in proportion to their weights in constant time, however
+// many there are, with Vose's alias method: every index owns an equal slot
+// that it shares with at most one other index, its alias, which takes the
+// part of the slot beyond the index's own weight.
+class AliasTable {
+public:
+    AliasTable() = default;
+
+    // The weights must not be negative, and at least one must be positive.
+    explicit AliasTable(const std::vector<double>& weights);
+
+    std::size_t size() const;
+
+    // Picks an index with one uniform number in [0, 1).
+    std::size_t sample(double u) const;
+
+    double probability(std::size_t index) const;
+
+private:
+    struct Slot {
+        // The part of the slot that belongs to its own index.
+        double threshold;
+
+        std::uint32_t alias;
+    };
+
+    std::vector<Slot> slots;
+
+    std::vector<double> probabilities;
+};
+
+}
+
+#endif
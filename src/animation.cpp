@@ -0,0 +1,122 @@
+#include "animation.h"
+
+#include "utils.h"
+
+#include <algorithm>
+
+namespace ray_tracing {
+
+Transform compose(const std::vector<TransformStep>& steps) {
+    Transform transform;
+    for (const auto& step : steps) {
+        switch (step.type) {
+        case TransformStep::Type::translate:
+            transform = Transform::translation(step.vector) * transform;
+            break;
+        case TransformStep::Type::rotate:
+            transform = Transform::rotation(step.vector,
+                                            degrees_to_radians(step.degrees))
+                        * transform;
+            break;
+        case TransformStep::Type::scale:
+            transform = Transform::scaling(step.vector) * transform;
+            break;
+        }
+    }
+    return transform;
+}
+
+// Finds the keys before and after `frame`, and how far along from one to
+// the other it is. Returns the index of the first.
+template <typename Key>
+static std::size_t find_segment(const std::vector<Key>& keys,
+                                double frame,
+                                double& t) {
+    auto next{std::upper_bound(keys.begin(),
+                               keys.end(),
+                               frame,
+                               [](auto frame, const auto& key) {
+                                   return frame < key.frame;
+                               })};
+    if (next == keys.begin()) {
+        t = 0;
+        return 0;
+    }
+    if (next == keys.end()) {
+        t = 1;
+        return keys.size() - (keys.size() > 1 ? 2 : 1);
+    }
+    t = (frame - (next - 1)->frame) / (next->frame - (next - 1)->frame);
+    return static_cast<std::size_t>(next - keys.begin()) - 1;
+}
+
+// The velocity at key `i` over a segment of `duration` frames, from the
+// keys on either side.
+static Vector3 tangent(const std::vector<CameraKey>& keys,
+                       std::size_t i,
+                       double duration,
+                       Vector3 CameraKey::*position) {
+    auto previous{i > 0 ? i - 1 : i};
+    auto next{i + 1 < keys.size() ? i + 1 : i};
+    if (previous == next) {
+        return Vector3::zero;
+    }
+    auto scale{duration / (keys[next].frame - keys[previous].frame)};
+    return static_cast<Vector3::ValueType>(scale)
+           * (keys[next].*position - keys[previous].*position);
+}
+
+static Vector3 hermite(const std::vector<CameraKey>& keys,
+                       std::size_t i,
+                       double t,
+                       Vector3 CameraKey::*position) {
+    if (i + 1 == keys.size()) {
+        return keys[i].*position;
+    }
+    auto duration{keys[i + 1].frame - keys[i].frame};
+    auto m0{tangent(keys, i, duration, position)};
+    auto m1{tangent(keys, i + 1, duration, position)};
+    auto t2{t * t};
+    auto t3{t2 * t};
+    auto h00{static_cast<Vector3::ValueType>(2 * t3 - 3 * t2 + 1)};
+    auto h10{static_cast<Vector3::ValueType>(t3 - 2 * t2 + t)};
+    auto h01{static_cast<Vector3::ValueType>(-2 * t3 + 3 * t2)};
+    auto h11{static_cast<Vector3::ValueType>(t3 - t2)};
+    return h00 * keys[i].*position + h10 * m0
+           + h01 * keys[i + 1].*position + h11 * m1;
+}
+
+void interpolate_camera(const std::vector<CameraKey>& keys,
+                        double frame,
+                        Vector3& lookfrom,
+                        Vector3& lookat) {
+    if (keys.empty()) {
+        return;
+    }
+    double t;
+    auto i{find_segment(keys, frame, t)};
+    lookfrom = hermite(keys, i, t, &CameraKey::lookfrom);
+    lookat = hermite(keys, i, t, &CameraKey::lookat);
+}
+
+Transform interpolate_transform(const std::vector<TransformKey>& keys,
+                                double frame) {
+    double t;
+    auto i{find_segment(keys, frame, t)};
+    if (i + 1 == keys.size()) {
+        return compose(keys[i].steps);
+    }
+
+    auto steps{keys[i].steps};
+    const auto& next_steps{keys[i + 1].steps};
+    auto weight{static_cast<Vector3::ValueType>(t)};
+    for (std::size_t j{0}; j < steps.size(); ++j) {
+        steps[j].vector = (1 - weight) * steps[j].vector
+                          + weight * next_steps[j].vector;
+        steps[j].degrees = (1 - weight) * steps[j].degrees
+                           + weight * next_steps[j].degrees;
+    }
+    return compose(steps);
+}
+
+}
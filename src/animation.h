@@ -0,0 +1,70 @@
+#ifndef ANIMATION_H
+#define ANIMATION_H
+
+#include "transform.h"
+#include "vector3.h"
+
+#include <cstddef>
+#include <vector>
+
+namespace ray_tracing {
+
+// One operation of a transform as written in a scene file, kept apart from
+// the others so that keyframes can be blended operation by operation.
+struct TransformStep {
+    enum class Type { translate, rotate, scale };
+
+    Type type;
+
+    // The offset, the rotation axis or the scale factors.
+    Vector3 vector;
+
+    // In degrees, for rotations only.
+    Vector3::ValueType degrees{0};
+};
+
+// Applies the steps in order.
+Transform compose(const std::vector<TransformStep>& steps);
+
+struct CameraKey {
+    double frame;
+
+    Vector3 lookfrom;
+
+    Vector3 lookat;
+};
+
+struct TransformKey {
+    double frame;
+
+    // The same types of step as every other key of the track, in the same
+    // order.
+    std::vector<TransformStep> steps;
+};
+
+// The motion of one instance of `Scene::instances`, by the index it was
+// added under.
+struct InstanceTrack {
+    std::size_t instance_index;
+
+    std::vector<TransformKey> keys;
+};
+
+// Interpolates the camera along a Catmull-Rom spline through the keys,
+// which must be sorted by frame, so that it passes every key without a
+// jolt in its speed. Before the first key and after the last, the camera
+// rests there.
+void interpolate_camera(const std::vector<CameraKey>& keys,
+                        double frame,
+                        Vector3& lookfrom,
+                        Vector3& lookat);
+
+// Blends the steps of the two keys around `frame` linearly, angles
+// included, so that a rotation of 360 degrees between two keys turns the
+// instance all the way round.
+Transform interpolate_transform(const std::vector<TransformKey>& keys,
+                                double frame);
+
+}
+
+#endif
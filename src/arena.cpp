@@ -0,0 +1,62 @@
+#include "arena.h"
+
+#include <utility>
+
+#include <cstdint>
+
+namespace ray_tracing {
+
+static std::size_t align_size(std::size_t size) {
+    return (size + Arena::alignment - 1) / Arena::alignment * Arena::alignment;
+}
+
+Arena::Arena(std::size_t block_size) : block_size{align_size(block_size)} {}
+
+Arena::Arena(Arena&& other) noexcept
+    : block_size{other.block_size},
+      blocks{std::exchange(other.blocks, {})},
+      cursor{std::exchange(other.cursor, nullptr)},
+      remaining{std::exchange(other.remaining, 0)},
+      num_bytes{std::exchange(other.num_bytes, 0)} {}
+
+Arena& Arena::operator=(Arena&& other) noexcept {
+    if (this != &other) {
+        block_size = other.block_size;
+        blocks = std::exchange(other.blocks, {});
+        cursor = std::exchange(other.cursor, nullptr);
+        remaining = std::exchange(other.remaining, 0);
+        num_bytes = std::exchange(other.num_bytes, 0);
+    }
+    return *this;
+}
+
+std::size_t Arena::capacity() const {
+    return num_bytes;
+}
+
+void* Arena::allocate_bytes(std::size_t size) {
+    size = align_size(size);
+    if (size > block_size) {
+        return add_block(size);
+    }
+    if (size > remaining) {
+        cursor = add_block(block_size);
+        remaining = block_size;
+    }
+    auto result{cursor};
+    cursor += size;
+    remaining -= size;
+    return result;
+}
+
+char* Arena::add_block(std::size_t size) {
+    // Not value-initialized, so that the pages are only touched when they
+    // are written.
+    blocks.emplace_back(new char[size + alignment - 1]);
+    num_bytes += size + alignment - 1;
+    auto address{reinterpret_cast<std::uintptr_t>(blocks.back().get())};
+    auto aligned{(address + alignment - 1) / alignment * alignment};
+    return blocks.back().get() + (aligned - address);
+}
+
+}
@@ -0,0 +1,138 @@
+#include "blue-noise.h"
+
+#include "random-generator.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace ray_tracing {
+
+// The width of the Gaussian that measures how crowded a point is.
+static constexpr float sigma{1.5f};
+
+// The fraction of the points in the initial pattern.
+static constexpr std::size_t initial_density{10};
+
+namespace {
+
+// A binary pattern on a torus with the energy of every point: the sum of a
+// Gaussian of its distance to every point that is on.
+class Pattern {
+public:
+    explicit Pattern(std::size_t size)
+        : size{size},
+          kernel(size * size),
+          energy(size * size),
+          on(size * size) {
+        for (std::size_t y{0}; y < size; ++y) {
+            for (std::size_t x{0}; x < size; ++x) {
+                auto dx{static_cast<float>(std::min(x, size - x))};
+                auto dy{static_cast<float>(std::min(y, size - y))};
+                kernel[y * size + x]
+                        = std::exp(-(dx * dx + dy * dy) / (2 * sigma * sigma));
+            }
+        }
+    }
+
+    void set(std::size_t index, bool value) {
+        on[index] = value;
+        auto sign{value ? 1.0f : -1.0f};
+        auto mask{size - 1};
+        auto px{index % size};
+        auto py{index / size};
+        for (std::size_t y{0}; y < size; ++y) {
+            const auto* row{&kernel[((y - py) & mask) * size]};
+            auto* energy_row{&energy[y * size]};
+            for (std::size_t x{0}; x < size; ++x) {
+                energy_row[x] += sign * row[(x - px) & mask];
+            }
+        }
+    }
+
+    bool is_on(std::size_t index) const {
+        return on[index];
+    }
+
+    // The point that is on with the most energy.
+    std::size_t tightest_cluster() const {
+        return find(true, [](auto lhs, auto rhs) { return lhs > rhs; });
+    }
+
+    // The point that is off with the least energy.
+    std::size_t largest_void() const {
+        return find(false, [](auto lhs, auto rhs) { return lhs < rhs; });
+    }
+
+private:
+    template <typename Better>
+    std::size_t find(bool value, Better better) const {
+        std::size_t best{on.size()};
+        for (std::size_t i{0}; i < on.size(); ++i) {
+            if (on[i] == value
+                && (best == on.size() || better(energy[i], energy[best]))) {
+                best = i;
+            }
+        }
+        return best;
+    }
+
+    std::size_t size;
+
+    std::vector<float> kernel;
+
+    std::vector<float> energy;
+
+    std::vector<char> on;
+};
+
+}
+
+std::vector<float> make_blue_noise(std::size_t size, std::uint64_t seed) {
+    auto num_points{size * size};
+    Pattern pattern{size};
+
+    // Start from white noise and move the point in the tightest cluster to
+    // the largest void until it would move back to where it was.
+    RandomGenerator generator{seed};
+    auto num_initial{std::max<std::size_t>(1, num_points / initial_density)};
+    for (std::size_t placed{0}; placed < num_initial;) {
+        auto index{generator.next_uint32() % num_points};
+        if (!pattern.is_on(index)) {
+            pattern.set(index, true);
+            ++placed;
+        }
+    }
+    for (;;) {
+        auto cluster{pattern.tightest_cluster()};
+        pattern.set(cluster, false);
+        auto hole{pattern.largest_void()};
+        pattern.set(hole, true);
+        if (hole == cluster) {
+            break;
+        }
+    }
+
+    // Rank the initial points by taking them away from the most crowded,
+    // and the rest by filling in the emptiest places.
+    std::vector<std::size_t> ranks(num_points);
+    auto initial{pattern};
+    for (auto rank{num_initial}; rank-- > 0;) {
+        auto cluster{pattern.tightest_cluster()};
+        ranks[cluster] = rank;
+        pattern.set(cluster, false);
+    }
+    pattern = std::move(initial);
+    for (auto rank{num_initial}; rank < num_points; ++rank) {
+        auto hole{pattern.largest_void()};
+        ranks[hole] = rank;
+        pattern.set(hole, true);
+    }
+
+    std::vector<float> mask(num_points);
+    for (std::size_t i{0}; i < num_points; ++i) {
+        mask[i] = (static_cast<float>(ranks[i]) + 0.5f) / num_points;
+    }
+    return mask;
+}
+
+}
@@ -0,0 +1,18 @@
+#ifndef BLUE_NOISE_H
+#define BLUE_NOISE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace ray_tracing {
+
+// Returns a tileable `size` by `size` mask of values in (0, 1), row by row,
+// whose every threshold is spread as evenly as it can be, with no low
+// frequencies. It is made with Ulichney's void-and-cluster method from the
+// same seed every time. `size` must be a power of two.
+std::vector<float> make_blue_noise(std::size_t size, std::uint64_t seed = 0);
+
+}
+
+#endif
@@ -0,0 +1,74 @@
+#include "bounding-box.h"
+
+#include "utils.h"
+
+#include <algorithm>
+
+namespace ray_tracing {
+
+BoundingBox::BoundingBox(const Vector3& min, const Vector3& max)
+    : min{min}, max{max} {}
+
+BoundingBox BoundingBox::merge(const BoundingBox& lhs,
+                               const BoundingBox& rhs) {
+    auto box{lhs};
+    box.expand(rhs);
+    return box;
+}
+
+void BoundingBox::expand(const BoundingBox& box) {
+    min = Vector3{std::min(min.x, box.min.x),
+                  std::min(min.y, box.min.y),
+                  std::min(min.z, box.min.z)};
+    max = Vector3{std::max(max.x, box.max.x),
+                  std::max(max.y, box.max.y),
+                  std::max(max.z, box.max.z)};
+}
+
+void BoundingBox::expand(const Vector3& point) {
+    expand(BoundingBox{point, point});
+}
+
+Vector3 BoundingBox::centroid() const {
+    return (min + max) / 2;
+}
+
+Vector3 BoundingBox::extent() const {
+    return max - min;
+}
+
+Vector3::ValueType BoundingBox::surface_area() const {
+    if (is_empty()) {
+        return 0;
+    }
+    auto e{extent()};
+    return 2 * (e.x * e.y + e.y * e.z + e.z * e.x);
+}
+
+bool BoundingBox::is_empty() const {
+    return min.x > max.x || min.y > max.y || min.z > max.z;
+}
+
+bool BoundingBox::hit(const Ray& ray,
+                      const Vector3& inverse_direction,
+                      Vector3::ValueType min_distance,
+                      Vector3::ValueType max_distance) const {
+    for (auto axis{0}; axis < 3; ++axis) {
+        auto t0{(min[axis] - ray.origin[axis]) * inverse_direction[axis]};
+        auto t1{(max[axis] - ray.origin[axis]) * inverse_direction[axis]};
+        if (inverse_direction[axis] < 0) {
+            std::swap(t0, t1);
+        }
+        min_distance = t0 > min_distance ? t0 : min_distance;
+        max_distance = t1 < max_distance ? t1 : max_distance;
+        if (max_distance < min_distance) {
+            return false;
+        }
+    }
+    return true;
+}
+
+const BoundingBox BoundingBox::empty{Vector3{infinity, infinity, infinity},
+                                     Vector3{-infinity, -infinity, -infinity}};
+
+}
@@ -0,0 +1,42 @@
+#ifndef BOUNDING_BOX_H
+#define BOUNDING_BOX_H
+
+#include "ray.h"
+#include "vector3.h"
+
+namespace ray_tracing {
+
+struct BoundingBox {
+    BoundingBox() = default;
+
+    BoundingBox(const Vector3& min, const Vector3& max);
+
+    static BoundingBox merge(const BoundingBox& lhs, const BoundingBox& rhs);
+
+    void expand(const BoundingBox& box);
+
+    void expand(const Vector3& point);
+
+    Vector3 centroid() const;
+
+    Vector3 extent() const;
+
+    Vector3::ValueType surface_area() const;
+
+    bool is_empty() const;
+
+    bool hit(const Ray& ray,
+             const Vector3& inverse_direction,
+             Vector3::ValueType min_distance,
+             Vector3::ValueType max_distance) const;
+
+    static const BoundingBox empty;
+
+    Vector3 min;
+
+    Vector3 max;
+};
+
+}
+
+#endif
@@ -0,0 +1,423 @@
+#include "bvh-tree.h"
+
+#include "thread-pool.h"
+#include "utils.h"
+
+#include <algorithm>
+#include <array>
+#include <numeric>
+
+namespace ray_tracing {
+
+namespace {
+
+constexpr auto num_bins{16};
+
+constexpr Vector3::ValueType traversal_cost{1};
+
+constexpr auto max_sah_depth{32};
+
+struct Bin {
+    BoundingBox bounds{BoundingBox::empty};
+
+    std::size_t count{0};
+};
+
+// A range of indices left for a later, parallel build, in place of the
+// node at `node_index`.
+struct Subtree {
+    std::uint32_t node_index;
+
+    std::uint32_t begin;
+
+    std::uint32_t end;
+
+    int depth;
+
+    std::vector<BvhTree::Node> nodes;
+};
+
+// Several subtrees per thread, so that the threads stay busy when the
+// subtrees come out uneven.
+constexpr std::size_t subtrees_per_thread{4};
+
+struct Builder {
+    std::uint32_t build(std::uint32_t begin, std::uint32_t end, int depth);
+
+    std::uint32_t partition_median(std::uint32_t begin,
+                                   std::uint32_t end,
+                                   int axis);
+
+    const std::vector<BoundingBox>& boxes;
+
+    const std::vector<Vector3>& centroids;
+
+    std::size_t max_leaf_size;
+
+    std::vector<BvhTree::Node>& nodes;
+
+    // Shared by all builders, each of which only reorders its own range.
+    std::vector<std::uint32_t>& indices;
+
+    // Ranges of at most this many boxes are appended to `subtrees` instead
+    // of being built, unless `subtrees` is null.
+    std::size_t max_subtree_size{0};
+
+    std::vector<Subtree>* subtrees{nullptr};
+};
+
+std::uint32_t Builder::partition_median(std::uint32_t begin,
+                                        std::uint32_t end,
+                                        int axis) {
+    auto first{indices.begin() + begin};
+    auto middle{indices.begin() + (begin + end) / 2};
+    auto last{indices.begin() + end};
+    std::nth_element(first, middle, last, [&](auto lhs, auto rhs) {
+        return centroids[lhs][axis] < centroids[rhs][axis];
+    });
+    return (begin + end) / 2;
+}
+
+std::uint32_t Builder::build(std::uint32_t begin,
+                             std::uint32_t end,
+                             int depth) {
+    auto node_index{static_cast<std::uint32_t>(nodes.size())};
+    nodes.emplace_back();
+
+    auto count{end - begin};
+    if (subtrees && count <= max_subtree_size) {
+        subtrees->push_back(Subtree{node_index, begin, end, depth, {}});
+        return node_index;
+    }
+
+    auto bounds{BoundingBox::empty};
+    auto centroid_bounds{BoundingBox::empty};
+    for (auto i{begin}; i < end; ++i) {
+        bounds.expand(boxes[indices[i]]);
+        centroid_bounds.expand(centroids[indices[i]]);
+    }
+
+    auto make_leaf{[&] {
+        auto& node{nodes[node_index]};
+        node.bounds = bounds;
+        node.offset = begin;
+        node.count = static_cast<std::uint16_t>(count);
+        node.axis = 0;
+        return node_index;
+    }};
+    if (count == 1) {
+        return make_leaf();
+    }
+
+    auto centroid_extent{centroid_bounds.extent()};
+    auto widest_axis{0};
+    for (auto axis{1}; axis < 3; ++axis) {
+        if (centroid_extent[axis] > centroid_extent[widest_axis]) {
+            widest_axis = axis;
+        }
+    }
+
+    auto best_axis{-1};
+    auto best_split{0};
+    auto best_cost{infinity};
+    if (depth < max_sah_depth) {
+        for (auto axis{0}; axis < 3; ++axis) {
+            if (centroid_extent[axis] <= 0) {
+                continue;
+            }
+
+            std::array<Bin, num_bins> bins;
+            auto scale{num_bins / centroid_extent[axis]};
+            for (auto i{begin}; i < end; ++i) {
+                auto index{indices[i]};
+                auto bin{std::min(
+                        num_bins - 1,
+                        static_cast<int>((centroids[index][axis]
+                                          - centroid_bounds.min[axis])
+                                         * scale))};
+                bins[bin].bounds.expand(boxes[index]);
+                ++bins[bin].count;
+            }
+
+            std::array<Vector3::ValueType, num_bins - 1> right_costs;
+            auto right_bounds{BoundingBox::empty};
+            std::size_t right_count{0};
+            for (auto split{num_bins - 1}; split > 0; --split) {
+                right_bounds.expand(bins[split].bounds);
+                right_count += bins[split].count;
+                right_costs[split - 1]
+                        = right_bounds.surface_area() * right_count;
+            }
+
+            auto left_bounds{BoundingBox::empty};
+            std::size_t left_count{0};
+            for (auto split{1}; split < num_bins; ++split) {
+                left_bounds.expand(bins[split - 1].bounds);
+                left_count += bins[split - 1].count;
+                auto cost{left_bounds.surface_area() * left_count
+                          + right_costs[split - 1]};
+                if (cost < best_cost) {
+                    best_cost = cost;
+                    best_axis = axis;
+                    best_split = split;
+                }
+            }
+        }
+    }
+
+    std::uint32_t middle;
+    if (best_axis == -1) {
+        if (count <= max_leaf_size) {
+            return make_leaf();
+        }
+        middle = partition_median(begin, end, widest_axis);
+        best_axis = widest_axis;
+    } else {
+        auto area{bounds.surface_area()};
+        best_cost = area > 0 ? traversal_cost + best_cost / area : count;
+        if (count <= max_leaf_size && count <= best_cost) {
+            return make_leaf();
+        }
+
+        auto scale{num_bins / centroid_extent[best_axis]};
+        auto split_point{std::partition(
+                indices.begin() + begin,
+                indices.begin() + end,
+                [&](auto index) {
+                    auto bin{std::min(
+                            num_bins - 1,
+                            static_cast<int>((centroids[index][best_axis]
+                                              - centroid_bounds.min[best_axis])
+                                             * scale))};
+                    return bin < best_split;
+                })};
+        middle = static_cast<std::uint32_t>(split_point - indices.begin());
+        if (middle == begin || middle == end) {
+            middle = partition_median(begin, end, best_axis);
+        }
+    }
+
+    build(begin, middle, depth + 1);
+    auto right_index{build(middle, end, depth + 1)};
+
+    auto& node{nodes[node_index]};
+    node.bounds = bounds;
+    node.offset = right_index;
+    node.count = 0;
+    node.axis = static_cast<std::uint16_t>(best_axis);
+    return node_index;
+}
+
+}
+
+BvhTree::BvhTree(const std::vector<BoundingBox>& boxes,
+                 std::size_t max_leaf_size) {
+    if (boxes.empty()) {
+        return;
+    }
+
+    indices.resize(boxes.size());
+    std::iota(indices.begin(), indices.end(), 0);
+    nodes.reserve(2 * boxes.size() - 1);
+
+    std::vector<Vector3> centroids;
+    centroids.reserve(boxes.size());
+    for (const auto& box : boxes) {
+        centroids.emplace_back(box.centroid());
+    }
+    Builder{boxes, centroids, max_leaf_size, nodes, indices}.build(
+            0,
+            static_cast<std::uint32_t>(boxes.size()),
+            0);
+}
+
+BvhTree::BvhTree(const std::vector<BoundingBox>& boxes,
+                 std::size_t max_leaf_size,
+                 ThreadPool& pool) {
+    if (boxes.empty()) {
+        return;
+    }
+
+    indices.resize(boxes.size());
+    std::iota(indices.begin(), indices.end(), 0);
+    std::vector<Vector3> centroids(boxes.size());
+    auto num_chunks{pool.size() * subtrees_per_thread};
+    pool.run(num_chunks, [&](auto chunk_index, auto) {
+        auto first{boxes.size() * chunk_index / num_chunks};
+        auto last{boxes.size() * (chunk_index + 1) / num_chunks};
+        for (auto i{first}; i < last; ++i) {
+            centroids[i] = boxes[i].centroid();
+        }
+    });
+
+    // The top levels, down to subtrees small enough to go around the
+    // threads, are split here. Their splits are the ones a sequential
+    // build makes, so the tree comes out the same.
+    std::vector<BvhTree::Node> top_nodes;
+    std::vector<Subtree> subtrees;
+    Builder top_builder{boxes, centroids, max_leaf_size, top_nodes, indices};
+    top_builder.max_subtree_size = std::max(
+            boxes.size() / num_chunks,
+            max_leaf_size);
+    top_builder.subtrees = &subtrees;
+    top_builder.build(0, static_cast<std::uint32_t>(boxes.size()), 0);
+
+    pool.run(subtrees.size(), [&](auto subtree_index, auto) {
+        auto& subtree{subtrees[subtree_index]};
+        Builder{boxes, centroids, max_leaf_size, subtree.nodes, indices}
+                .build(subtree.begin, subtree.end, subtree.depth);
+    });
+
+    // Splice the subtrees in where they were left out, in depth-first
+    // order, moving their child offsets along with them.
+    std::vector<const Subtree*> subtree_at(top_nodes.size(), nullptr);
+    for (const auto& subtree : subtrees) {
+        subtree_at[subtree.node_index] = &subtree;
+    }
+    nodes.reserve(2 * boxes.size() - 1);
+    auto splice{[&](auto& self, std::uint32_t top_index) -> std::uint32_t {
+        auto node_index{static_cast<std::uint32_t>(nodes.size())};
+        if (const auto* subtree{subtree_at[top_index]}) {
+            for (auto node : subtree->nodes) {
+                if (node.count == 0) {
+                    node.offset += node_index;
+                }
+                nodes.emplace_back(node);
+            }
+            return node_index;
+        }
+        nodes.emplace_back(top_nodes[top_index]);
+        if (nodes.back().count == 0) {
+            self(self, top_index + 1);
+            nodes[node_index].offset = self(self, top_nodes[top_index].offset);
+        }
+        return node_index;
+    }};
+    splice(splice, 0);
+}
+
+void BvhTree::refit(const std::vector<BoundingBox>& boxes, ThreadPool& pool) {
+    if (nodes.empty()) {
+        return;
+    }
+
+    // Each node's descendants directly follow it, up to the end of its
+    // right child's descendants.
+    auto subtree_end{[&](std::uint32_t node_index) {
+        while (nodes[node_index].count == 0) {
+            node_index = nodes[node_index].offset;
+        }
+        return node_index + 1;
+    }};
+
+    auto refit_node{[&](std::uint32_t node_index) {
+        auto& node{nodes[node_index]};
+        if (node.count > 0) {
+            node.bounds = BoundingBox::empty;
+            for (auto i{node.offset}; i < node.offset + node.count; ++i) {
+                node.bounds.expand(boxes[indices[i]]);
+            }
+        } else {
+            node.bounds = BoundingBox::merge(nodes[node_index + 1].bounds,
+                                             nodes[node.offset].bounds);
+        }
+    }};
+
+    // Descend from the root until the subtrees are small enough to go
+    // around the threads. Children come after their parents, so refitting
+    // in reverse order sees every child before its parent.
+    auto max_subtree_size{
+            std::max<std::size_t>(nodes.size()
+                                          / (pool.size() * subtrees_per_thread),
+                                  1)};
+    std::vector<std::uint32_t> top_nodes;
+    std::vector<std::uint32_t> subtree_roots;
+    std::vector<std::uint32_t> stack{0};
+    while (!stack.empty()) {
+        auto node_index{stack.back()};
+        stack.pop_back();
+        const auto& node{nodes[node_index]};
+        if (node.count > 0
+            || subtree_end(node_index) - node_index <= max_subtree_size) {
+            subtree_roots.emplace_back(node_index);
+        } else {
+            top_nodes.emplace_back(node_index);
+            stack.emplace_back(node.offset);
+            stack.emplace_back(node_index + 1);
+        }
+    }
+
+    pool.run(subtree_roots.size(), [&](auto subtree_index, auto) {
+        auto root{subtree_roots[subtree_index]};
+        for (auto node_index{subtree_end(root)}; node_index-- > root;) {
+            refit_node(node_index);
+        }
+    });
+    std::sort(top_nodes.begin(), top_nodes.end());
+    for (auto node{top_nodes.rbegin()}; node != top_nodes.rend(); ++node) {
+        refit_node(*node);
+    }
+}
+
+BoundingBox BvhTree::bounds() const {
+    return nodes.empty() ? BoundingBox::empty : nodes.front().bounds;
+}
+
+// Returns the index just past the subtree at `index` at `depth`, which must
+// end where its parent's next subtree starts, or 0 if it is malformed.
+static std::size_t valid_subtree_end(const std::vector<BvhTree::Node>& nodes,
+                                     std::size_t index,
+                                     std::size_t depth,
+                                     std::size_t num_entries,
+                                     std::size_t max_leaf_size) {
+    if (index >= nodes.size() || depth > BvhTree::max_depth) {
+        return 0;
+    }
+    const auto& node{nodes[index]};
+    if (node.count > 0) {
+        auto valid{node.count <= max_leaf_size
+                   && std::size_t{node.offset} + node.count <= num_entries};
+        return valid ? index + 1 : 0;
+    }
+    // Interior nodes push one entry onto the stack of `traverse`.
+    if (node.axis > 2 || depth == BvhTree::max_depth) {
+        return 0;
+    }
+    auto left_end{valid_subtree_end(nodes,
+                                    index + 1,
+                                    depth + 1,
+                                    num_entries,
+                                    max_leaf_size)};
+    if (left_end == 0 || left_end != node.offset) {
+        return 0;
+    }
+    return valid_subtree_end(nodes,
+                             node.offset,
+                             depth + 1,
+                             num_entries,
+                             max_leaf_size);
+}
+
+bool BvhTree::is_valid(std::size_t num_entries,
+                       std::size_t max_leaf_size) const {
+    return nodes.empty()
+           || valid_subtree_end(nodes, 0, 0, num_entries, max_leaf_size)
+                      == nodes.size();
+}
+
+double BvhTree::traversal_cost() const {
+    if (nodes.empty()) {
+        return 0;
+    }
+    auto root_area{nodes.front().bounds.surface_area()};
+    if (root_area <= 0) {
+        return 1;
+    }
+    double area_sum{0};
+    for (const auto& node : nodes) {
+        area_sum += node.bounds.surface_area();
+    }
+    return area_sum / root_area;
+}
+
+}
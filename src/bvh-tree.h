@@ -0,0 +1,132 @@
+#ifndef BVH_TREE_H
+#define BVH_TREE_H
+
+#include "bounding-box.h"
+#include "ray.h"
+#include "render-stats.h"
+#include "vector3.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace ray_tracing {
+
+class ThreadPool;
+
+// A bounding volume hierarchy over a set of boxes, built with the binned
+// surface area heuristic and stored as a flat, depth-first array of nodes:
+// the left child of an interior node immediately follows it and `offset`
+// points at the right child. Leaves cover `count` consecutive entries of
+// `indices`, starting at `offset`.
+struct BvhTree {
+    struct Node {
+        BoundingBox bounds;
+
+        std::uint32_t offset;
+
+        std::uint16_t count;
+
+        std::uint16_t axis;
+    };
+
+    // The deepest a leaf may be, for the stack `traverse` walks the tree
+    // with. The builder stays well within it: below the SAH levels it
+    // splits at the median, so each level halves what is left.
+    static constexpr std::size_t max_depth{64};
+
+    BvhTree() = default;
+
+    BvhTree(const std::vector<BoundingBox>& boxes, std::size_t max_leaf_size);
+
+    // Builds the same tree on the threads of `pool`: the top levels are
+    // split one after the other, and the subtrees below them at the same
+    // time.
+    BvhTree(const std::vector<BoundingBox>& boxes,
+            std::size_t max_leaf_size,
+            ThreadPool& pool);
+
+    BoundingBox bounds() const;
+
+    // Recomputes the bounds of all nodes from `boxes`, indexed the same way
+    // as those the tree was built from, keeping its shape. Much faster than
+    // a rebuild, but the tree gets worse the further the boxes move from
+    // where they were.
+    void refit(const std::vector<BoundingBox>& boxes, ThreadPool& pool);
+
+    // Whether the nodes form a tree laid out as the builder lays them out,
+    // no deeper than `max_depth`, whose leaves cover up to `max_leaf_size`
+    // of `num_entries` entries each. For trees read from files.
+    bool is_valid(std::size_t num_entries, std::size_t max_leaf_size) const;
+
+    // The number of nodes a ray through the root is expected to visit, by
+    // the surface area heuristic, for telling how much a refit has made the
+    // tree worse.
+    double traversal_cost() const;
+
+    // Calls `intersect_leaf(first, count, max_distance)` for every leaf the
+    // ray may hit, nearest first. The callback returns whether it found a
+    // hit and shrinks `max_distance` when it does.
+    template <typename IntersectLeaf>
+    bool traverse(const Ray& ray,
+                  Vector3::ValueType min_distance,
+                  Vector3::ValueType& max_distance,
+                  IntersectLeaf&& intersect_leaf) const;
+
+    std::vector<Node> nodes;
+
+    std::vector<std::uint32_t> indices;
+};
+
+template <typename IntersectLeaf>
+bool BvhTree::traverse(const Ray& ray,
+                       Vector3::ValueType min_distance,
+                       Vector3::ValueType& max_distance,
+                       IntersectLeaf&& intersect_leaf) const {
+    if (nodes.empty()) {
+        return false;
+    }
+
+    const Vector3 inverse_direction{1 / ray.direction.x,
+                                    1 / ray.direction.y,
+                                    1 / ray.direction.z};
+    std::uint32_t stack[max_depth];
+    auto stack_size{0};
+    std::uint32_t node_index{0};
+    auto hit_anything{false};
+    std::uint64_t num_visited{0};
+
+    for (;;) {
+        const auto& node{nodes[node_index]};
+        ++num_visited;
+        if (node.bounds.hit(ray,
+                            inverse_direction,
+                            min_distance,
+                            max_distance)) {
+            if (node.count > 0) {
+                if (intersect_leaf(node.offset, node.count, max_distance)) {
+                    hit_anything = true;
+                }
+            } else if (ray.direction[node.axis] < 0) {
+                stack[stack_size++] = node_index + 1;
+                node_index = node.offset;
+                continue;
+            } else {
+                stack[stack_size++] = node.offset;
+                ++node_index;
+                continue;
+            }
+        }
+        if (stack_size == 0) {
+            break;
+        }
+        node_index = stack[--stack_size];
+    }
+
+    add_stat(Stat::bvh_nodes_visited, num_visited);
+    return hit_anything;
+}
+
+}
+
+#endif
@@ -0,0 +1,50 @@
+#include "bvh.h"
+
+namespace ray_tracing {
+
+Bvh::Bvh(const HittableList& list) : Bvh{list.hittables()} {}
+
+Bvh::Bvh(const std::vector<std::shared_ptr<Hittable>>& hittable_ptrs) {
+    std::vector<BoundingBox> boxes;
+    boxes.reserve(hittable_ptrs.size());
+    for (const auto& hittable_ptr : hittable_ptrs) {
+        boxes.emplace_back(hittable_ptr->bounding_box());
+    }
+    tree = BvhTree{boxes, max_leaf_size};
+
+    // Store the hittables in leaf order so that each leaf reads a contiguous
+    // range instead of chasing indices.
+    this->hittable_ptrs.reserve(hittable_ptrs.size());
+    for (auto index : tree.indices) {
+        this->hittable_ptrs.emplace_back(hittable_ptrs[index]);
+    }
+}
+
+bool Bvh::hit(const Ray& ray,
+              HitInfo& hit_info,
+              Vector3::ValueType min_distance,
+              Vector3::ValueType max_distance) const {
+    return tree.traverse(
+            ray,
+            min_distance,
+            max_distance,
+            [&](auto first, auto count, auto& closest_distance) {
+                auto hit_anything{false};
+                for (auto i{first}; i < first + count; ++i) {
+                    if (hittable_ptrs[i]->hit(ray,
+                                              hit_info,
+                                              min_distance,
+                                              closest_distance)) {
+                        hit_anything = true;
+                        closest_distance = hit_info.distance;
+                    }
+                }
+                return hit_anything;
+            });
+}
+
+BoundingBox Bvh::bounding_box() const {
+    return tree.bounds();
+}
+
+}
@@ -0,0 +1,36 @@
+#ifndef BVH_H
+#define BVH_H
+
+#include "bvh-tree.h"
+#include "hittable-list.h"
+#include "hittable.h"
+
+#include <memory>
+#include <vector>
+
+namespace ray_tracing {
+
+class Bvh : public Hittable {
+public:
+    Bvh(const HittableList& list);
+
+    Bvh(const std::vector<std::shared_ptr<Hittable>>& hittable_ptrs);
+
+    bool hit(const Ray& ray,
+             HitInfo& hit_info,
+             Vector3::ValueType min_distance,
+             Vector3::ValueType max_distance) const override;
+
+    BoundingBox bounding_box() const override;
+
+private:
+    static constexpr auto max_leaf_size{4};
+
+    BvhTree tree;
+
+    std::vector<std::shared_ptr<Hittable>> hittable_ptrs;
+};
+
+}
+
+#endif
@@ -1,5 +1,7 @@
 #include "camera.h"
 
+#include "warp.h"
+
 namespace ray_tracing {
 
 Camera::Camera(Vector3 lookfrom,
@@ -17,8 +19,11 @@ Camera::Camera(Vector3 lookfrom,
       focus_distance{focus_distance},
       aperture{aperture} {}
 
-Ray Camera::generate_ray(Vector3::ValueType s, Vector3::ValueType t) const {
-    auto rd{lens_radius * random_vector_in_unit_disk()};
+Ray Camera::generate_ray(Vector3::ValueType s,
+                         Vector3::ValueType t,
+                         const SamplePoint& lens_sample) const {
+    auto rd{lens_radius
+            * square_to_concentric_disk(lens_sample.u, lens_sample.v)};
     auto offset{u * rd.x + v * rd.y};
     return Ray{lookfrom + offset,
                viewport_lower_left_corner + s * viewport_horizontal
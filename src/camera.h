@@ -2,6 +2,7 @@
 #define CAMERA_H
 
 #include "ray.h"
+#include "sampler.h"
 #include "vector3.h"
 
 #include "utils.h"
@@ -20,7 +21,11 @@ public:
            Vector3::ValueType focus_distance,
            Vector3::ValueType aperture);
 
-    Ray generate_ray(Vector3::ValueType s, Vector3::ValueType t) const;
+    // Through the point (`s`, `t`) of the viewport, from the point of the
+    // lens that `lens_sample` warps to.
+    Ray generate_ray(Vector3::ValueType s,
+                     Vector3::ValueType t,
+                     const SamplePoint& lens_sample) const;
 
 private:
     Vector3::ValueType vertical_fov{degrees_to_radians(90)};
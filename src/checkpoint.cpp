@@ -0,0 +1,133 @@
+#include "checkpoint.h"
+
+#include "mapped-file.h"
+
+#include <unistd.h>
+
+#include <iostream>
+#include <string>
+#include <type_traits>
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+
+namespace ray_tracing {
+
+static_assert(std::is_trivially_copyable_v<Film::Pixel>);
+
+struct CheckpointHeader {
+    char magic[8];
+
+    std::uint32_t version;
+
+    std::uint32_t pixel_size;
+
+    std::uint64_t width;
+
+    std::uint64_t height;
+
+    std::uint64_t samples_per_pixel;
+
+    std::uint64_t max_depth;
+
+    std::uint32_t sampler;
+
+    float adaptive_threshold;
+};
+
+static constexpr char checkpoint_magic[8]{'R', 'T', 'F', 'I', 'L', 'M', 0, 0};
+
+static constexpr std::uint32_t checkpoint_version{2};
+
+bool save_checkpoint(const char* filename,
+                     const Film& film,
+                     const RenderSettings& settings) {
+    // Write to a temporary file first so that being killed mid-write leaves
+    // the previous checkpoint intact.
+    auto temporary_filename{std::string{filename} + ".tmp"};
+    auto fp{fopen(temporary_filename.c_str(), "wb")};
+    if (!fp) {
+        std::cerr << "Failed to open file: " << temporary_filename << ".\n";
+        return false;
+    }
+
+    CheckpointHeader header{};
+    std::memcpy(header.magic, checkpoint_magic, sizeof(header.magic));
+    header.version = checkpoint_version;
+    header.pixel_size = sizeof(Film::Pixel);
+    header.width = film.width;
+    header.height = film.height;
+    header.samples_per_pixel = settings.samples_per_pixel;
+    header.max_depth = settings.max_depth;
+    header.sampler = static_cast<std::uint32_t>(settings.sampler);
+    header.adaptive_threshold = settings.adaptive_threshold;
+    auto written{fwrite(&header, sizeof(header), 1, fp) == 1
+                 && fwrite(film.pixels.data(),
+                           sizeof(Film::Pixel),
+                           film.pixels.size(),
+                           fp) == film.pixels.size()};
+    written = fflush(fp) == 0 && fsync(fileno(fp)) == 0 && written;
+    if (fclose(fp) != 0 || !written) {
+        std::cerr << "Failed to write checkpoint: " << temporary_filename
+                  << ".\n";
+        return false;
+    }
+
+    if (std::rename(temporary_filename.c_str(), filename) != 0) {
+        std::cerr << "Failed to replace checkpoint: " << filename << ".\n";
+        return false;
+    }
+    return true;
+}
+
+bool load_checkpoint(const char* filename,
+                     const RenderSettings& settings,
+                     Film& film) {
+    auto file{MappedFile::open(filename)};
+    if (!file) {
+        return false;
+    }
+
+    CheckpointHeader header;
+    auto valid{file->size() >= sizeof(header)};
+    if (valid) {
+        std::memcpy(&header, file->data(), sizeof(header));
+        valid = std::memcmp(header.magic,
+                            checkpoint_magic,
+                            sizeof(header.magic))
+                        == 0
+                && header.version == checkpoint_version
+                && header.pixel_size == sizeof(Film::Pixel)
+                && file->size()
+                           == sizeof(header)
+                                      + header.width * header.height
+                                                * sizeof(Film::Pixel);
+    }
+
+    if (!valid) {
+        std::cerr << "Invalid checkpoint: " << filename << ".\n";
+        return false;
+    }
+    if (header.width != film.width || header.height != film.height) {
+        std::cerr << "Checkpoint size " << header.width << 'x'
+                  << header.height << " does not match the image size "
+                  << film.width << 'x' << film.height << ".\n";
+        return false;
+    }
+    if (header.samples_per_pixel != settings.samples_per_pixel
+        || header.max_depth != settings.max_depth
+        || header.sampler != static_cast<std::uint32_t>(settings.sampler)
+        || header.adaptive_threshold != settings.adaptive_threshold) {
+        std::cerr << "Checkpoint " << filename
+                  << " was rendered with other samples per pixel, depth, "
+                     "sampler or adaptive threshold.\n";
+        return false;
+    }
+    std::memcpy(film.pixels.data(),
+                file->data() + sizeof(header),
+                film.pixels.size() * sizeof(Film::Pixel));
+    return true;
+}
+
+}
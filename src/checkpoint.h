@@ -0,0 +1,25 @@
+#ifndef CHECKPOINT_H
+#define CHECKPOINT_H
+
+#include "film.h"
+#include "renderer.h"
+
+namespace ray_tracing {
+
+// A checkpoint is a small fixed header followed by the film's pixels exactly
+// as they are laid out in memory, so loading one is a single memory map and
+// copy, and a render can be resumed to add more samples. The header also
+// records the settings that decide which samples each pixel takes, since
+// resuming with others would mix samples of different sequences and skew
+// the estimate; a checkpoint only loads with the same ones.
+bool save_checkpoint(const char* filename,
+                     const Film& film,
+                     const RenderSettings& settings);
+
+bool load_checkpoint(const char* filename,
+                     const RenderSettings& settings,
+                     Film& film);
+
+}
+
+#endif
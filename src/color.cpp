@@ -1,99 +0,0 @@
-#include "color.h"
-
-#include <cmath>
-
-namespace ray_tracing {
-
-Color::Color(ValueType r, ValueType g, ValueType b, ValueType a)
-    : r{std::fmax(0.0, std::fmin(1.0, r))},
-      g{std::fmax(0.0, std::fmin(1.0, g))},
-      b{std::fmax(0.0, std::fmin(1.0, b))},
-      a{std::fmax(0.0, std::fmin(1.0, a))} {}
-
-Color Color::lerp_unclamped(const Color& c0, const Color& c1, ValueType t) {
-    return (1 - t) * c0 + t * c1;
-}
-
-Color Color::lerp(const Color& c0, const Color& c1, ValueType t) {
-    return lerp_unclamped(c0, c1, std::fmax(0.0, std::fmin(1.0, t)));
-}
-
-Color Color::gamma() const {
-    constexpr auto gamma{1.0f / 2.2f};
-    return Color{std::pow(r, gamma),
-                 std::pow(g, gamma),
-                 std::pow(b, gamma),
-                 std::pow(a, gamma)};
-}
-
-Color operator-(const Color& color) {
-    return Color{-color.r, -color.g, -color.b, -color.a};
-}
-
-Color operator+(const Color& lhs, const Color& rhs) {
-    return Color{lhs.r + rhs.r, lhs.g + rhs.g, lhs.b + rhs.b, lhs.a + rhs.a};
-}
-
-Color operator-(const Color& lhs, const Color& rhs) {
-    return lhs + -rhs;
-}
-
-Color operator*(Color::ValueType lhs, const Color& rhs) {
-    return Color{lhs * rhs.r, lhs * rhs.g, lhs * rhs.b, lhs * rhs.a};
-}
-
-Color operator*(const Color& lhs, Color::ValueType rhs) {
-    return rhs * lhs;
-}
-
-Color operator/(const Color& lhs, Color::ValueType rhs) {
-    return (1 / rhs) * lhs;
-}
-
-Color& operator+=(Color& lhs, const Color& rhs) {
-    lhs.r += rhs.r;
-    lhs.g += rhs.g;
-    lhs.b += rhs.b;
-    lhs.a += rhs.a;
-    return lhs;
-}
-
-Color& operator-=(Color& lhs, const Color& rhs) {
-    lhs += -rhs;
-    return lhs;
-}
-
-Color& operator*=(Color& lhs, Color::ValueType rhs) {
-    lhs.r *= rhs;
-    lhs.g *= rhs;
-    lhs.b *= rhs;
-    lhs.a *= rhs;
-    return lhs;
-}
-
-Color& operator/=(Color& lhs, Color::ValueType rhs) {
-    lhs *= (1 / rhs);
-    return lhs;
-}
-
-const Color Color::clear{0, 0, 0, 0};
-
-const Color Color::black{0, 0, 0, 1};
-
-const Color Color::white{1, 1, 1, 1};
-
-const Color Color::gray{0.5, 0.5, 0.5, 1};
-
-const Color Color::red{1, 0, 0, 1};
-
-const Color Color::green{0, 1, 0, 1};
-
-const Color Color::blue{0, 0, 1, 1};
-
-const Color Color::cyan{0, 1, 1, 1};
-
-const Color Color::magenta{1, 0, 1, 1};
-
-const Color Color::yellow{1, 1, 0, 1};
-
-}
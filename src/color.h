@@ -1,40 +1,54 @@
 #ifndef COLOR_H
 #define COLOR_H
 
-namespace ray_tracing {
+#if defined(USE_SIMD) && defined(__AVX__)
+#include <immintrin.h>
+#elif defined(USE_SIMD) && defined(__SSE2__)
+#include <emmintrin.h>
+#endif
 
-struct Color {
-    using ValueType = double;
+#include <cmath>
+
+namespace ray_tracing {
 
-    Color() = default;
+// Like `BasicVector3`, defined inline. The constructor and the non-assigning
+// operators clamp every channel to [0, 1]; light transport uses the
+// unclamped `BasicRadiance` instead.
+template <typename T>
+struct BasicColor {
+    using ValueType = T;
 
-    Color(ValueType r, ValueType g, ValueType b, ValueType a);
+    BasicColor() = default;
 
-    static Color lerp_unclamped(const Color& c0, const Color& c1, ValueType t);
+    constexpr BasicColor(ValueType r, ValueType g, ValueType b, ValueType a);
 
-    static Color lerp(const Color& c0, const Color& c1, ValueType t);
+    static constexpr BasicColor lerp_unclamped(const BasicColor& c0,
+                                               const BasicColor& c1,
+                                               ValueType t);
 
-    Color gamma() const;
+    static constexpr BasicColor lerp(const BasicColor& c0,
+                                     const BasicColor& c1,
+                                     ValueType t);
 
-    static const Color clear;
+    static const BasicColor clear;
 
-    static const Color black;
+    static const BasicColor black;
 
-    static const Color white;
+    static const BasicColor white;
 
-    static const Color gray;
+    static const BasicColor gray;
 
-    static const Color red;
+    static const BasicColor red;
 
-    static const Color green;
+    static const BasicColor green;
 
-    static const Color blue;
+    static const BasicColor blue;
 
-    static const Color cyan;
+    static const BasicColor cyan;
 
-    static const Color magenta;
+    static const BasicColor magenta;
 
-    static const Color yellow;
+    static const BasicColor yellow;
 
     ValueType r;
 
@@ -43,27 +57,243 @@ struct Color {
     ValueType b;
 
     ValueType a;
+
+private:
+    // Matches std::fmax(0, std::fmin(1, value)), including mapping NaN to 1.
+    static constexpr ValueType clamp(ValueType value);
 };
 
-Color operator-(const Color& color);
+using Color = BasicColor<double>;
+
+template <typename T>
+constexpr BasicColor<T> operator-(const BasicColor<T>& color);
+
+template <typename T>
+constexpr BasicColor<T> operator+(const BasicColor<T>& lhs,
+                                  const BasicColor<T>& rhs);
+
+template <typename T>
+constexpr BasicColor<T> operator-(const BasicColor<T>& lhs,
+                                  const BasicColor<T>& rhs);
+
+template <typename T>
+constexpr BasicColor<T> operator*(typename BasicColor<T>::ValueType lhs,
+                                  const BasicColor<T>& rhs);
+
+template <typename T>
+constexpr BasicColor<T> operator*(const BasicColor<T>& lhs,
+                                  typename BasicColor<T>::ValueType rhs);
+
+template <typename T>
+constexpr BasicColor<T> operator/(const BasicColor<T>& lhs,
+                                  typename BasicColor<T>::ValueType rhs);
+
+template <typename T>
+constexpr BasicColor<T>& operator+=(BasicColor<T>& lhs,
+                                    const BasicColor<T>& rhs);
+
+template <typename T>
+constexpr BasicColor<T>& operator-=(BasicColor<T>& lhs,
+                                    const BasicColor<T>& rhs);
+
+template <typename T>
+constexpr BasicColor<T>& operator*=(BasicColor<T>& lhs,
+                                    typename BasicColor<T>::ValueType rhs);
+
+template <typename T>
+constexpr BasicColor<T>& operator/=(BasicColor<T>& lhs,
+                                    typename BasicColor<T>::ValueType rhs);
+
+template <typename T>
+constexpr BasicColor<T>::BasicColor(ValueType r,
+                                    ValueType g,
+                                    ValueType b,
+                                    ValueType a)
+    : r{clamp(r)}, g{clamp(g)}, b{clamp(b)}, a{clamp(a)} {}
+
+template <typename T>
+constexpr T BasicColor<T>::clamp(ValueType value) {
+    auto clamped_above{value < 1 ? value : ValueType{1}};
+    return clamped_above > 0 ? clamped_above : ValueType{0};
+}
+
+template <typename T>
+constexpr BasicColor<T> BasicColor<T>::lerp_unclamped(const BasicColor& c0,
+                                                      const BasicColor& c1,
+                                                      ValueType t) {
+    return (1 - t) * c0 + t * c1;
+}
+
+template <typename T>
+constexpr BasicColor<T> BasicColor<T>::lerp(const BasicColor& c0,
+                                            const BasicColor& c1,
+                                            ValueType t) {
+    return lerp_unclamped(c0, c1, clamp(t));
+}
+
+template <typename T>
+constexpr BasicColor<T> BasicColor<T>::clear{0, 0, 0, 0};
+
+template <typename T>
+constexpr BasicColor<T> BasicColor<T>::black{0, 0, 0, 1};
+
+template <typename T>
+constexpr BasicColor<T> BasicColor<T>::white{1, 1, 1, 1};
+
+template <typename T>
+constexpr BasicColor<T> BasicColor<T>::gray{0.5, 0.5, 0.5, 1};
+
+template <typename T>
+constexpr BasicColor<T> BasicColor<T>::red{1, 0, 0, 1};
+
+template <typename T>
+constexpr BasicColor<T> BasicColor<T>::green{0, 1, 0, 1};
+
+template <typename T>
+constexpr BasicColor<T> BasicColor<T>::blue{0, 0, 1, 1};
+
+template <typename T>
+constexpr BasicColor<T> BasicColor<T>::cyan{0, 1, 1, 1};
+
+template <typename T>
+constexpr BasicColor<T> BasicColor<T>::magenta{1, 0, 1, 1};
+
+template <typename T>
+constexpr BasicColor<T> BasicColor<T>::yellow{1, 1, 0, 1};
 
-Color operator+(const Color& lhs, const Color& rhs);
+template <typename T>
+constexpr BasicColor<T> operator-(const BasicColor<T>& color) {
+    return BasicColor<T>{-color.r, -color.g, -color.b, -color.a};
+}
+
+template <typename T>
+constexpr BasicColor<T> operator+(const BasicColor<T>& lhs,
+                                  const BasicColor<T>& rhs) {
+    return BasicColor<T>{lhs.r + rhs.r,
+                         lhs.g + rhs.g,
+                         lhs.b + rhs.b,
+                         lhs.a + rhs.a};
+}
+
+template <typename T>
+constexpr BasicColor<T> operator-(const BasicColor<T>& lhs,
+                                  const BasicColor<T>& rhs) {
+    return BasicColor<T>{lhs.r - rhs.r,
+                         lhs.g - rhs.g,
+                         lhs.b - rhs.b,
+                         lhs.a - rhs.a};
+}
+
+template <typename T>
+constexpr BasicColor<T> operator*(typename BasicColor<T>::ValueType lhs,
+                                  const BasicColor<T>& rhs) {
+    return BasicColor<T>{lhs * rhs.r, lhs * rhs.g, lhs * rhs.b, lhs * rhs.a};
+}
+
+template <typename T>
+constexpr BasicColor<T> operator*(const BasicColor<T>& lhs,
+                                  typename BasicColor<T>::ValueType rhs) {
+    return rhs * lhs;
+}
+
+template <typename T>
+constexpr BasicColor<T> operator/(const BasicColor<T>& lhs,
+                                  typename BasicColor<T>::ValueType rhs) {
+    return (1 / rhs) * lhs;
+}
+
+template <typename T>
+constexpr BasicColor<T>& operator+=(BasicColor<T>& lhs,
+                                    const BasicColor<T>& rhs) {
+    lhs.r += rhs.r;
+    lhs.g += rhs.g;
+    lhs.b += rhs.b;
+    lhs.a += rhs.a;
+    return lhs;
+}
+
+template <typename T>
+constexpr BasicColor<T>& operator-=(BasicColor<T>& lhs,
+                                    const BasicColor<T>& rhs) {
+    lhs.r -= rhs.r;
+    lhs.g -= rhs.g;
+    lhs.b -= rhs.b;
+    lhs.a -= rhs.a;
+    return lhs;
+}
+
+template <typename T>
+constexpr BasicColor<T>& operator*=(BasicColor<T>& lhs,
+                                    typename BasicColor<T>::ValueType rhs) {
+    lhs.r *= rhs;
+    lhs.g *= rhs;
+    lhs.b *= rhs;
+    lhs.a *= rhs;
+    return lhs;
+}
+
+template <typename T>
+constexpr BasicColor<T>& operator/=(BasicColor<T>& lhs,
+                                    typename BasicColor<T>::ValueType rhs) {
+    lhs *= (1 / rhs);
+    return lhs;
+}
+
+#if defined(USE_SIMD) && (defined(__AVX__) || defined(__SSE2__))
+
+// Intrinsics versions of the clamping operators for `Color`, which overload
+// resolution prefers over the templates above. Like `SimdFloat`, they use
+// one AVX register or a pair of SSE2 registers. `min` and `max` return their
+// second operand when either is NaN, which keeps `clamp`'s results exact.
+#if defined(__AVX__)
+
+inline Color make_color(__m256d value) {
+    value = _mm256_min_pd(value, _mm256_set1_pd(1));
+    value = _mm256_max_pd(value, _mm256_setzero_pd());
+    Color color;
+    _mm256_storeu_pd(&color.r, value);
+    return color;
+}
+
+inline Color operator+(const Color& lhs, const Color& rhs) {
+    return make_color(
+            _mm256_add_pd(_mm256_loadu_pd(&lhs.r), _mm256_loadu_pd(&rhs.r)));
+}
 
-Color operator-(const Color& lhs, const Color& rhs);
+inline Color operator*(Color::ValueType lhs, const Color& rhs) {
+    return make_color(
+            _mm256_mul_pd(_mm256_set1_pd(lhs), _mm256_loadu_pd(&rhs.r)));
+}
 
-Color operator*(Color::ValueType lhs, const Color& rhs);
+#else
 
-Color operator*(const Color& lhs, Color::ValueType rhs);
+inline Color make_color(__m128d rg, __m128d ba) {
+    auto one{_mm_set1_pd(1)};
+    auto zero{_mm_setzero_pd()};
+    Color color;
+    _mm_storeu_pd(&color.r, _mm_max_pd(_mm_min_pd(rg, one), zero));
+    _mm_storeu_pd(&color.b, _mm_max_pd(_mm_min_pd(ba, one), zero));
+    return color;
+}
 
-Color operator/(const Color& lhs, Color::ValueType rhs);
+inline Color operator+(const Color& lhs, const Color& rhs) {
+    return make_color(_mm_add_pd(_mm_loadu_pd(&lhs.r), _mm_loadu_pd(&rhs.r)),
+                      _mm_add_pd(_mm_loadu_pd(&lhs.b), _mm_loadu_pd(&rhs.b)));
+}
 
-Color& operator+=(Color& lhs, const Color& rhs);
+inline Color operator*(Color::ValueType lhs, const Color& rhs) {
+    auto scale{_mm_set1_pd(lhs)};
+    return make_color(_mm_mul_pd(scale, _mm_loadu_pd(&rhs.r)),
+                      _mm_mul_pd(scale, _mm_loadu_pd(&rhs.b)));
+}
 
-Color& operator-=(Color& lhs, const Color& rhs);
+#endif
 
-Color& operator*=(Color& lhs, Color::ValueType rhs);
+inline Color operator*(const Color& lhs, Color::ValueType rhs) {
+    return rhs * lhs;
+}
 
-Color& operator/=(Color& lhs, Color::ValueType rhs);
+#endif
 
 }
 
@@ -0,0 +1,269 @@
+#include "denoiser.h"
+
+#include "radiance.h"
+#include "vector3.h"
+
+#include <algorithm>
+#include <limits>
+#include <vector>
+
+#include <cmath>
+#include <cstddef>
+
+namespace ray_tracing {
+
+// With steps of 1, 2, 4, 8 and 16 pixels, the filter reaches 62 pixels out.
+static constexpr std::size_t num_passes{5};
+
+// The weights of the 5x5 kernel along each axis, from the center out, which
+// approximate a Gaussian by the B3 spline.
+static constexpr float kernel[]{3.0f / 8, 1.0f / 4, 1.0f / 16};
+
+// How many standard errors of the luminance two pixels may differ by before
+// the weight between them falls to 1/e.
+static constexpr float luminance_sigma{4};
+
+// How many times the change in depth across the tap, as estimated from the
+// neighbours, two pixels may differ by in depth before the weight falls to
+// 1/e, and the share of the depth itself that they always may.
+static constexpr float depth_sigma{1};
+
+static constexpr float depth_tolerance{1e-3f};
+
+// The weight of the normals is their cosine to the power of 2 to this.
+static constexpr int normal_squarings{7};
+
+// Of each channel of the albedo that the color is divided by, so that dark
+// surfaces do not blow their noise up.
+static constexpr float min_albedo{0.01f};
+
+struct Guide {
+    BasicVector3<float> normal;
+
+    float depth;
+
+    // The smaller of the changes in depth to the neighbours on either side,
+    // in pixels along each axis, which is the slope of the surface unless
+    // both neighbours lie across an edge.
+    float depth_gradient_x;
+
+    float depth_gradient_y;
+
+    bool has_samples;
+};
+
+struct FilterPixel {
+    Radiance irradiance;
+
+    // The variance of the mean luminance of the irradiance.
+    float variance;
+};
+
+static Radiance floored_albedo(const Radiance& albedo) {
+    return Radiance{std::max(albedo.r, min_albedo),
+                    std::max(albedo.g, min_albedo),
+                    std::max(albedo.b, min_albedo)};
+}
+
+static float depth_gradient(const FeatureBuffer& features,
+                            const Film& film,
+                            std::size_t x,
+                            std::size_t y,
+                            std::size_t dx,
+                            std::size_t dy) {
+    auto depth{features.at(x, y).depth};
+    auto gradient{std::numeric_limits<float>::infinity()};
+    if (x >= dx && y >= dy && film.at(x - dx, y - dy).num_samples > 0) {
+        gradient = std::abs(features.at(x - dx, y - dy).depth - depth);
+    }
+    if (x + dx < film.width && y + dy < film.height
+        && film.at(x + dx, y + dy).num_samples > 0) {
+        gradient = std::min(gradient,
+                            std::abs(features.at(x + dx, y + dy).depth
+                                     - depth));
+    }
+    return std::isinf(gradient) ? 0 : gradient;
+}
+
+// The weight of `normal` against the normal of the pixel being filtered.
+static float normal_weight(const BasicVector3<float>& center,
+                           const BasicVector3<float>& normal) {
+    auto weight{std::max(0.0f, BasicVector3<float>::dot(center, normal))};
+    for (auto i{0}; i < normal_squarings; ++i) {
+        weight *= weight;
+    }
+    return weight;
+}
+
+// The variance of the pixels around `(x, y)`, blurred by a 3x3 Gaussian,
+// which keeps a single outlier from either stopping or forcing the blur.
+static float blurred_variance(const std::vector<FilterPixel>& input,
+                              const std::vector<Guide>& guides,
+                              std::size_t width,
+                              std::size_t height,
+                              std::size_t x,
+                              std::size_t y) {
+    constexpr float weights[]{0.5f, 0.25f};
+    float sum{0};
+    float weight_sum{0};
+    for (auto j{-1}; j <= 1; ++j) {
+        for (auto i{-1}; i <= 1; ++i) {
+            auto qx{x + i};
+            auto qy{y + j};
+            if (qx >= width || qy >= height) {
+                continue;
+            }
+            auto index{qy * width + qx};
+            if (!guides[index].has_samples) {
+                continue;
+            }
+            auto weight{weights[std::abs(i)] * weights[std::abs(j)]};
+            sum += weight * input[index].variance;
+            weight_sum += weight;
+        }
+    }
+    return sum / weight_sum;
+}
+
+// One pass of the wavelet transform, with taps `step` pixels apart.
+static void filter_pass(const std::vector<FilterPixel>& input,
+                        const std::vector<Guide>& guides,
+                        std::size_t width,
+                        std::size_t height,
+                        std::size_t step,
+                        ThreadPool& pool,
+                        std::vector<FilterPixel>& output) {
+    pool.run(height, [&](auto y, auto) {
+        for (decltype(width) x{0}; x < width; ++x) {
+            auto index{y * width + x};
+            const auto& guide{guides[index]};
+            if (!guide.has_samples) {
+                output[index] = input[index];
+                continue;
+            }
+
+            auto luminance{input[index].irradiance.luminance()};
+            auto variance{blurred_variance(input, guides, width, height, x, y)};
+            auto luminance_scale{
+                    1 / (luminance_sigma * std::sqrt(variance) + 1e-6f)};
+            auto depth_tolerance_here{depth_tolerance * guide.depth + 1e-6f};
+
+            auto irradiance{Radiance::black};
+            float tap_variance{0};
+            float weight_sum{0};
+            for (auto j{-2}; j <= 2; ++j) {
+                for (auto i{-2}; i <= 2; ++i) {
+                    auto qx{x + i * static_cast<std::ptrdiff_t>(step)};
+                    auto qy{y + j * static_cast<std::ptrdiff_t>(step)};
+                    if (qx >= width || qy >= height) {
+                        continue;
+                    }
+                    auto tap_index{qy * width + qx};
+                    const auto& tap_guide{guides[tap_index]};
+                    if (!tap_guide.has_samples) {
+                        continue;
+                    }
+                    const auto& tap{input[tap_index]};
+
+                    auto depth_scale{
+                            depth_sigma * step
+                                    * (guide.depth_gradient_x * std::abs(i)
+                                       + guide.depth_gradient_y * std::abs(j))
+                            + depth_tolerance_here};
+                    auto distance{
+                            std::abs(tap.irradiance.luminance() - luminance)
+                                    * luminance_scale
+                            + std::abs(tap_guide.depth - guide.depth)
+                                      / depth_scale};
+                    auto weight{kernel[std::abs(i)] * kernel[std::abs(j)]
+                                * normal_weight(guide.normal, tap_guide.normal)
+                                * std::exp(-distance)};
+                    irradiance += weight * tap.irradiance;
+                    tap_variance += weight * weight * tap.variance;
+                    weight_sum += weight;
+                }
+            }
+            // Only a pixel whose samples' normals cancel out gives no weight
+            // even to itself.
+            if (weight_sum == 0) {
+                output[index] = input[index];
+                continue;
+            }
+            output[index] = FilterPixel{irradiance * (1 / weight_sum),
+                                        tap_variance
+                                                / (weight_sum * weight_sum)};
+        }
+    });
+}
+
+void denoise(const Film& film,
+             const FeatureBuffer& features,
+             ThreadPool& pool,
+             Film& output) {
+    auto width{film.width};
+    auto height{film.height};
+    std::vector<Guide> guides(film.pixels.size());
+    std::vector<FilterPixel> current(film.pixels.size());
+    pool.run(height, [&](auto y, auto) {
+        for (decltype(width) x{0}; x < width; ++x) {
+            const auto& pixel{film.at(x, y)};
+            const auto& feature{features.at(x, y)};
+            auto index{y * width + x};
+            auto& guide{guides[index]};
+            guide.has_samples = pixel.num_samples > 0;
+            if (!guide.has_samples) {
+                current[index] = FilterPixel{Radiance::black, 0};
+                continue;
+            }
+            guide.normal = BasicVector3<float>{
+                    static_cast<float>(feature.normal.x),
+                    static_cast<float>(feature.normal.y),
+                    static_cast<float>(feature.normal.z)};
+            guide.depth = feature.depth;
+            guide.depth_gradient_x
+                    = depth_gradient(features, film, x, y, 1, 0);
+            guide.depth_gradient_y
+                    = depth_gradient(features, film, x, y, 0, 1);
+
+            auto albedo{floored_albedo(feature.albedo)};
+            auto mean{pixel.mean()};
+            auto mean_luminance{mean.luminance()};
+            float variance{0};
+            if (pixel.num_samples > 1) {
+                auto n{static_cast<float>(pixel.num_samples)};
+                variance = std::max(pixel.luminance_squared_sum / n
+                                            - mean_luminance
+                                                      * mean_luminance,
+                                    0.0f)
+                           / (n - 1);
+            }
+            auto albedo_luminance{albedo.luminance()};
+            current[index] = FilterPixel{
+                    Radiance{mean.r / albedo.r,
+                             mean.g / albedo.g,
+                             mean.b / albedo.b},
+                    variance / (albedo_luminance * albedo_luminance)};
+        }
+    });
+
+    std::vector<FilterPixel> next(film.pixels.size());
+    for (std::size_t pass{0}; pass < num_passes; ++pass) {
+        filter_pass(current, guides, width, height, 1 << pass, pool, next);
+        std::swap(current, next);
+    }
+
+    for (std::size_t index{0}; index < film.pixels.size(); ++index) {
+        const auto& pixel{film.pixels[index]};
+        auto& denoised{output.pixels[index]};
+        auto color{current[index].irradiance
+                   * floored_albedo(features.pixels[index].albedo)};
+        auto n{static_cast<float>(pixel.num_samples)};
+        denoised.r = color.r * n;
+        denoised.g = color.g * n;
+        denoised.b = color.b * n;
+        denoised.luminance_squared_sum = pixel.luminance_squared_sum;
+        denoised.num_samples = pixel.num_samples;
+    }
+}
+
+}
@@ -0,0 +1,30 @@
+#ifndef DENOISER_H
+#define DENOISER_H
+
+#include "feature-buffer.h"
+#include "film.h"
+#include "thread-pool.h"
+
+namespace ray_tracing {
+
+// Filters the noise out of a render with few samples per pixel with the
+// edge-avoiding a-trous wavelet transform of Dammertz et al., guided as in
+// Schied et al.'s SVGF. The irradiance, the color divided by the albedo of
+// `features`, is blurred by a 5x5 kernel spread twice as wide in every
+// pass, which covers a large footprint with few taps, while the weights of
+// neighbours whose normal, depth or luminance differ fall off, so that
+// edges, and any detail brighter than the noise estimated from each
+// pixel's samples, survive. The albedo is multiplied back in at the end,
+// which keeps the texture of surfaces sharp.
+//
+// Writes the result to `output`, of the same size as `film`, with the
+// sample counts and luminance statistics of `film`. Pixels without samples
+// are left black.
+void denoise(const Film& film,
+             const FeatureBuffer& features,
+             ThreadPool& pool,
+             Film& output);
+
+}
+
+#endif
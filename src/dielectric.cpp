@@ -1,7 +1,5 @@
 #include "dielectric.h"
 
-#include "utils.h"
-
 #include <cmath>
 
 namespace ray_tracing {
@@ -11,8 +9,9 @@ Dielectric::Dielectric(Vector3::ValueType index_of_refraction)
 
 bool Dielectric::scatter(const Ray& incident,
                          const Hittable::HitInfo& hit_info,
+                         const ScatterSample& sample,
                          Ray& scattered,
-                         Color& attenuation) const {
+                         Radiance& attenuation) const {
     auto front_face{Vector3::dot(incident.direction, hit_info.normal) < 0};
     auto refraction_ratio{front_face ? 1 / index_of_refraction
                                      : index_of_refraction};
@@ -22,7 +21,8 @@ bool Dielectric::scatter(const Ray& incident,
                       1)};
     auto sin_theta{std::sqrt(1 - cos_theta * cos_theta)};
     if (refraction_ratio * sin_theta > 1
-        || reflectance(cos_theta, refraction_ratio) > random_double()) {
+        || reflectance(cos_theta, refraction_ratio)
+                   > sample.choice) {
         scattered = Ray{hit_info.point,
                         reflect(incident.direction, normal_against_ray)};
     } else {
@@ -31,7 +31,7 @@ bool Dielectric::scatter(const Ray& incident,
                                 normal_against_ray,
                                 refraction_ratio)};
     }
-    attenuation = Color::white;
+    attenuation = Radiance::white;
     return true;
 }
 
@@ -1,19 +1,23 @@
 #ifndef DIELECTRIC_H
 #define DIELECTRIC_H
 
-#include "material.h"
+#include "hittable.h"
+#include "radiance.h"
+#include "ray.h"
+#include "sampler.h"
 #include "vector3.h"
 
 namespace ray_tracing {
 
-class Dielectric : public Material {
+class Dielectric {
 public:
     Dielectric(Vector3::ValueType index_of_refraction);
 
     bool scatter(const Ray& incident,
                  const Hittable::HitInfo& hit_info,
+                 const ScatterSample& sample,
                  Ray& scattered,
-                 Color& attenuation) const override;
+                 Radiance& attenuation) const;
 
 private:
     static Vector3::ValueType reflectance(Vector3::ValueType cos,
@@ -0,0 +1,26 @@
+#include "diffuse-light.h"
+
+namespace ray_tracing {
+
+DiffuseLight::DiffuseLight(const Radiance& radiance) : radiance{radiance} {}
+
+bool DiffuseLight::scatter(const Ray&,
+                           const Hittable::HitInfo&,
+                           const ScatterSample&,
+                           Ray&,
+                           Radiance&) const {
+    return false;
+}
+
+Radiance DiffuseLight::emitted(const Ray& incident,
+                               const Hittable::HitInfo& hit_info) const {
+    return Vector3::dot(incident.direction, hit_info.normal) < 0
+                   ? radiance
+                   : Radiance::black;
+}
+
+Radiance DiffuseLight::emitted() const {
+    return radiance;
+}
+
+}
@@ -0,0 +1,36 @@
+#ifndef DIFFUSE_LIGHT_H
+#define DIFFUSE_LIGHT_H
+
+#include "hittable.h"
+#include "radiance.h"
+#include "ray.h"
+#include "sampler.h"
+
+namespace ray_tracing {
+
+// An emitter of the same radiance in every direction from the front of the
+// surface, the side its normal faces, that absorbs all light arriving.
+class DiffuseLight {
+public:
+    DiffuseLight(const Radiance& radiance);
+
+    // Never scatters.
+    bool scatter(const Ray& incident,
+                 const Hittable::HitInfo& hit_info,
+                 const ScatterSample& sample,
+                 Ray& scattered,
+                 Radiance& attenuation) const;
+
+    // Black when `incident` arrives at the back.
+    Radiance emitted(const Ray& incident,
+                     const Hittable::HitInfo& hit_info) const;
+
+    Radiance emitted() const;
+
+private:
+    Radiance radiance;
+};
+
+}
+
+#endif
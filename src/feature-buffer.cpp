@@ -0,0 +1,17 @@
+#include "feature-buffer.h"
+
+namespace ray_tracing {
+
+FeatureBuffer::FeatureBuffer(std::size_t width, std::size_t height)
+    : width{width}, height{height}, pixels(width * height) {}
+
+FeatureBuffer::Pixel& FeatureBuffer::at(std::size_t x, std::size_t y) {
+    return pixels[y * width + x];
+}
+
+const FeatureBuffer::Pixel& FeatureBuffer::at(std::size_t x,
+                                              std::size_t y) const {
+    return pixels[y * width + x];
+}
+
+}
@@ -0,0 +1,55 @@
+#ifndef FEATURE_BUFFER_H
+#define FEATURE_BUFFER_H
+
+#include "radiance.h"
+#include "vector3.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace ray_tracing {
+
+// The features that can be written out next to the color, as arbitrary
+// output variables for compositing and debugging.
+enum class Aov { albedo, normal, depth, material_id, object_id };
+
+// What the camera sees of the surfaces behind every pixel, averaged over a
+// few of its samples, which the denoiser tells edges apart by and which can
+// be written out as AOVs. Specular surfaces are looked through, to the
+// first other surface they show.
+struct FeatureBuffer {
+    struct Pixel {
+        // Of that surface, attenuated by the specular ones on the way.
+        Radiance albedo{Radiance::white};
+
+        // Unit length, facing the camera.
+        Vector3 normal{Vector3::zero};
+
+        // The length of the path to the surface, or zero for the sky.
+        float depth{0};
+
+        // Of the surface the first sample's camera ray hits first, specular
+        // or not, counted from 1, with 0 for the sky. Ids cannot be
+        // averaged, so they are not.
+        std::uint32_t material_id{0};
+
+        std::uint32_t object_id{0};
+    };
+
+    FeatureBuffer(std::size_t width, std::size_t height);
+
+    Pixel& at(std::size_t x, std::size_t y);
+
+    const Pixel& at(std::size_t x, std::size_t y) const;
+
+    std::size_t width;
+
+    std::size_t height;
+
+    std::vector<Pixel> pixels;
+};
+
+}
+
+#endif
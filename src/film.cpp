@@ -0,0 +1,72 @@
+#include "film.h"
+
+#include "utils.h"
+
+#include <algorithm>
+
+#include <cmath>
+
+namespace ray_tracing {
+
+void Film::Pixel::add(const Radiance& radiance) {
+    r += radiance.r;
+    g += radiance.g;
+    b += radiance.b;
+    auto sample_luminance{radiance.luminance()};
+    luminance_squared_sum += sample_luminance * sample_luminance;
+    ++num_samples;
+}
+
+Radiance Film::Pixel::mean() const {
+    if (num_samples == 0) {
+        return Radiance::black;
+    }
+    return Radiance{r / num_samples, g / num_samples, b / num_samples};
+}
+
+float Film::Pixel::relative_error() const {
+    if (num_samples < 2) {
+        return infinity;
+    }
+    auto mean_luminance{Radiance{r, g, b}.luminance() / num_samples};
+    auto variance{(luminance_squared_sum / num_samples
+                   - mean_luminance * mean_luminance)
+                  * num_samples / (num_samples - 1)};
+    auto standard_error{std::sqrt(std::max(variance, 0.0f) / num_samples)};
+    return standard_error / std::max(mean_luminance, 1.0f / 256);
+}
+
+Film::Film(std::size_t width, std::size_t height)
+    : width{width}, height{height}, pixels(width * height) {}
+
+Film::Pixel& Film::at(std::size_t x, std::size_t y) {
+    return pixels[y * width + x];
+}
+
+const Film::Pixel& Film::at(std::size_t x, std::size_t y) const {
+    return pixels[y * width + x];
+}
+
+std::uint64_t Film::num_samples() const {
+    std::uint64_t total{0};
+    for (const auto& pixel : pixels) {
+        total += pixel.num_samples;
+    }
+    return total;
+}
+
+void Film::resolve(std::size_t row_begin,
+                   std::size_t row_end,
+                   float* image) const {
+    for (auto y{row_begin}; y < row_end; ++y) {
+        for (auto x{decltype(width){0}}; x < width; ++x) {
+            auto mean{at(x, y).mean()};
+            auto index{((y - row_begin) * width + x) * num_channels};
+            image[index] = mean.r;
+            image[index + 1] = mean.g;
+            image[index + 2] = mean.b;
+        }
+    }
+}
+
+}
@@ -0,0 +1,61 @@
+#ifndef FILM_H
+#define FILM_H
+
+#include "radiance.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace ray_tracing {
+
+// Accumulates the samples of every pixel in floating point, together with
+// the statistics needed to estimate how noisy each pixel still is.
+struct Film {
+    struct Pixel {
+        void add(const Radiance& radiance);
+
+        Radiance mean() const;
+
+        // The standard error of the mean luminance relative to the mean
+        // itself, with dark pixels judged against a floor of 1/256.
+        float relative_error() const;
+
+        float r{0};
+
+        float g{0};
+
+        float b{0};
+
+        float luminance_squared_sum{0};
+
+        std::uint32_t num_samples{0};
+    };
+
+    static constexpr std::size_t num_channels{3};
+
+    Film(std::size_t width, std::size_t height);
+
+    Pixel& at(std::size_t x, std::size_t y);
+
+    const Pixel& at(std::size_t x, std::size_t y) const;
+
+    std::uint64_t num_samples() const;
+
+    // Writes the linear mean of rows `[row_begin, row_end)` into the float
+    // RGB `image`, which holds just those rows, for `ToneMapper` or a
+    // floating point file format to take from there.
+    void resolve(std::size_t row_begin,
+                 std::size_t row_end,
+                 float* image) const;
+
+    std::size_t width;
+
+    std::size_t height;
+
+    std::vector<Pixel> pixels;
+};
+
+}
+
+#endif
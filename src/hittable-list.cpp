@@ -22,15 +22,25 @@ bool HittableList::hit(const Ray& ray,
     auto closest_distance{max_distance};
 
     for (const auto& hittable_ptr : hittable_ptrs) {
-        HitInfo temp;
-        if (hittable_ptr->hit(ray, temp, min_distance, closest_distance)) {
+        if (hittable_ptr->hit(ray, hit_info, min_distance, closest_distance)) {
             hit_anything = true;
-            closest_distance = temp.distance;
-            hit_info = temp;
+            closest_distance = hit_info.distance;
         }
     }
 
     return hit_anything;
 }
 
+BoundingBox HittableList::bounding_box() const {
+    auto box{BoundingBox::empty};
+    for (const auto& hittable_ptr : hittable_ptrs) {
+        box.expand(hittable_ptr->bounding_box());
+    }
+    return box;
+}
+
+const std::vector<std::shared_ptr<Hittable>>& HittableList::hittables() const {
+    return hittable_ptrs;
+}
+
 }
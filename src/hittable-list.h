@@ -25,6 +25,10 @@ public:
              Vector3::ValueType min_distance,
              Vector3::ValueType max_distance) const override;
 
+    BoundingBox bounding_box() const override;
+
+    const std::vector<std::shared_ptr<Hittable>>& hittables() const;
+
 private:
     std::vector<std::shared_ptr<Hittable>> hittable_ptrs;
 };
@@ -2,12 +2,22 @@
 
 #include "utils.h"
 
+#include <type_traits>
+
 namespace ray_tracing {
 
+static_assert(std::is_trivially_copyable_v<Hittable::HitInfo>);
+
 bool Hittable::hit(const Ray& ray, HitInfo& hit_info) const {
-    constexpr auto default_min_distance{0.001};
-    constexpr auto default_max_distance{infinity};
-    return hit(ray, hit_info, default_min_distance, default_max_distance);
+    return hit(ray, hit_info, default_min_distance, infinity);
+}
+
+void Hittable::hit_packet(const RayPacket& packet,
+                          HitInfo* hit_infos,
+                          bool* hits) const {
+    for (auto i{decltype(packet.size){0}}; i < packet.size; ++i) {
+        hits[i] = hit(packet.rays[i], hit_infos[i]);
+    }
 }
 
 }
@@ -1,17 +1,24 @@
 #ifndef HITTABLE_H
 #define HITTABLE_H
 
+#include "bounding-box.h"
+#include "ray-packet.h"
 #include "ray.h"
 #include "vector3.h"
 
-#include <memory>
+#include <cstdint>
 
 namespace ray_tracing {
 
-class Material;
-
 class Hittable {
 public:
+    static constexpr Vector3::ValueType default_min_distance{0.001f};
+
+    // Plain data, so that it can be copied around the hot loops freely. The
+    // material is an index into the scene's material table. The object only
+    // tells what was hit apart in the output: the index of a sphere in the
+    // order the spheres were added, or of an instance, counted after the
+    // spheres.
     struct HitInfo {
         Vector3 point;
 
@@ -19,9 +26,12 @@ public:
 
         Vector3::ValueType distance;
 
-        std::shared_ptr<Material> material_ptr;
+        std::uint32_t material_id;
+
+        std::uint32_t object_id;
     };
 
+    // Leaves `hit_info` untouched if nothing is hit.
     virtual bool hit(const Ray& ray,
                      HitInfo& hit_info,
                      Vector3::ValueType min_distance,
@@ -29,6 +39,15 @@ public:
             = 0;
 
     virtual bool hit(const Ray& ray, HitInfo& hit_info) const;
+
+    // Intersects every ray of `packet` over the default distance range,
+    // setting `hits[i]` and `hit_infos[i]` for the i-th ray. The default
+    // implementation traces the rays one at a time.
+    virtual void hit_packet(const RayPacket& packet,
+                            HitInfo* hit_infos,
+                            bool* hits) const;
+
+    virtual BoundingBox bounding_box() const = 0;
 };
 
 }
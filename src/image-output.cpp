@@ -0,0 +1,646 @@
+#include "image-output.h"
+
+#include <strings.h>
+#include <unistd.h>
+#include <zlib.h>
+
+#include <algorithm>
+#include <iostream>
+#include <limits>
+#include <utility>
+
+#include <cstdlib>
+#include <cstring>
+
+namespace ray_tracing {
+
+static constexpr std::uint8_t png_signature[8]{0x89, 'P', 'N', 'G',
+                                               '\r', '\n', 0x1a, '\n'};
+
+// A zlib header announcing a 32 KiB window and the default level.
+static constexpr std::uint8_t zlib_header[2]{0x78, 0x9c};
+
+static constexpr std::uint8_t exr_magic[4]{0x76, 0x2f, 0x31, 0x01};
+
+static constexpr std::int32_t exr_uint{0};
+
+static constexpr std::int32_t exr_half{1};
+
+static constexpr std::int32_t exr_float{2};
+
+static bool has_extension(const char* filename, const char* extension) {
+    auto length{std::strlen(filename)};
+    auto extension_length{std::strlen(extension)};
+    return length >= extension_length
+           && strcasecmp(filename + length - extension_length, extension)
+                      == 0;
+}
+
+bool image_format(const char* filename, ImageFormat& format) {
+    if (has_extension(filename, ".png")) {
+        format = ImageFormat::png;
+    } else if (has_extension(filename, ".pfm")) {
+        format = ImageFormat::pfm;
+    } else if (has_extension(filename, ".exr")) {
+        format = ImageFormat::exr;
+    } else {
+        std::cerr << "Unsupported image format: " << filename
+                  << ". Use .png, .pfm or .exr.\n";
+        return false;
+    }
+    return true;
+}
+
+static void append_big_endian(std::vector<std::uint8_t>& buffer,
+                              std::uint32_t value) {
+    for (auto shift{24}; shift >= 0; shift -= 8) {
+        buffer.emplace_back(static_cast<std::uint8_t>(value >> shift));
+    }
+}
+
+// EXR is little-endian throughout, like the machines this runs on.
+template <typename T>
+static void append_value(std::vector<std::uint8_t>& buffer, T value) {
+    auto bytes{reinterpret_cast<const std::uint8_t*>(&value)};
+    buffer.insert(buffer.end(), bytes, bytes + sizeof(value));
+}
+
+static void append_string(std::vector<std::uint8_t>& buffer,
+                          const char* text) {
+    buffer.insert(buffer.end(), text, text + std::strlen(text) + 1);
+}
+
+template <typename Value>
+static void append_attribute(std::vector<std::uint8_t>& buffer,
+                             const char* name,
+                             const char* type,
+                             std::int32_t size,
+                             const Value& value) {
+    append_string(buffer, name);
+    append_string(buffer, type);
+    append_value(buffer, size);
+    value(buffer);
+}
+
+// Rounds to the nearest half, ties to even, with overflow going to infinity
+// and NaN staying NaN.
+static std::uint16_t to_half(float value) {
+    std::uint32_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    auto sign{static_cast<std::uint32_t>((bits >> 16) & 0x8000)};
+    auto biased_exponent{static_cast<int>((bits >> 23) & 0xff)};
+    auto mantissa{bits & 0x7fffff};
+    if (biased_exponent == 0xff) {
+        return static_cast<std::uint16_t>(sign | 0x7c00
+                                          | (mantissa ? 0x200 : 0));
+    }
+    auto exponent{biased_exponent - 127 + 15};
+    if (exponent >= 31) {
+        return static_cast<std::uint16_t>(sign | 0x7c00);
+    }
+    if (exponent <= 0) {
+        if (exponent < -10) {
+            return static_cast<std::uint16_t>(sign);
+        }
+        mantissa |= 0x800000;
+        auto shift{static_cast<std::uint32_t>(14 - exponent)};
+        auto half{mantissa >> shift};
+        auto remainder{mantissa & ((1u << shift) - 1)};
+        auto halfway{1u << (shift - 1)};
+        if (remainder > halfway || (remainder == halfway && (half & 1))) {
+            ++half;
+        }
+        return static_cast<std::uint16_t>(sign | half);
+    }
+    auto half{(static_cast<std::uint32_t>(exponent) << 10)
+              | (mantissa >> 13)};
+    auto remainder{mantissa & 0x1fff};
+    // A carry out of the mantissa correctly bumps the exponent, up to
+    // infinity.
+    if (remainder > 0x1000 || (remainder == 0x1000 && (half & 1))) {
+        ++half;
+    }
+    return static_cast<std::uint16_t>(sign | half);
+}
+
+static std::uint8_t paeth_predictor(int a, int b, int c) {
+    auto p{a + b - c};
+    auto pa{std::abs(p - a)};
+    auto pb{std::abs(p - b)};
+    auto pc{std::abs(p - c)};
+    if (pa <= pb && pa <= pc) {
+        return static_cast<std::uint8_t>(a);
+    }
+    return static_cast<std::uint8_t>(pb <= pc ? b : c);
+}
+
+// Filters `row` with each of the five PNG filters and keeps the one whose
+// output has the smallest sum of absolute values, as libpng does, writing
+// the filter type and the filtered bytes to `output`. Without a `previous`
+// row only None and Sub are tried, since the others predict from the row
+// above, which may belong to a band that is still being rendered.
+static void filter_row(const std::uint8_t* row,
+                       const std::uint8_t* previous,
+                       std::size_t size,
+                       std::uint8_t* output,
+                       std::vector<std::uint8_t>& candidate) {
+    constexpr auto bytes_per_pixel{Film::num_channels};
+
+    auto best_cost{std::numeric_limits<std::size_t>::max()};
+    candidate.resize(size);
+    auto num_filters{previous ? 5 : 2};
+    for (std::uint8_t filter{0}; filter < num_filters; ++filter) {
+        std::size_t cost{0};
+        for (std::size_t i{0}; i < size; ++i) {
+            int a{i >= bytes_per_pixel ? row[i - bytes_per_pixel] : 0};
+            int b{previous ? previous[i] : 0};
+            int c{previous && i >= bytes_per_pixel
+                          ? previous[i - bytes_per_pixel]
+                          : 0};
+            std::uint8_t prediction{0};
+            switch (filter) {
+            case 1:
+                prediction = static_cast<std::uint8_t>(a);
+                break;
+            case 2:
+                prediction = static_cast<std::uint8_t>(b);
+                break;
+            case 3:
+                prediction = static_cast<std::uint8_t>((a + b) / 2);
+                break;
+            case 4:
+                prediction = paeth_predictor(a, b, c);
+                break;
+            }
+            candidate[i] = static_cast<std::uint8_t>(row[i] - prediction);
+            cost += std::abs(static_cast<std::int8_t>(candidate[i]));
+        }
+        if (cost < best_cost) {
+            best_cost = cost;
+            output[0] = filter;
+            std::copy(candidate.begin(), candidate.end(), output + 1);
+        }
+    }
+}
+
+ImageOutput::ImageOutput(const char* filename,
+                         std::string temporary_filename,
+                         const Film& film,
+                         const ToneMapper& tone_mapper,
+                         std::size_t band_height,
+                         bool half_float,
+                         const FeatureBuffer* features,
+                         std::vector<Aov> aovs)
+    : filename{filename},
+      temporary_filename{std::move(temporary_filename)},
+      film{film},
+      tone_mapper{tone_mapper},
+      band_height{band_height},
+      half_float{half_float},
+      features{features},
+      aovs{std::move(aovs)},
+      bands((film.height + band_height - 1) / band_height) {
+    for (std::size_t i{0}; i < bands.size(); ++i) {
+        auto rows{std::min(band_height, film.height - i * band_height)};
+        bands[i].num_pending_pixels = rows * film.width;
+    }
+}
+
+ImageOutput::~ImageOutput() {
+    if (file) {
+        std::fclose(file);
+        std::remove(temporary_filename.c_str());
+    }
+}
+
+bool ImageOutput::open() {
+    if (!image_format(filename, format)) {
+        return false;
+    }
+    file = std::fopen(temporary_filename.c_str(), "wb");
+    if (!file) {
+        std::cerr << "Failed to open file: " << temporary_filename << ".\n";
+        return false;
+    }
+
+    auto written{false};
+    switch (format) {
+    case ImageFormat::png:
+        written = write_png_header();
+        break;
+    case ImageFormat::pfm:
+        // A negative scale marks little-endian floats. Rows go from the
+        // bottom of the image to the top.
+        written = std::fprintf(file,
+                               "PF\n%zu %zu\n-1.0\n",
+                               film.width,
+                               film.height)
+                  > 0;
+        data_offset = static_cast<std::size_t>(std::ftell(file));
+        break;
+    case ImageFormat::exr:
+        make_channels();
+        written = write_exr_header();
+        break;
+    }
+    if (!written || std::fflush(file) != 0) {
+        std::cerr << "Failed to write file: " << temporary_filename << ".\n";
+        return false;
+    }
+    return true;
+}
+
+void ImageOutput::finish_tile(const Tile& tile) {
+    auto tile_width{tile.x_end - tile.x_begin};
+    for (auto band_index{tile.y_begin / band_height};
+         band_index * band_height < tile.y_end;
+         ++band_index) {
+        auto row_begin{std::max(tile.y_begin, band_index * band_height)};
+        auto row_end{std::min(tile.y_end, (band_index + 1) * band_height)};
+        auto num_pixels{(row_end - row_begin) * tile_width};
+        if (bands[band_index].num_pending_pixels.fetch_sub(num_pixels)
+            == num_pixels) {
+            encode_band(band_index);
+        }
+    }
+}
+
+bool ImageOutput::close(ThreadPool* pool) {
+    std::vector<std::size_t> pending_bands;
+    for (std::size_t i{0}; i < bands.size(); ++i) {
+        if (bands[i].num_pending_pixels > 0) {
+            bands[i].num_pending_pixels = 0;
+            pending_bands.push_back(i);
+        }
+    }
+    // The bands are taken in order, so the ones at the top are done first
+    // and can be appended while the rest are still being deflated.
+    auto encode_pending{[&](std::size_t task_index, std::size_t) {
+        encode_band(pending_bands[task_index]);
+    }};
+    if (pool) {
+        pool->run(pending_bands.size(), encode_pending);
+    } else {
+        for (std::size_t i{0}; i < pending_bands.size(); ++i) {
+            encode_pending(i, 0);
+        }
+    }
+
+    if (format == ImageFormat::png && !failed) {
+        auto adler{adler32(0, nullptr, 0)};
+        auto row_size{1 + film.width * Film::num_channels};
+        for (std::size_t i{0}; i < bands.size(); ++i) {
+            auto rows{std::min(band_height, film.height - i * band_height)};
+            adler = adler32_combine(adler,
+                                    bands[i].adler,
+                                    static_cast<z_off_t>(rows * row_size));
+        }
+        std::vector<std::uint8_t> trailer;
+        append_big_endian(trailer, static_cast<std::uint32_t>(adler));
+        if (!append_chunk("IDAT", trailer.data(), trailer.size())
+            || !append_chunk("IEND", nullptr, 0)) {
+            failed = true;
+        }
+    }
+
+    auto closed{std::fclose(file) == 0};
+    file = nullptr;
+    if (!closed || failed) {
+        std::cerr << "Failed to write file: " << temporary_filename << ".\n";
+        std::remove(temporary_filename.c_str());
+        return false;
+    }
+    if (std::rename(temporary_filename.c_str(), filename) != 0) {
+        std::cerr << "Failed to replace file: " << filename << ".\n";
+        return false;
+    }
+    return true;
+}
+
+std::size_t ImageOutput::num_bands() const {
+    return bands.size();
+}
+
+void ImageOutput::encode_band(std::size_t band_index) {
+    if (format != ImageFormat::png) {
+        if (!write_rows(band_index)) {
+            failed = true;
+        }
+        bands[band_index].encoded = true;
+        return;
+    }
+
+    std::uint32_t adler;
+    auto data{deflate_band(band_index, adler)};
+    std::lock_guard<std::mutex> lock{write_mutex};
+    auto& band{bands[band_index]};
+    band.data = std::move(data);
+    band.adler = adler;
+    band.encoded = true;
+    write_finished_bands();
+}
+
+std::vector<std::uint8_t> ImageOutput::deflate_band(
+        std::size_t band_index,
+        std::uint32_t& adler) const {
+    auto row_begin{band_index * band_height};
+    auto row_end{std::min(row_begin + band_height, film.height)};
+    auto row_size{film.width * Film::num_channels};
+
+    std::vector<float> linear((row_end - row_begin) * row_size);
+    std::vector<std::uint8_t> rgb(linear.size());
+    film.resolve(row_begin, row_end, linear.data());
+    tone_mapper.to_rgb8(linear.data(),
+                        (row_end - row_begin) * film.width,
+                        rgb.data());
+
+    std::vector<std::uint8_t> filtered((row_end - row_begin)
+                                       * (1 + row_size));
+    std::vector<std::uint8_t> candidate;
+    for (auto y{row_begin}; y < row_end; ++y) {
+        auto row{rgb.data() + (y - row_begin) * row_size};
+        filter_row(row,
+                   y > row_begin ? row - row_size : nullptr,
+                   row_size,
+                   filtered.data() + (y - row_begin) * (1 + row_size),
+                   candidate);
+    }
+    adler = static_cast<std::uint32_t>(
+            adler32(adler32(0, nullptr, 0),
+                    filtered.data(),
+                    static_cast<uInt>(filtered.size())));
+
+    // Raw deflate, since the zlib header and checksum of the whole stream
+    // are written separately. Every band but the last ends on a byte
+    // boundary with a sync flush so that the next one can follow it.
+    z_stream stream{};
+    deflateInit2(&stream,
+                 Z_DEFAULT_COMPRESSION,
+                 Z_DEFLATED,
+                 -15,
+                 8,
+                 Z_FILTERED);
+    std::vector<std::uint8_t> compressed(
+            deflateBound(&stream, static_cast<uLong>(filtered.size())) + 16);
+    stream.next_in = filtered.data();
+    stream.avail_in = static_cast<uInt>(filtered.size());
+    stream.next_out = compressed.data();
+    stream.avail_out = static_cast<uInt>(compressed.size());
+    auto flush{band_index + 1 == num_bands() ? Z_FINISH : Z_SYNC_FLUSH};
+    while (deflate(&stream, flush) == Z_OK && stream.avail_out == 0) {
+        auto size{compressed.size()};
+        compressed.resize(2 * size);
+        stream.next_out = compressed.data() + size;
+        stream.avail_out = static_cast<uInt>(size);
+    }
+    compressed.resize(stream.total_out);
+    deflateEnd(&stream);
+    return compressed;
+}
+
+bool ImageOutput::write_png_header() {
+    std::vector<std::uint8_t> header;
+    append_big_endian(header, static_cast<std::uint32_t>(film.width));
+    append_big_endian(header, static_cast<std::uint32_t>(film.height));
+    // 8 bits per channel, RGB, deflate, adaptive filtering, no interlacing.
+    header.insert(header.end(), {8, 2, 0, 0, 0});
+    return std::fwrite(png_signature, sizeof(png_signature), 1, file) == 1
+           && append_chunk("IHDR", header.data(), header.size())
+           && append_chunk("IDAT", zlib_header, sizeof(zlib_header));
+}
+
+static std::size_t pixel_type_size(std::int32_t pixel_type) {
+    return pixel_type == exr_half ? sizeof(std::uint16_t) : sizeof(float);
+}
+
+// The value of a float channel of a feature.
+static float feature_value(const FeatureBuffer::Pixel& pixel,
+                           Aov aov,
+                           std::size_t component) {
+    switch (aov) {
+    case Aov::albedo: {
+        const float components[]{pixel.albedo.r,
+                                 pixel.albedo.g,
+                                 pixel.albedo.b};
+        return components[component];
+    }
+    case Aov::normal: {
+        const Vector3::ValueType components[]{pixel.normal.x,
+                                              pixel.normal.y,
+                                              pixel.normal.z};
+        return static_cast<float>(components[component]);
+    }
+    default:
+        return pixel.depth;
+    }
+}
+
+void ImageOutput::make_channels() {
+    auto float_type{half_float ? exr_half : exr_float};
+    channels = {{"B", float_type, true, Aov::albedo, 2},
+                {"G", float_type, true, Aov::albedo, 1},
+                {"R", float_type, true, Aov::albedo, 0}};
+    if (!features) {
+        return;
+    }
+    for (auto aov : aovs) {
+        switch (aov) {
+        case Aov::albedo:
+            channels.push_back({"albedo.B", float_type, false, aov, 2});
+            channels.push_back({"albedo.G", float_type, false, aov, 1});
+            channels.push_back({"albedo.R", float_type, false, aov, 0});
+            break;
+        case Aov::normal:
+            channels.push_back({"N.X", float_type, false, aov, 0});
+            channels.push_back({"N.Y", float_type, false, aov, 1});
+            channels.push_back({"N.Z", float_type, false, aov, 2});
+            break;
+        case Aov::depth:
+            channels.push_back({"Z", exr_float, false, aov, 0});
+            break;
+        case Aov::material_id:
+            channels.push_back({"material_id", exr_uint, false, aov, 0});
+            break;
+        case Aov::object_id:
+            channels.push_back({"object_id", exr_uint, false, aov, 0});
+            break;
+        }
+    }
+    std::sort(channels.begin(),
+              channels.end(),
+              [](const auto& lhs, const auto& rhs) {
+                  return std::strcmp(lhs.name, rhs.name) < 0;
+              });
+}
+
+bool ImageOutput::write_exr_header() {
+    auto width{static_cast<std::int32_t>(film.width)};
+    auto height{static_cast<std::int32_t>(film.height)};
+    std::vector<std::uint8_t> header(exr_magic, exr_magic + 4);
+    // Version 2, single-part scanline image with short attribute names.
+    append_value(header, std::int32_t{2});
+
+    // Each channel is its name, its pixel type, a linear flag with three
+    // bytes of padding and its sampling along x and y, and the list ends
+    // with an empty name.
+    std::int32_t channels_size{1};
+    for (const auto& channel : channels) {
+        channels_size += static_cast<std::int32_t>(std::strlen(channel.name))
+                         + 1 + 16;
+    }
+    auto append_channels{[&](auto& buffer) {
+        for (const auto& channel : channels) {
+            append_string(buffer, channel.name);
+            append_value(buffer, channel.pixel_type);
+            append_value(buffer, std::int32_t{0});
+            append_value(buffer, std::int32_t{1});
+            append_value(buffer, std::int32_t{1});
+        }
+        buffer.emplace_back(0);
+    }};
+    append_attribute(header,
+                     "channels",
+                     "chlist",
+                     channels_size,
+                     append_channels);
+    append_attribute(header, "compression", "compression", 1, [](auto& b) {
+        b.emplace_back(0);
+    });
+    auto append_window{[&](auto& buffer) {
+        append_value(buffer, std::int32_t{0});
+        append_value(buffer, std::int32_t{0});
+        append_value(buffer, width - 1);
+        append_value(buffer, height - 1);
+    }};
+    append_attribute(header, "dataWindow", "box2i", 16, append_window);
+    append_attribute(header, "displayWindow", "box2i", 16, append_window);
+    append_attribute(header, "lineOrder", "lineOrder", 1, [](auto& b) {
+        b.emplace_back(0);
+    });
+    append_attribute(header, "pixelAspectRatio", "float", 4, [](auto& b) {
+        append_value(b, 1.0f);
+    });
+    append_attribute(header, "screenWindowCenter", "v2f", 8, [](auto& b) {
+        append_value(b, 0.0f);
+        append_value(b, 0.0f);
+    });
+    append_attribute(header, "screenWindowWidth", "float", 4, [](auto& b) {
+        append_value(b, 1.0f);
+    });
+    header.emplace_back(0);
+
+    // Without compression every scanline is its own chunk of known size, so
+    // the offset table can be written up front.
+    data_offset = header.size() + film.height * sizeof(std::uint64_t);
+    auto chunk_size{2 * sizeof(std::int32_t)};
+    for (const auto& channel : channels) {
+        chunk_size += film.width * pixel_type_size(channel.pixel_type);
+    }
+    for (std::size_t y{0}; y < film.height; ++y) {
+        append_value(header,
+                     static_cast<std::uint64_t>(data_offset + y * chunk_size));
+    }
+    return std::fwrite(header.data(), header.size(), 1, file) == 1;
+}
+
+bool ImageOutput::write_rows(std::size_t band_index) {
+    auto row_begin{band_index * band_height};
+    auto row_end{std::min(row_begin + band_height, film.height)};
+    auto row_size{film.width * Film::num_channels};
+    std::vector<float> linear((row_end - row_begin) * row_size);
+    film.resolve(row_begin, row_end, linear.data());
+
+    std::vector<std::uint8_t> row;
+    for (auto y{row_begin}; y < row_end; ++y) {
+        const auto* pixels{linear.data() + (y - row_begin) * row_size};
+        row.clear();
+        std::size_t offset;
+        if (format == ImageFormat::pfm) {
+            row.resize(row_size * sizeof(float));
+            std::memcpy(row.data(), pixels, row.size());
+            offset = data_offset + (film.height - 1 - y) * row.size();
+        } else {
+            append_value(row, static_cast<std::int32_t>(y));
+            append_value(row, std::int32_t{0});
+            for (const auto& channel : channels) {
+                for (std::size_t x{0}; x < film.width; ++x) {
+                    if (channel.pixel_type == exr_uint) {
+                        const auto& pixel{features->at(x, y)};
+                        append_value(row,
+                                     channel.aov == Aov::material_id
+                                             ? pixel.material_id
+                                             : pixel.object_id);
+                        continue;
+                    }
+                    auto value{channel.is_color
+                                       ? pixels[x * Film::num_channels
+                                                + channel.component]
+                                       : feature_value(features->at(x, y),
+                                                       channel.aov,
+                                                       channel.component)};
+                    if (channel.pixel_type == exr_half) {
+                        append_value(row, to_half(value));
+                    } else {
+                        append_value(row, value);
+                    }
+                }
+            }
+            auto data_size{static_cast<std::int32_t>(
+                    row.size() - 2 * sizeof(std::int32_t))};
+            std::memcpy(row.data() + sizeof(std::int32_t),
+                        &data_size,
+                        sizeof(data_size));
+            offset = data_offset + y * row.size();
+        }
+        if (pwrite(fileno(file), row.data(), row.size(), offset)
+            != static_cast<ssize_t>(row.size())) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool ImageOutput::append_chunk(const char* type,
+                               const std::uint8_t* data,
+                               std::size_t size) {
+    std::vector<std::uint8_t> framing;
+    append_big_endian(framing, static_cast<std::uint32_t>(size));
+    framing.insert(framing.end(), type, type + 4);
+    auto crc{crc32(0, framing.data() + 4, 4)};
+    if (size > 0) {
+        crc = crc32(crc, data, static_cast<uInt>(size));
+    }
+    std::vector<std::uint8_t> crc_bytes;
+    append_big_endian(crc_bytes, static_cast<std::uint32_t>(crc));
+    return std::fwrite(framing.data(), framing.size(), 1, file) == 1
+           && (size == 0 || std::fwrite(data, size, 1, file) == 1)
+           && std::fwrite(crc_bytes.data(), crc_bytes.size(), 1, file) == 1;
+}
+
+void ImageOutput::write_finished_bands() {
+    while (next_band < bands.size() && bands[next_band].encoded) {
+        auto& band{bands[next_band]};
+        if (!append_chunk("IDAT", band.data.data(), band.data.size())) {
+            failed = true;
+        }
+        band.data = {};
+        ++next_band;
+    }
+}
+
+bool write_image(const char* filename,
+                 const Film& film,
+                 const ToneMapper& tone_mapper,
+                 std::size_t band_height,
+                 bool half_float,
+                 ThreadPool* pool) {
+    ImageOutput output{filename,
+                       std::string{filename} + ".tmp",
+                       film,
+                       tone_mapper,
+                       band_height,
+                       half_float};
+    return output.open() && output.close(pool);
+}
+
+}
@@ -0,0 +1,179 @@
+#ifndef IMAGE_OUTPUT_H
+#define IMAGE_OUTPUT_H
+
+#include "feature-buffer.h"
+#include "film.h"
+#include "thread-pool.h"
+#include "tile.h"
+#include "tone-mapper.h"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace ray_tracing {
+
+enum class ImageFormat {
+    // Tone mapped 8-bit sRGB.
+    png,
+    // Linear 32-bit float RGB.
+    pfm,
+    // Linear RGB in uncompressed scanlines of 16-bit half or 32-bit float.
+    exr
+};
+
+// Picks the format from the extension of `filename`, printing a message and
+// returning false if it is not one of .png, .pfm or .exr.
+bool image_format(const char* filename, ImageFormat& format);
+
+// Writes a film to an image file while it is still being rendered. The
+// image is split into bands of rows, and whichever thread finishes the last
+// pixels of a band encodes it right away, so the encoding is spread over the
+// rendering threads instead of being a serial tail after the render.
+//
+// For PNG each band is filtered and deflated on its own, as a segment of
+// the single zlib stream that ends with a sync flush, and the segments are
+// appended to the file as IDAT chunks as soon as all the bands above them
+// are there. PFM and EXR rows sit at fixed offsets, so their bands are
+// written in place as they come.
+//
+// The file is written under `temporary_filename` and only renamed to
+// `filename` by `close`.
+//
+// EXR files can also hold the `aovs` of `features`, as extra channels that
+// are written along with the color, so `features` must be complete before
+// the first band is. Ids are stored as 32-bit unsigned integers and depth
+// always as 32-bit floats, which keep it precise far from the camera.
+class ImageOutput {
+public:
+    ImageOutput(const char* filename,
+                std::string temporary_filename,
+                const Film& film,
+                const ToneMapper& tone_mapper,
+                std::size_t band_height,
+                bool half_float,
+                const FeatureBuffer* features = nullptr,
+                std::vector<Aov> aovs = {});
+
+    ImageOutput(const ImageOutput&) = delete;
+
+    ImageOutput& operator=(const ImageOutput&) = delete;
+
+    ~ImageOutput();
+
+    // Creates the file and writes everything that does not depend on the
+    // pixels. Prints a message and returns false on failure.
+    bool open();
+
+    // Marks the pixels of `tile` as final. Safe to call from several threads
+    // at once, as long as nothing writes to the pixels of finished tiles.
+    void finish_tile(const Tile& tile);
+
+    // Encodes the bands that are not finished yet from the pixels as they
+    // are, completes the file and moves it into place. The bands are encoded
+    // on the threads of `pool` if there is one, which must not be running
+    // anything else.
+    bool close(ThreadPool* pool = nullptr);
+
+private:
+    // A channel of an EXR file, which holds a component of the color or of
+    // one of the features.
+    struct Channel {
+        const char* name;
+
+        std::int32_t pixel_type;
+
+        bool is_color;
+
+        Aov aov;
+
+        std::size_t component;
+    };
+
+    struct Band {
+        // The pixels of the band not yet marked as final.
+        std::atomic<std::size_t> num_pending_pixels;
+
+        // The band's deflated rows and their Adler-32, for PNG.
+        std::vector<std::uint8_t> data;
+
+        std::uint32_t adler;
+
+        bool encoded{false};
+    };
+
+    std::size_t num_bands() const;
+
+    void encode_band(std::size_t band_index);
+
+    std::vector<std::uint8_t> deflate_band(std::size_t band_index,
+                                           std::uint32_t& adler) const;
+
+    bool write_png_header();
+
+    // Lists the channels of an EXR file in the alphabetical order they are
+    // stored in.
+    void make_channels();
+
+    bool write_exr_header();
+
+    bool write_rows(std::size_t band_index);
+
+    bool append_chunk(const char* type,
+                      const std::uint8_t* data,
+                      std::size_t size);
+
+    void write_finished_bands();
+
+    const char* filename;
+
+    std::string temporary_filename;
+
+    const Film& film;
+
+    const ToneMapper& tone_mapper;
+
+    std::size_t band_height;
+
+    bool half_float;
+
+    const FeatureBuffer* features;
+
+    std::vector<Aov> aovs;
+
+    ImageFormat format{ImageFormat::png};
+
+    std::vector<Channel> channels;
+
+    std::FILE* file{nullptr};
+
+    // Where the rows of PFM and EXR files start.
+    std::size_t data_offset{0};
+
+    std::vector<Band> bands;
+
+    // Guards appending to the file and `next_band`.
+    std::mutex write_mutex;
+
+    // The first band not yet appended to a PNG file.
+    std::size_t next_band{0};
+
+    std::atomic<bool> failed{false};
+};
+
+// Writes the whole film at once, as a preview or when it is already
+// rendered, encoding it on the threads of `pool` if there is one.
+bool write_image(const char* filename,
+                 const Film& film,
+                 const ToneMapper& tone_mapper,
+                 std::size_t band_height,
+                 bool half_float,
+                 ThreadPool* pool = nullptr);
+
+}
+
+#endif
@@ -0,0 +1,54 @@
+#include "instance.h"
+
+#include <utility>
+
+namespace ray_tracing {
+
+Instance::Instance(std::shared_ptr<const Hittable> object,
+                   const Transform& object_to_world)
+    : object{std::move(object)},
+      object_to_world{object_to_world},
+      world_to_object{object_to_world.inverse()},
+      bounds{object_to_world.apply(this->object->bounding_box())} {}
+
+void Instance::set_transform(const Transform& object_to_world) {
+    this->object_to_world = object_to_world;
+    world_to_object = object_to_world.inverse();
+    bounds = object_to_world.apply(object->bounding_box());
+}
+
+const Hittable& Instance::instanced() const {
+    return *object;
+}
+
+const Transform& Instance::transform() const {
+    return object_to_world;
+}
+
+bool Instance::hit(const Ray& ray,
+                   HitInfo& hit_info,
+                   Vector3::ValueType min_distance,
+                   Vector3::ValueType max_distance) const {
+    // `Ray` normalizes its direction, so distances in object space are
+    // longer by the length the world direction takes there.
+    auto object_direction{world_to_object.apply_vector(ray.direction)};
+    auto scale{object_direction.magnitude()};
+    Ray object_ray{world_to_object.apply_point(ray.origin), object_direction};
+    if (!object->hit(object_ray,
+                     hit_info,
+                     min_distance * scale,
+                     max_distance * scale)) {
+        return false;
+    }
+    hit_info.distance /= scale;
+    hit_info.point = ray.at(hit_info.distance);
+    hit_info.normal
+            = world_to_object.apply_transposed(hit_info.normal).normalized();
+    return true;
+}
+
+BoundingBox Instance::bounding_box() const {
+    return bounds;
+}
+
+}
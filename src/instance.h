@@ -0,0 +1,50 @@
+#ifndef INSTANCE_H
+#define INSTANCE_H
+
+#include "hittable.h"
+#include "transform.h"
+
+#include <memory>
+
+namespace ray_tracing {
+
+// Places a shared object, typically a `TriangleMesh` with its own BVH, in
+// the scene under a transform. Instances only hold the transform and a
+// reference to the object, so a forest of many instances of one tree costs
+// the memory of a single tree.
+//
+// Rays are moved into the object's space instead of the object into the
+// scene, and the distances along them scaled between the two spaces.
+class Instance : public Hittable {
+public:
+    // `object_to_world` must be invertible.
+    Instance(std::shared_ptr<const Hittable> object,
+             const Transform& object_to_world);
+
+    // Moves the instance. `object_to_world` must be invertible.
+    void set_transform(const Transform& object_to_world);
+
+    const Hittable& instanced() const;
+
+    const Transform& transform() const;
+
+    bool hit(const Ray& ray,
+             HitInfo& hit_info,
+             Vector3::ValueType min_distance,
+             Vector3::ValueType max_distance) const override;
+
+    BoundingBox bounding_box() const override;
+
+private:
+    std::shared_ptr<const Hittable> object;
+
+    Transform object_to_world;
+
+    Transform world_to_object;
+
+    BoundingBox bounds;
+};
+
+}
+
+#endif
@@ -1,22 +1,50 @@
 #include "lambertian.h"
 
-#include "utils.h"
+#include "warp.h"
 
 namespace ray_tracing {
 
-Lambertian::Lambertian(const Color& albedo) : albedo{albedo} {}
+static Vector3 facing_normal(const Ray& incident,
+                             const Hittable::HitInfo& hit_info) {
+    return Vector3::dot(incident.direction, hit_info.normal) > 0
+                   ? -hit_info.normal
+                   : hit_info.normal;
+}
+
+Lambertian::Lambertian(const Radiance& albedo) : albedo{albedo} {}
 
 bool Lambertian::scatter(const Ray& incident,
                          const Hittable::HitInfo& hit_info,
+                         const ScatterSample& sample,
                          Ray& scattered,
-                         Color& attenuation) const {
-    auto scatter_direction{hit_info.normal + random_unit_vector()};
-    if (is_vector_near_zero(scatter_direction)) {
-        scatter_direction = hit_info.normal;
-    }
-    scattered = Ray{hit_info.point, scatter_direction};
+                         Radiance& attenuation) const {
+    auto normal{facing_normal(incident, hit_info)};
+    Vector3 tangent;
+    Vector3 bitangent;
+    orthonormal_basis(normal, tangent, bitangent);
+    auto local{square_to_cosine_hemisphere(sample.direction.u,
+                                           sample.direction.v)};
+    scattered = Ray{hit_info.point,
+                    local.x * tangent + local.y * bitangent + local.z * normal};
     attenuation = albedo;
     return true;
 }
 
+Radiance Lambertian::evaluate(const Ray& incident,
+                              const Hittable::HitInfo& hit_info,
+                              const Vector3& direction,
+                              Vector3::ValueType& pdf) const {
+    auto cosine{Vector3::dot(facing_normal(incident, hit_info), direction)};
+    if (cosine <= 0) {
+        pdf = 0;
+        return Radiance::black;
+    }
+    pdf = cosine_hemisphere_pdf(cosine);
+    return static_cast<Radiance::ValueType>(pdf) * albedo;
+}
+
+Radiance Lambertian::reflectance() const {
+    return albedo;
+}
+
 }
@@ -1,22 +1,39 @@
 #ifndef LAMBERTIAN_H
 #define LAMBERTIAN_H
 
-#include "color.h"
-#include "material.h"
+#include "hittable.h"
+#include "radiance.h"
+#include "ray.h"
+#include "sampler.h"
+#include "vector3.h"
 
 namespace ray_tracing {
 
-class Lambertian : public Material {
+// Reflects equally in every direction of the hemisphere facing the incident
+// ray, whichever side of the surface that is.
+class Lambertian {
 public:
-    Lambertian(const Color& albedo);
+    Lambertian(const Radiance& albedo);
 
+    // Samples the cosine-weighted hemisphere.
     bool scatter(const Ray& incident,
                  const Hittable::HitInfo& hit_info,
+                 const ScatterSample& sample,
                  Ray& scattered,
-                 Color& attenuation) const override;
+                 Radiance& attenuation) const;
+
+    // Returns the reflectance towards `incident` of light arriving from the
+    // unit vector `direction`, weighted by its cosine, and sets `pdf` to
+    // the density with which `scatter` picks that direction.
+    Radiance evaluate(const Ray& incident,
+                      const Hittable::HitInfo& hit_info,
+                      const Vector3& direction,
+                      Vector3::ValueType& pdf) const;
+
+    Radiance reflectance() const;
 
 private:
-    Color albedo;
+    Radiance albedo;
 };
 
 }
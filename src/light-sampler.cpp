@@ -0,0 +1,88 @@
+#include "light-sampler.h"
+
+#include "utils.h"
+#include "warp.h"
+
+#include <utility>
+
+namespace ray_tracing {
+
+void LightSampler::add_sphere(const Vector3& center,
+                              Vector3::ValueType radius,
+                              const Radiance& radiance) {
+    auto area{static_cast<Vector3::ValueType>(4 * pi) * radius * radius};
+    lights.emplace_back(Light{Light::Shape::sphere,
+                              center,
+                              Vector3{radius, 0, 0},
+                              Vector3::zero,
+                              radiance,
+                              area});
+}
+
+void LightSampler::add_triangle(const Vector3& p0,
+                                const Vector3& p1,
+                                const Vector3& p2,
+                                const Radiance& radiance) {
+    auto edge1{p1 - p0};
+    auto edge2{p2 - p0};
+    auto area{Vector3::cross(edge1, edge2).magnitude() / 2};
+    lights.emplace_back(
+            Light{Light::Shape::triangle, p0, edge1, edge2, radiance, area});
+}
+
+void LightSampler::clear() {
+    lights.clear();
+    table = AliasTable{};
+    total_power = 0;
+}
+
+void LightSampler::build() {
+    // Lights too dim or too small to ever be picked are left out.
+    std::vector<Light> kept;
+    std::vector<double> powers;
+    total_power = 0;
+    for (const auto& light : lights) {
+        auto power{light.radiance.luminance() * light.area};
+        if (power > 0) {
+            kept.emplace_back(light);
+            powers.emplace_back(power);
+            total_power += power;
+        }
+    }
+    lights = std::move(kept);
+    table = lights.empty() ? AliasTable{} : AliasTable{powers};
+}
+
+bool LightSampler::empty() const {
+    return lights.empty();
+}
+
+std::size_t LightSampler::size() const {
+    return lights.size();
+}
+
+Vector3::ValueType LightSampler::sample(SampleStream& stream,
+                                        Vector3& point,
+                                        Vector3& normal,
+                                        Radiance& radiance) const {
+    const auto& light{lights[table.sample(stream.next_1d())]};
+    auto [u, v]{stream.next_2d()};
+    if (light.shape == Light::Shape::sphere) {
+        normal = square_to_uniform_sphere(u, v);
+        point = light.origin + light.edge1.x * normal;
+    } else {
+        Vector3::ValueType weight1;
+        Vector3::ValueType weight2;
+        square_to_triangle(u, v, weight1, weight2);
+        point = light.origin + weight1 * light.edge1 + weight2 * light.edge2;
+        normal = Vector3::cross(light.edge1, light.edge2).normalized();
+    }
+    radiance = light.radiance;
+    return area_pdf(radiance);
+}
+
+Vector3::ValueType LightSampler::area_pdf(const Radiance& radiance) const {
+    return total_power > 0 ? radiance.luminance() / total_power : 0;
+}
+
+}
@@ -0,0 +1,83 @@
+#ifndef LIGHT_SAMPLER_H
+#define LIGHT_SAMPLER_H
+
+#include "alias-table.h"
+#include "radiance.h"
+#include "sampler.h"
+#include "vector3.h"
+
+#include <cstddef>
+#include <vector>
+
+namespace ray_tracing {
+
+// The emitting surfaces of a scene, for picking points on them to send
+// shadow rays to. A light is chosen in proportion to its power, through an
+// alias table so that the choice costs the same with thousands of lights as
+// with one, and a point uniformly over its area.
+//
+// Choosing by power makes the density of a point, per unit of area, depend
+// only on the radiance of the light it lies on, so it can be found again
+// for a surface that a scattered ray hits without knowing which light that
+// is.
+class LightSampler {
+public:
+    void add_sphere(const Vector3& center,
+                    Vector3::ValueType radius,
+                    const Radiance& radiance);
+
+    // Emits on the side from which the corners wind counterclockwise.
+    void add_triangle(const Vector3& p0,
+                      const Vector3& p1,
+                      const Vector3& p2,
+                      const Radiance& radiance);
+
+    void clear();
+
+    // Must be called after adding lights and before sampling them.
+    void build();
+
+    bool empty() const;
+
+    std::size_t size() const;
+
+    // Picks a point on one of the lights, with one dimension of `stream`
+    // for the light and two for the point, and returns its density per
+    // unit of area.
+    Vector3::ValueType sample(SampleStream& stream,
+                              Vector3& point,
+                              Vector3& normal,
+                              Radiance& radiance) const;
+
+    // The density `sample` picks a point with on a light of `radiance`.
+    Vector3::ValueType area_pdf(const Radiance& radiance) const;
+
+private:
+    struct Light {
+        enum class Shape { sphere, triangle };
+
+        Shape shape;
+
+        // The center and, in `edge1.x`, the radius of a sphere, or the
+        // first corner and the edges to the other two of a triangle.
+        Vector3 origin;
+
+        Vector3 edge1;
+
+        Vector3 edge2;
+
+        Radiance radiance;
+
+        Vector3::ValueType area;
+    };
+
+    std::vector<Light> lights;
+
+    AliasTable table;
+
+    Vector3::ValueType total_power{0};
+};
+
+}
+
+#endif
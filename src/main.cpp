@@ -1,369 +1,424 @@
-#include "camera.h"
-#include "color.h"
-#include "dielectric.h"
-#include "hittable-list.h"
-#include "lambertian.h"
-#include "metal.h"
-#include "ray.h"
-#include "sphere.h"
-#include "utils.h"
-#include "vector3.h"
-
-#ifdef USE_OPENMP
-#include <omp.h>
-#endif
+#include "checkpoint.h"
+#include "denoiser.h"
+#include "feature-buffer.h"
+#include "film.h"
+#include "image-output.h"
+#include "options.h"
+#include "render-stats.h"
+#include "renderer.h"
+#include "scene-file.h"
+#include "scene.h"
+#include "thread-pool.h"
+#include "tone-mapper.h"
 
 #ifdef USE_MPI
 #include <mpi.h>
 #endif
 
-#include <png.h>
-
+#include <chrono>
 #include <iomanip>
 #include <iostream>
+#include <memory>
 #include <string>
-#include <utility>
+#include <thread>
 #include <vector>
 
-#include <cmath>
+#include <csignal>
 #include <cstdio>
+#include <cstring>
 
 using namespace ray_tracing;
 
-static constexpr auto num_channels{3};
+static volatile std::sig_atomic_t interrupt_requested{0};
 
-static Color::ValueType scale_256(Color::ValueType value) {
-    return std::floor(value == 1 ? 255 : value * 256);
+static void request_interrupt(int) {
+    interrupt_requested = 1;
 }
 
-static bool write_png(const char* filename,
-                      std::size_t width,
-                      std::size_t height,
-                      std::uint8_t* buffer) {
-    auto fp{fopen(filename, "wb")};
+static bool file_exists(const char* filename) {
+    auto fp{fopen(filename, "rb")};
     if (!fp) {
-        std::cerr << "Failed to open file: " << filename << ".\n";
         return false;
     }
+    fclose(fp);
+    return true;
+}
 
-    auto png_ptr{png_create_write_struct(PNG_LIBPNG_VER_STRING,
-                                         nullptr,
-                                         nullptr,
-                                         nullptr)};
-    if (!png_ptr) {
-        std::cerr << "Failed to create PNG write struct.\n";
-        fclose(fp);
-        return false;
+// Replaces the last run of '#' in `pattern` with the frame number, padded
+// with zeros to the length of the run.
+static std::string frame_filename(const char* pattern, std::size_t frame) {
+    std::string filename{pattern};
+    auto end{filename.rfind('#') + 1};
+    auto begin{filename.find_last_not_of('#', end - 1) + 1};
+    auto number{std::to_string(frame)};
+    if (number.size() < end - begin) {
+        number.insert(0, end - begin - number.size(), '0');
     }
+    return filename.replace(begin, end - begin, number);
+}
 
-    auto info_ptr{png_create_info_struct(png_ptr)};
-    if (!info_ptr) {
-        std::cerr << "Failed to create PNG info struct.\n";
-        png_destroy_write_struct(&png_ptr, nullptr);
-        fclose(fp);
-        return false;
+static void print_progress(std::uint64_t completed, std::uint64_t total) {
+    // A finished checkpoint leaves nothing to render.
+    if (total == 0) {
+        return;
     }
-
-    if (setjmp(png_jmpbuf(png_ptr))) {
-        std::cerr << "Failed to set PNG jump buffer.\n";
-        png_destroy_write_struct(&png_ptr, &info_ptr);
-        fclose(fp);
-        return false;
+    constexpr std::size_t progress_bar_width{50};
+    auto progress{100.0 * completed / total};
+    auto num_progress_chars{progress_bar_width * completed / total};
+    std::string progress_bar;
+    for (decltype(num_progress_chars) i{0}; i < num_progress_chars; ++i) {
+        progress_bar += u8"█";
     }
-
-    png_init_io(png_ptr, fp);
-    png_set_IHDR(png_ptr,
-                 info_ptr,
-                 width,
-                 height,
-                 8,
-                 PNG_COLOR_TYPE_RGB,
-                 PNG_INTERLACE_NONE,
-                 PNG_COMPRESSION_TYPE_DEFAULT,
-                 PNG_FILTER_TYPE_DEFAULT);
-    png_write_info(png_ptr, info_ptr);
-    auto row{new png_byte[num_channels * width]};
-
-    for (auto y{decltype(height){0}}; y < height; ++y) {
-        for (auto x{decltype(width){0}}; x < width; ++x) {
-            for (auto i{decltype(num_channels){0}}; i < num_channels; ++i) {
-                row[x * num_channels + i]
-                        = buffer[(y * width + x) * num_channels + i];
-            }
-        }
-        png_write_row(png_ptr, row);
+    std::string empty_space(progress_bar_width - num_progress_chars, ' ');
+    std::cerr << "\rRendering: [" << progress_bar << empty_space << "] "
+              << std::fixed << std::setprecision(2) << progress
+              << " % completed.";
+    if (completed == total) {
+        std::cerr << '\n';
     }
-    png_write_end(png_ptr, nullptr);
-
-    delete[] row;
-    png_free_data(png_ptr, info_ptr, PNG_FREE_ALL, -1);
-    png_destroy_write_struct(&png_ptr, &info_ptr);
-    fclose(fp);
-
-    return true;
 }
 
-static Color background_color(const Ray& ray) {
-    return Color::lerp(Color::white,
-                       Color{0.5, 0.7, 1, 1},
-                       0.5 * (ray.direction.y + 1));
+// Ends the run after an error. Once MPI is initialized, the other ranks may
+// be waiting on this one, and would wait forever if it just returned.
+static int abort_run() {
+#ifdef USE_MPI
+    MPI_Abort(MPI_COMM_WORLD, 1);
+#endif
+    return 1;
 }
 
-static Color hit_color(const Ray& ray,
-                       const Hittable& world,
-                       std::size_t depth) {
-    if (depth == -1) {
-        return Color::black;
+int main(int argc, char* argv[]) {
+    Options options;
+    if (!parse_options(argc, argv, options)) {
+        print_usage(argv[0]);
+        return 1;
     }
 
-    Hittable::HitInfo hit_info;
-    if (world.hit(ray, hit_info)) {
-        Ray scattered;
-        Color attenuation;
-        if (hit_info.material_ptr->scatter(ray,
-                                           hit_info,
-                                           scattered,
-                                           attenuation)) {
-            auto color{hit_color(scattered, world, depth - 1)};
-            return Color{attenuation.r * color.r,
-                         attenuation.g * color.g,
-                         attenuation.b * color.b,
-                         attenuation.a * color.a};
+    ThreadPool pool{options.num_threads};
+
+    Scene scene;
+    if (options.scene_filename) {
+        if (!load_scene(options.scene_filename, pool, scene)) {
+            return 1;
         }
-        return Color::black;
+    } else {
+        random_scene(scene, pool);
+    }
+    if (options.image_width) {
+        scene.image_width = options.image_width;
+    }
+    if (options.image_height) {
+        scene.image_height = options.image_height;
+    }
+    if (options.samples_per_pixel) {
+        scene.samples_per_pixel = options.samples_per_pixel;
+    }
+    if (options.max_depth) {
+        scene.max_depth = options.max_depth;
+    }
+    if (options.num_frames) {
+        scene.num_frames = options.num_frames;
     }
-    return background_color(ray);
-}
-
-static HittableList random_scene() {
-    HittableList scene;
-
-    auto ground_material{std::make_shared<Lambertian>(Color::gray)};
-    scene.add(std::make_shared<Sphere>(Vector3{0, -1000, 0},
-                                       1000,
-                                       ground_material));
-
-    for (auto a{-10}; a < 10; ++a) {
-        for (auto b{-10}; b < 10; ++b) {
-            auto center{Vector3{static_cast<Vector3::ValueType>(
-                                        a + 0.9 * random_double()),
-                                0.2,
-                                static_cast<Vector3::ValueType>(
-                                        b + 0.9 * random_double())}};
-            auto material_choice{random_double()};
-
-            if ((center - Vector3{4, 0.2, 0}).magnitude() > 0.9) {
-                std::shared_ptr<Material> material;
-
-                if (material_choice < 0.6) {
-                    auto albedo{Color{random_double() * random_double(),
-                                      random_double() * random_double(),
-                                      random_double() * random_double(),
-                                      random_double() * random_double()}};
-                    material = std::make_shared<Lambertian>(albedo);
-                } else if (material_choice < 0.9) {
-                    auto albedo{Color{random_double(0.5, 1),
-                                      random_double(0.5, 1),
-                                      random_double(0.5, 1),
-                                      random_double(0.5, 1)}};
-                    auto fuzz{random_double(0, 0.5)};
-                    material = std::make_shared<Metal>(albedo, fuzz);
-                } else {
-                    material = std::make_shared<Dielectric>(1.5);
-                }
 
-                scene.add(std::make_shared<Sphere>(center, 0.2, material));
-            }
+    if (options.export_scene_filename) {
+        if (!save_scene(options.export_scene_filename, scene)) {
+            return 1;
         }
+        std::cerr << "Scene file '" << options.export_scene_filename
+                  << "' created successfully.\n";
+        return 0;
     }
 
-    auto dielectric_material{std::make_shared<Dielectric>(1.5)};
-    scene.add(
-            std::make_shared<Sphere>(Vector3{0, 1, 0}, 1, dielectric_material));
-
-    auto lambertian_material{
-            std::make_shared<Lambertian>(Color{0.4, 0.2, 0.1, 1})};
-    scene.add(std::make_shared<Sphere>(Vector3{-4, 1, 0},
-                                       1,
-                                       lambertian_material));
-
-    auto metal_material{std::make_shared<Metal>(Color{0.7, 0.6, 0.5, 1}, 0)};
-    scene.add(std::make_shared<Sphere>(Vector3{4, 1, 0}, 1, metal_material));
-
-    return scene;
-}
-
-int main(int argc, char* argv[]) {
-    if (argc != 2) {
-        std::cerr << "Usage: " << argv[0] << " <output.png>\n";
+    const auto num_frames{scene.num_frames};
+    const auto animated{num_frames > 1};
+    if (animated && !std::strchr(options.output_filename, '#')) {
+        std::cerr << "The output file name of an animation needs '#' "
+                     "characters for the frame number.\n";
+        return 1;
+    }
+    if (animated && options.checkpoint_filename) {
+        std::cerr << "Checkpoints are only supported for single frames.\n";
         return 1;
     }
 
-    const char* output_filename = argv[1];
-
+    auto is_root{true};
 #ifdef USE_MPI
-    MPI_Init(&argc, &argv);
-    int world_size;
+    // Rank 0 talks to the other ranks from a second thread while its own
+    // threads render, but never from two threads at once.
+    int thread_support;
+    MPI_Init_thread(&argc, &argv, MPI_THREAD_SERIALIZED, &thread_support);
+    if (thread_support < MPI_THREAD_SERIALIZED) {
+        std::cerr << "MPI does not support calls from multiple threads.\n";
+        MPI_Abort(MPI_COMM_WORLD, 1);
+    }
     int world_rank;
-    MPI_Comm_size(MPI_COMM_WORLD, &world_size);
     MPI_Comm_rank(MPI_COMM_WORLD, &world_rank);
+    is_root = world_rank == 0;
 #endif
 
-    constexpr auto aspect_ratio{16.0 / 9.0};
-    constexpr auto image_height{1080};
-    constexpr auto image_width{aspect_ratio * image_height};
-    constexpr auto samples_per_pixel{500};
-    constexpr auto max_depth{50};
-
-    const auto lookfrom{Vector3{13, 2, -3}};
-    const auto lookat{Vector3::zero};
-    const auto viewup{Vector3::up};
-    constexpr auto focus_distance{10};
-    constexpr auto aperture{0.1};
+    const auto image_width{scene.image_width};
+    const auto image_height{scene.image_height};
+
+    // The renderer is set up once for the whole sequence and sees each
+    // frame's camera and instances as they are moved in place.
+    auto camera{scene.camera()};
+    const auto world{scene.world()};
+    const RenderSettings settings{image_width,
+                                  image_height,
+                                  scene.samples_per_pixel,
+                                  scene.max_depth,
+                                  options.tile_size,
+                                  options.packet_tracing,
+                                  options.adaptive_threshold,
+                                  options.sampler};
+    Renderer renderer{camera,
+                      world,
+                      scene.materials,
+                      scene.lights,
+                      settings};
+    ToneMapper tone_mapper{options.tone_map};
+
+    // Animations alternate between two films, so that one frame can be
+    // rendered while the output of the one before is completed from the
+    // other.
+    std::vector<Film> films(animated ? 2 : 1, Film{image_width, image_height});
+    // With denoising, the outputs are written from these instead, once the
+    // whole of the frame is rendered.
+    std::vector<Film> denoised_films(options.denoise ? films.size() : 0,
+                                     Film{image_width, image_height});
+    const auto needs_features{options.denoise || !options.aovs.empty()};
+    std::vector<FeatureBuffer> feature_buffers(
+            needs_features ? films.size() : 0,
+            FeatureBuffer{image_width, image_height});
+    std::unique_ptr<ImageOutput> outputs[2];
+    std::string output_filenames[2];
+    std::thread writer;
+    // Whether an output was closed, here or by `writer`, and not reported.
+    auto closing{false};
+    auto written{true};
+    auto finish_writing{[&](std::size_t slot) {
+        if (!closing) {
+            return true;
+        }
+        if (writer.joinable()) {
+            writer.join();
+        }
+        closing = false;
+        if (!written) {
+            std::cerr << "Failed to create image file.\n";
+            return false;
+        }
+        std::cerr << "Image file '" << output_filenames[slot]
+                  << "' created successfully.\n";
+        return true;
+    }};
+
+    // Only the root process ends up with the whole image, so it is the one
+    // that saves and resumes checkpoints.
+    std::string checkpoint_filename;
+    if (options.checkpoint_filename) {
+        if (is_root) {
+            checkpoint_filename = options.checkpoint_filename;
+        }
+        if (is_root && file_exists(checkpoint_filename.c_str())) {
+            if (!load_checkpoint(checkpoint_filename.c_str(),
+                                 settings,
+                                 films[0])) {
+                return abort_run();
+            }
+            std::cerr << "Resuming from checkpoint '" << checkpoint_filename
+                      << "'.\n";
+        }
+        std::signal(SIGINT, request_interrupt);
+        std::signal(SIGTERM, request_interrupt);
+    }
 
-    Camera camera{lookfrom,
-                  lookat,
-                  viewup,
-                  degrees_to_radians(20),
-                  aspect_ratio,
-                  focus_distance,
-                  aperture};
+#ifdef USE_STATS
+    reset_stats(image_width, image_height);
+    auto render_start{std::chrono::steady_clock::now()};
+#endif
 
-    auto world{random_scene()};
+    auto completed{true};
+    for (std::size_t frame{0}; frame < num_frames && completed; ++frame) {
+        auto slot{frame % films.size()};
+        auto& film{films[slot]};
+        if (frame >= films.size()) {
+            film = Film{image_width, image_height};
+        }
+        scene.set_frame(static_cast<double>(frame), pool);
+        camera = scene.camera();
+
+        // The root streams each band of rows to the output file as soon as
+        // its tiles are done, under a temporary name until the image is
+        // complete.
+        Renderer::TileCallback on_tile;
+        if (is_root) {
+            output_filenames[slot] = animated ? frame_filename(
+                                                        options.output_filename,
+                                                        frame)
+                                              : options.output_filename;
+            outputs[slot] = std::make_unique<ImageOutput>(
+                    output_filenames[slot].c_str(),
+                    output_filenames[slot] + ".part",
+                    options.denoise ? denoised_films[slot] : film,
+                    tone_mapper,
+                    options.tile_size,
+                    options.half_float,
+                    needs_features ? &feature_buffers[slot] : nullptr,
+                    options.aovs);
+            if (!outputs[slot]->open()) {
+                return abort_run();
+            }
+            // The features are only there once the frame is rendered.
+            if (!needs_features) {
+                on_tile = [&output = *outputs[slot]](const Tile& tile) {
+                    output.finish_tile(tile);
+                };
+            }
+            if (animated) {
+                std::cerr << "Frame " << frame + 1 << " of " << num_frames
+                          << ".\n";
+            }
+        }
 
-    constexpr auto buffer_size{image_width * image_height * num_channels};
+        auto last_checkpoint_time{std::chrono::steady_clock::now()};
+        auto on_pass{[&] {
+            auto interrupted{interrupt_requested != 0};
+            if (checkpoint_filename.empty()) {
+                return !interrupted;
+            }
+            std::chrono::duration<float> elapsed{
+                    std::chrono::steady_clock::now() - last_checkpoint_time};
+            if (interrupted
+                || elapsed.count() >= options.checkpoint_interval) {
+                save_checkpoint(checkpoint_filename.c_str(), film, settings);
 #ifdef USE_MPI
-    auto rows_per_process{image_height / world_size};
-    auto reverse_rank{world_size - world_rank - 1};
-    auto start_row{reverse_rank * rows_per_process};
-    auto end_row{reverse_rank == world_size - 1 ? image_height
-                                                : start_row + rows_per_process};
-    std::vector<std::uint8_t> buffer((end_row - start_row) * image_width
-                                     * num_channels);
-    for (auto row{start_row}; row < end_row; ++row) {
-#else
-    std::vector<std::uint8_t> buffer(buffer_size);
-#ifdef USE_OPENMP
-#pragma omp parallel for schedule(dynamic, 1) collapse(2) if (USE_OPENMP)
-    for (int row = 0; row < static_cast<int>(image_height); ++row) {
-#else
-    for (auto row{decltype(image_height){image_height - 1}}; row != -1; --row) {
-#endif
-#endif
-#ifdef USE_OPENMP
-        for (int col = 0; col < static_cast<int>(image_width); ++col) {
+                // Distributed renders call this from the pool's own tasks.
+                ThreadPool* preview_pool{nullptr};
 #else
-        for (auto col{decltype(image_width){0}}; col < image_width; ++col) {
+                auto preview_pool{&pool};
 #endif
-            Color::ValueType r_sum{0};
-            Color::ValueType g_sum{0};
-            Color::ValueType b_sum{0};
-            Color::ValueType a_sum{0};
-            for (auto i{samples_per_pixel - 1}; i != -1; --i) {
-                auto u{(static_cast<Vector3::ValueType>(col) + random_double())
-                       / (image_width - 1)};
-                auto v{(static_cast<Vector3::ValueType>(row) + random_double())
-                       / (image_height - 1)};
-                auto ray{camera.generate_ray(u, v)};
-                auto color{hit_color(ray, world, max_depth)};
-                r_sum += color.r;
-                g_sum += color.g;
-                b_sum += color.b;
-                a_sum += color.a;
+                write_image(options.output_filename,
+                            film,
+                            tone_mapper,
+                            options.tile_size,
+                            options.half_float,
+                            preview_pool);
+                last_checkpoint_time = std::chrono::steady_clock::now();
             }
-            Color color{r_sum / samples_per_pixel,
-                        g_sum / samples_per_pixel,
-                        b_sum / samples_per_pixel,
-                        a_sum / samples_per_pixel};
-            Color color_gamma_corrected{color.gamma()};
+            return !interrupted;
+        }};
+
 #ifdef USE_MPI
-            auto index{((end_row - row - 1) * image_width + col)
-                       * num_channels};
+        completed = renderer.render_distributed(pool,
+                                                film,
+                                                print_progress,
+                                                on_pass,
+                                                on_tile);
 #else
-            auto index{((image_height - row - 1) * image_width + col)
-                       * num_channels};
+        completed = renderer.render(pool,
+                                    0,
+                                    image_height,
+                                    film,
+                                    print_progress,
+                                    on_pass,
+                                    on_tile);
 #endif
-            buffer[index] = scale_256(color_gamma_corrected.r);
-            buffer[index + 1] = scale_256(color_gamma_corrected.g);
-            buffer[index + 2] = scale_256(color_gamma_corrected.b);
+
+        if (!is_root) {
+            continue;
+        }
+        // Only checkpoints stop a render early, and the last one wrote what
+        // there is as a preview, which the streamed output would replace.
+        if (!completed) {
+            outputs[slot].reset();
+            continue;
+        }
+        if (options.adaptive_threshold > 0) {
+            auto average_samples{static_cast<double>(film.num_samples())
+                                 / film.pixels.size()};
+            std::cerr << "Average samples per pixel: " << std::fixed
+                      << std::setprecision(2) << average_samples << ".\n";
+        }
+        if (needs_features) {
+            renderer.render_features(pool, feature_buffers[slot]);
+        }
+        if (options.denoise) {
+            auto denoise_start{std::chrono::steady_clock::now()};
+            denoise(film, feature_buffers[slot], pool, denoised_films[slot]);
+            std::chrono::duration<double> elapsed{
+                    std::chrono::steady_clock::now() - denoise_start};
+            std::cerr << "Denoised in " << std::fixed << std::setprecision(2)
+                      << elapsed.count() << " s.\n";
         }
-#ifdef USE_MPI
-    }
 
-    decltype(buffer) image_buffer;
-    if (world_rank == 0) {
-        image_buffer.resize(buffer_size);
+        // The previous frame has had the whole of this one to finish.
+        if (!finish_writing(1 - slot)) {
+            return abort_run();
+        }
+        closing = true;
+        if (needs_features) {
+            // Nothing was streamed, so every band is still to encode, which
+            // the pool does now that it has nothing else to run, rather than
+            // the writer alongside the next frame.
+            written = outputs[slot]->close(&pool);
+        } else {
+            writer = std::thread{[&, slot] {
+                written = outputs[slot]->close();
+            }};
+        }
+        if ((!animated || needs_features) && !finish_writing(slot)) {
+            return abort_run();
+        }
+    }
+    if (is_root && !finish_writing((num_frames - 1) % films.size())) {
+        return abort_run();
     }
 
-    std::vector<int> chunk_sizes(world_size);
-    chunk_sizes[world_rank] = buffer.size();
-    MPI_Allgather(MPI_IN_PLACE,
-                  0,
-                  MPI_DATATYPE_NULL,
-                  chunk_sizes.data(),
-                  1,
-                  MPI_INT,
-                  MPI_COMM_WORLD);
-    std::vector<int> displacements(world_size);
-    displacements[world_rank]
-            = (image_height - end_row) * image_width * num_channels;
-    MPI_Allgather(MPI_IN_PLACE,
-                  0,
-                  MPI_DATATYPE_NULL,
-                  displacements.data(),
-                  1,
-                  MPI_INT,
-                  MPI_COMM_WORLD);
-
-    MPI_Gatherv(buffer.data(),
-                chunk_sizes[world_rank],
-                MPI_UNSIGNED_CHAR,
-                image_buffer.data(),
-                chunk_sizes.data(),
-                displacements.data(),
-                MPI_UNSIGNED_CHAR,
-                0,
-                MPI_COMM_WORLD);
-#else
-#ifdef USE_OPENMP
+#ifdef USE_STATS
+    std::chrono::duration<double> render_seconds{
+            std::chrono::steady_clock::now() - render_start};
+    auto stats{collect_stats()};
+#ifdef USE_MPI
+    reduce_stats(stats);
+#endif
+    if (is_root && options.stats_filename) {
+        if (!write_stats(options.stats_filename,
+                         stats,
+                         options.tile_size,
+                         render_seconds.count())) {
+            return abort_run();
+        }
+        std::cerr << "Statistics file '" << options.stats_filename
+                  << "' created successfully.\n";
     }
-#else
-        constexpr auto progress_bar_width{50};
-        auto progress{100.0 * (image_height - row) / image_height};
-        auto num_progress_chars{progress_bar_width * (image_height - row)
-                                / image_height};
-        std::string progress_bar;
-        for (decltype(num_progress_chars) i{0}; i < num_progress_chars; ++i) {
-            progress_bar += u8"█";
+    if (is_root && options.heatmap_filename) {
+        if (!write_heatmap(options.heatmap_filename,
+                           stats,
+                           options.tile_size,
+                           options.half_float)) {
+            return abort_run();
         }
-        std::string empty_space(progress_bar_width - num_progress_chars, ' ');
-        std::cerr << "\rRendering: [" << progress_bar << empty_space << "] "
-                  << std::fixed << std::setprecision(2) << progress
-                  << " % completed.";
+        std::cerr << "Heatmap file '" << options.heatmap_filename
+                  << "' created successfully.\n";
     }
-    std::cerr << '\n';
-#endif
-    auto image_buffer{std::move(buffer)};
 #endif
 
-#ifdef USE_MPI
-    if (world_rank == 0) {
-#endif
-        if (write_png(output_filename,
-                      image_width,
-                      image_height,
-                      image_buffer.data())) {
-            std::cerr << "PNG file '" << output_filename
-                      << "' created successfully.\n";
-        } else {
-            std::cerr << "Failed to create PNG file.\n";
-            return 1;
-        }
-#ifdef USE_MPI
+    if (!checkpoint_filename.empty()
+        && !save_checkpoint(checkpoint_filename.c_str(),
+                            films[0],
+                            settings)) {
+        return abort_run();
+    }
+    if (is_root && !completed) {
+        std::cerr << "\nRendering interrupted; run again to resume. "
+                     "The image so far is in '"
+                  << options.output_filename << "'.\n";
     }
 
+#ifdef USE_MPI
     MPI_Finalize();
 #endif
 
-    return 0;
+    return completed ? 0 : 1;
 }
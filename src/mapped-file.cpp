@@ -0,0 +1,59 @@
+#include "mapped-file.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <iostream>
+
+namespace ray_tracing {
+
+std::shared_ptr<const MappedFile> MappedFile::open(const char* filename) {
+    auto fd{::open(filename, O_RDONLY)};
+    if (fd == -1) {
+        std::cerr << "Failed to open file: " << filename << ".\n";
+        return nullptr;
+    }
+
+    struct stat status;
+    if (fstat(fd, &status) != 0) {
+        std::cerr << "Failed to read file size: " << filename << ".\n";
+        close(fd);
+        return nullptr;
+    }
+
+    auto num_bytes{static_cast<std::size_t>(status.st_size)};
+    void* bytes{nullptr};
+    if (num_bytes > 0) {
+        bytes = mmap(nullptr, num_bytes, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (bytes == MAP_FAILED) {
+            std::cerr << "Failed to map file: " << filename << ".\n";
+            close(fd);
+            return nullptr;
+        }
+    }
+    close(fd);
+
+    return std::shared_ptr<const MappedFile>{
+            new MappedFile{bytes, num_bytes}};
+}
+
+MappedFile::MappedFile(void* bytes, std::size_t num_bytes)
+    : bytes{bytes}, num_bytes{num_bytes} {}
+
+MappedFile::~MappedFile() {
+    if (bytes) {
+        munmap(bytes, num_bytes);
+    }
+}
+
+const char* MappedFile::data() const {
+    return static_cast<const char*>(bytes);
+}
+
+std::size_t MappedFile::size() const {
+    return num_bytes;
+}
+
+}
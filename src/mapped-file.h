@@ -0,0 +1,36 @@
+#ifndef MAPPED_FILE_H
+#define MAPPED_FILE_H
+
+#include <cstddef>
+#include <memory>
+
+namespace ray_tracing {
+
+// A read-only memory map of a whole file, unmapped when the last reference
+// goes away.
+class MappedFile {
+public:
+    // Prints a message and returns null if the file cannot be mapped.
+    static std::shared_ptr<const MappedFile> open(const char* filename);
+
+    MappedFile(const MappedFile&) = delete;
+
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    ~MappedFile();
+
+    const char* data() const;
+
+    std::size_t size() const;
+
+private:
+    MappedFile(void* bytes, std::size_t num_bytes);
+
+    void* bytes;
+
+    std::size_t num_bytes;
+};
+
+}
+
+#endif
@@ -0,0 +1,57 @@
+#include "material.h"
+
+namespace ray_tracing {
+
+bool scatter(const Material& material,
+             const Ray& incident,
+             const Hittable::HitInfo& hit_info,
+             const ScatterSample& sample,
+             Ray& scattered,
+             Radiance& attenuation) {
+    return std::visit(
+            [&](const auto& alternative) {
+                return alternative.scatter(incident,
+                                           hit_info,
+                                           sample,
+                                           scattered,
+                                           attenuation);
+            },
+            material);
+}
+
+Radiance emitted(const Material& material,
+                 const Ray& incident,
+                 const Hittable::HitInfo& hit_info) {
+    auto light{std::get_if<DiffuseLight>(&material)};
+    return light ? light->emitted(incident, hit_info) : Radiance::black;
+}
+
+Radiance albedo(const Material& material) {
+    auto lambertian{std::get_if<Lambertian>(&material)};
+    if (lambertian) {
+        return lambertian->reflectance();
+    }
+    auto metal{std::get_if<Metal>(&material)};
+    return metal ? metal->reflectance() : Radiance::white;
+}
+
+bool is_specular(const Material& material) {
+    return std::holds_alternative<Metal>(material)
+           || std::holds_alternative<Dielectric>(material);
+}
+
+bool evaluate(const Material& material,
+              const Ray& incident,
+              const Hittable::HitInfo& hit_info,
+              const Vector3& direction,
+              Radiance& value,
+              Vector3::ValueType& pdf) {
+    auto lambertian{std::get_if<Lambertian>(&material)};
+    if (!lambertian) {
+        return false;
+    }
+    value = lambertian->evaluate(incident, hit_info, direction, pdf);
+    return true;
+}
+
+}
@@ -1,20 +1,56 @@
 #ifndef MATERIAL_H
 #define MATERIAL_H
 
-#include "color.h"
+#include "dielectric.h"
+#include "diffuse-light.h"
 #include "hittable.h"
+#include "lambertian.h"
+#include "metal.h"
+#include "radiance.h"
 #include "ray.h"
+#include "sampler.h"
+#include "vector3.h"
+
+#include <variant>
 
 namespace ray_tracing {
 
-class Material {
-public:
-    virtual bool scatter(const Ray& incident,
-                         const Hittable::HitInfo& hit_info,
-                         Ray& scattered,
-                         Color& attenuation) const
-            = 0;
-};
+// Materials are held by value in the scene's material table, which hit
+// records refer to by index, and dispatched on their alternative rather
+// than through a virtual call.
+using Material = std::variant<Lambertian, Metal, Dielectric, DiffuseLight>;
+
+bool scatter(const Material& material,
+             const Ray& incident,
+             const Hittable::HitInfo& hit_info,
+             const ScatterSample& sample,
+             Ray& scattered,
+             Radiance& attenuation);
+
+// Black for materials that do not emit.
+Radiance emitted(const Material& material,
+                 const Ray& incident,
+                 const Hittable::HitInfo& hit_info);
+
+// The color the denoiser sees the material as: the reflectance of diffuse
+// surfaces and metals, and white for dielectrics, which are clear, and for
+// lights.
+Radiance albedo(const Material& material);
+
+// Whether the material scatters into a narrow cone, as metals and
+// dielectrics do, so that what it shows is mostly the surfaces beyond.
+bool is_specular(const Material& material);
+
+// Sets `value` to the cosine-weighted reflectance from the unit vector
+// `direction` towards `incident` and `pdf` to the density `scatter` picks
+// it with. Returns false for materials that scatter into too narrow a cone
+// for light sampling to help, which are left to `scatter` alone.
+bool evaluate(const Material& material,
+              const Ray& incident,
+              const Hittable::HitInfo& hit_info,
+              const Vector3& direction,
+              Radiance& value,
+              Vector3::ValueType& pdf);
 
 }
 
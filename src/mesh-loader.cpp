@@ -0,0 +1,816 @@
+#include "mesh-loader.h"
+
+#include "mapped-file.h"
+
+#include <strings.h>
+
+#include <algorithm>
+#include <atomic>
+#include <charconv>
+#include <iostream>
+#include <limits>
+#include <string_view>
+#include <vector>
+
+#include <cstdint>
+#include <cstring>
+
+namespace ray_tracing {
+
+// Several chunks per thread, so that the work stays balanced when some
+// chunks hold more faces than others.
+static constexpr std::size_t chunks_per_thread{4};
+
+static bool has_extension(const char* filename, const char* extension) {
+    auto length{std::strlen(filename)};
+    auto extension_length{std::strlen(extension)};
+    return length >= extension_length
+           && strcasecmp(filename + length - extension_length, extension)
+                      == 0;
+}
+
+template <typename T>
+static bool parse(std::string_view word, T& value) {
+    auto [end, status]{
+            std::from_chars(word.data(), word.data() + word.size(), value)};
+    return status == std::errc{} && end == word.data() + word.size();
+}
+
+// The words of one line, separated by spaces or tabs.
+class WordReader {
+public:
+    explicit WordReader(std::string_view line) : rest{line} {}
+
+    bool read(std::string_view& word) {
+        auto begin{rest.find_first_not_of(" \t\r")};
+        if (begin == rest.npos) {
+            return false;
+        }
+        rest.remove_prefix(begin);
+        word = rest.substr(0, rest.find_first_of(" \t\r"));
+        rest.remove_prefix(word.size());
+        return true;
+    }
+
+    template <typename T>
+    bool read(T& value) {
+        std::string_view word;
+        return read(word) && parse(word, value);
+    }
+
+private:
+    std::string_view rest;
+};
+
+static std::string_view next_line(std::string_view& text) {
+    auto end{text.find('\n')};
+    auto line{text.substr(0, end)};
+    text.remove_prefix(end == text.npos ? text.size() : end + 1);
+    return line;
+}
+
+// A piece of a text file that ends at a line break, with what it parsed
+// into.
+struct TextChunk {
+    std::string_view text;
+
+    // OBJ: the vertices before and in the chunk. PLY: the lines.
+    std::size_t first{0};
+
+    std::size_t count{0};
+
+    std::vector<std::uint32_t> indices;
+
+    const char* error{nullptr};
+};
+
+static std::vector<TextChunk> split_lines(std::string_view text,
+                                          const ThreadPool& pool) {
+    auto chunk_size{text.size() / (pool.size() * chunks_per_thread) + 1};
+    std::vector<TextChunk> chunks;
+    while (!text.empty()) {
+        auto end{text.find('\n', std::min(chunk_size, text.size()) - 1)};
+        end = end == text.npos ? text.size() : end + 1;
+        chunks.emplace_back();
+        chunks.back().text = text.substr(0, end);
+        text.remove_prefix(end);
+    }
+    return chunks;
+}
+
+// Adds the polygon as a fan of triangles around its first corner.
+static void add_polygon(const std::vector<std::uint32_t>& corners,
+                        std::vector<std::uint32_t>& indices) {
+    for (std::size_t i{2}; i < corners.size(); ++i) {
+        indices.emplace_back(corners[0]);
+        indices.emplace_back(corners[i - 1]);
+        indices.emplace_back(corners[i]);
+    }
+}
+
+// Concatenates the triangles of the chunks in file order.
+static bool gather_indices(const char* filename,
+                           std::vector<TextChunk>& chunks,
+                           ThreadPool& pool,
+                           MeshData& mesh) {
+    std::vector<std::size_t> offsets;
+    std::size_t num_indices{0};
+    for (const auto& chunk : chunks) {
+        if (chunk.error) {
+            std::cerr << "Invalid mesh file '" << filename << "': "
+                      << chunk.error << ".\n";
+            return false;
+        }
+        offsets.emplace_back(num_indices);
+        num_indices += chunk.indices.size();
+    }
+    mesh.indices.resize(num_indices);
+    pool.run(chunks.size(), [&](auto chunk_index, auto) {
+        const auto& indices{chunks[chunk_index].indices};
+        std::copy(indices.begin(),
+                  indices.end(),
+                  mesh.indices.begin() + offsets[chunk_index]);
+    });
+    return true;
+}
+
+static bool is_vertex(std::string_view line) {
+    WordReader reader{line};
+    std::string_view keyword;
+    return reader.read(keyword) && keyword == "v";
+}
+
+static void parse_obj_chunk(TextChunk& chunk,
+                            std::size_t num_vertices,
+                            std::vector<Vector3>& positions) {
+    auto next_vertex{chunk.first};
+    std::vector<std::uint32_t> corners;
+    auto text{chunk.text};
+    while (!text.empty()) {
+        WordReader reader{next_line(text)};
+        std::string_view keyword;
+        if (!reader.read(keyword)) {
+            continue;
+        }
+        if (keyword == "v") {
+            auto& position{positions[next_vertex++]};
+            if (!reader.read(position.x) || !reader.read(position.y)
+                || !reader.read(position.z)) {
+                chunk.error = "malformed vertex";
+                return;
+            }
+        } else if (keyword == "f") {
+            corners.clear();
+            std::string_view word;
+            while (reader.read(word)) {
+                // Only the position of `v/vt/vn` is used. Negative indices
+                // count back from the latest vertex.
+                long long index;
+                if (!parse(word.substr(0, word.find('/')), index)
+                    || index == 0) {
+                    chunk.error = "malformed face";
+                    return;
+                }
+                auto resolved{index > 0
+                                      ? index - 1
+                                      : static_cast<long long>(next_vertex)
+                                                + index};
+                if (resolved < 0
+                    || static_cast<std::size_t>(resolved) >= num_vertices) {
+                    chunk.error = "face refers to a missing vertex";
+                    return;
+                }
+                corners.emplace_back(static_cast<std::uint32_t>(resolved));
+            }
+            if (corners.size() < 3) {
+                chunk.error = "face with fewer than three corners";
+                return;
+            }
+            add_polygon(corners, chunk.indices);
+        }
+    }
+}
+
+static bool load_obj(const char* filename,
+                     std::string_view text,
+                     ThreadPool& pool,
+                     MeshData& mesh) {
+    auto chunks{split_lines(text, pool)};
+    pool.run(chunks.size(), [&](auto chunk_index, auto) {
+        auto& chunk{chunks[chunk_index]};
+        auto rest{chunk.text};
+        while (!rest.empty()) {
+            chunk.count += is_vertex(next_line(rest));
+        }
+    });
+
+    std::size_t num_vertices{0};
+    for (auto& chunk : chunks) {
+        chunk.first = num_vertices;
+        num_vertices += chunk.count;
+    }
+    if (num_vertices > std::numeric_limits<std::uint32_t>::max()) {
+        std::cerr << "Too many vertices in mesh file '" << filename << "'.\n";
+        return false;
+    }
+
+    mesh.positions.resize(num_vertices);
+    pool.run(chunks.size(), [&](auto chunk_index, auto) {
+        parse_obj_chunk(chunks[chunk_index], num_vertices, mesh.positions);
+    });
+    return gather_indices(filename, chunks, pool, mesh);
+}
+
+enum class PlyFormat { ascii, binary_little_endian, binary_big_endian };
+
+enum class PlyType {
+    int8,
+    uint8,
+    int16,
+    uint16,
+    int32,
+    uint32,
+    float32,
+    float64
+};
+
+struct PlyProperty {
+    std::string_view name;
+
+    PlyType type;
+
+    bool is_list{false};
+
+    PlyType count_type;
+};
+
+struct PlyElement {
+    std::string_view name;
+
+    std::size_t count;
+
+    std::vector<PlyProperty> properties;
+
+    std::size_t first_line{0};
+};
+
+struct PlyHeader {
+    PlyFormat format;
+
+    std::vector<PlyElement> elements;
+
+    // The offset of the first element's data.
+    std::size_t size;
+};
+
+static bool parse_ply_type(std::string_view name, PlyType& type) {
+    static const std::pair<std::string_view, PlyType> names[]{
+            {"char", PlyType::int8},      {"int8", PlyType::int8},
+            {"uchar", PlyType::uint8},    {"uint8", PlyType::uint8},
+            {"short", PlyType::int16},    {"int16", PlyType::int16},
+            {"ushort", PlyType::uint16},  {"uint16", PlyType::uint16},
+            {"int", PlyType::int32},      {"int32", PlyType::int32},
+            {"uint", PlyType::uint32},    {"uint32", PlyType::uint32},
+            {"float", PlyType::float32},  {"float32", PlyType::float32},
+            {"double", PlyType::float64}, {"float64", PlyType::float64}};
+    for (const auto& [type_name, named_type] : names) {
+        if (name == type_name) {
+            type = named_type;
+            return true;
+        }
+    }
+    return false;
+}
+
+static std::size_t ply_size(PlyType type) {
+    switch (type) {
+    case PlyType::int8:
+    case PlyType::uint8:
+        return 1;
+    case PlyType::int16:
+    case PlyType::uint16:
+        return 2;
+    case PlyType::int32:
+    case PlyType::uint32:
+    case PlyType::float32:
+        return 4;
+    case PlyType::float64:
+        break;
+    }
+    return 8;
+}
+
+template <typename T>
+static T load(const char* bytes, bool swap) {
+    char copy[sizeof(T)];
+    std::memcpy(copy, bytes, sizeof(T));
+    if (swap) {
+        std::reverse(copy, copy + sizeof(T));
+    }
+    T value;
+    std::memcpy(&value, copy, sizeof(T));
+    return value;
+}
+
+static double load(const char* bytes, PlyType type, bool swap) {
+    switch (type) {
+    case PlyType::int8:
+        return load<std::int8_t>(bytes, swap);
+    case PlyType::uint8:
+        return load<std::uint8_t>(bytes, swap);
+    case PlyType::int16:
+        return load<std::int16_t>(bytes, swap);
+    case PlyType::uint16:
+        return load<std::uint16_t>(bytes, swap);
+    case PlyType::int32:
+        return load<std::int32_t>(bytes, swap);
+    case PlyType::uint32:
+        return load<std::uint32_t>(bytes, swap);
+    case PlyType::float32:
+        return load<float>(bytes, swap);
+    case PlyType::float64:
+        break;
+    }
+    return load<double>(bytes, swap);
+}
+
+static bool parse_ply_header(const char* filename,
+                             std::string_view text,
+                             PlyHeader& header) {
+    auto error{[&](const char* message) {
+        std::cerr << "Invalid PLY file '" << filename << "': " << message
+                  << ".\n";
+        return false;
+    }};
+
+    auto rest{text};
+    std::string_view magic;
+    if (!WordReader{next_line(rest)}.read(magic) || magic != "ply") {
+        return error("missing magic number");
+    }
+    auto has_format{false};
+    while (!rest.empty()) {
+        WordReader reader{next_line(rest)};
+        std::string_view keyword;
+        if (!reader.read(keyword) || keyword == "comment"
+            || keyword == "obj_info") {
+            continue;
+        }
+        if (keyword == "end_header") {
+            header.size = text.size() - rest.size();
+            if (!has_format) {
+                return error("missing format");
+            }
+            return true;
+        }
+
+        std::string_view word;
+        if (keyword == "format") {
+            if (!reader.read(word)) {
+                return error("missing format");
+            }
+            if (word == "ascii") {
+                header.format = PlyFormat::ascii;
+            } else if (word == "binary_little_endian") {
+                header.format = PlyFormat::binary_little_endian;
+            } else if (word == "binary_big_endian") {
+                header.format = PlyFormat::binary_big_endian;
+            } else {
+                return error("unknown format");
+            }
+            has_format = true;
+        } else if (keyword == "element") {
+            PlyElement element;
+            if (!reader.read(element.name) || !reader.read(element.count)) {
+                return error("malformed element");
+            }
+            header.elements.emplace_back(element);
+        } else if (keyword == "property") {
+            PlyProperty property;
+            if (header.elements.empty() || !reader.read(word)) {
+                return error("malformed property");
+            }
+            if (word == "list") {
+                property.is_list = true;
+                if (!reader.read(word)
+                    || !parse_ply_type(word, property.count_type)
+                    || !reader.read(word)) {
+                    return error("malformed property");
+                }
+            }
+            if (!parse_ply_type(word, property.type)
+                || !reader.read(property.name)) {
+                return error("malformed property");
+            }
+            header.elements.back().properties.emplace_back(property);
+        } else {
+            return error("unknown header line");
+        }
+    }
+    return error("missing end_header");
+}
+
+static bool is_vertex_indices(const PlyProperty& property) {
+    return property.is_list
+           && (property.name == "vertex_indices"
+               || property.name == "vertex_index");
+}
+
+// Checks that every corner names a vertex and adds the polygon.
+static bool add_ply_polygon(const std::vector<double>& values,
+                            std::size_t num_vertices,
+                            std::vector<std::uint32_t>& corners,
+                            std::vector<std::uint32_t>& indices) {
+    corners.clear();
+    for (auto value : values) {
+        if (!(value >= 0 && value < num_vertices)) {
+            return false;
+        }
+        corners.emplace_back(static_cast<std::uint32_t>(value));
+    }
+    add_polygon(corners, indices);
+    return corners.size() >= 3;
+}
+
+static void parse_ply_chunk(TextChunk& chunk,
+                            const PlyElement* vertex,
+                            const PlyElement* face,
+                            std::vector<Vector3>& positions) {
+    std::vector<double> values;
+    std::vector<std::uint32_t> corners;
+    auto line_index{chunk.first};
+    auto text{chunk.text};
+    for (; !text.empty(); ++line_index) {
+        WordReader reader{next_line(text)};
+        const PlyElement* element{nullptr};
+        for (const auto* candidate : {vertex, face}) {
+            if (line_index >= candidate->first_line
+                && line_index < candidate->first_line + candidate->count) {
+                element = candidate;
+            }
+        }
+        if (!element) {
+            continue;
+        }
+
+        Vector3::ValueType coordinates[3]{};
+        values.clear();
+        for (const auto& property : element->properties) {
+            std::size_t count{1};
+            if (property.is_list && !reader.read(count)) {
+                chunk.error = "malformed list";
+                return;
+            }
+            for (std::size_t i{0}; i < count; ++i) {
+                double value;
+                if (!reader.read(value)) {
+                    chunk.error = "malformed value";
+                    return;
+                }
+                if (element == face && is_vertex_indices(property)) {
+                    values.emplace_back(value);
+                } else if (element == vertex && !property.is_list) {
+                    auto axis{property.name == "x"   ? 0
+                              : property.name == "y" ? 1
+                              : property.name == "z" ? 2
+                                                     : -1};
+                    if (axis >= 0) {
+                        coordinates[axis]
+                                = static_cast<Vector3::ValueType>(value);
+                    }
+                }
+            }
+        }
+
+        if (element == vertex) {
+            positions[line_index - vertex->first_line] = Vector3{
+                    coordinates[0], coordinates[1], coordinates[2]};
+        } else if (!add_ply_polygon(values,
+                                    positions.size(),
+                                    corners,
+                                    chunk.indices)) {
+            chunk.error = "malformed face";
+            return;
+        }
+    }
+}
+
+static bool load_ascii_ply(const char* filename,
+                           std::string_view text,
+                           ThreadPool& pool,
+                           PlyHeader& header,
+                           const PlyElement*& vertex,
+                           const PlyElement*& face,
+                           MeshData& mesh) {
+    // Every element takes one line per item, in the order of the header.
+    std::size_t num_lines{0};
+    for (auto& element : header.elements) {
+        element.first_line = num_lines;
+        num_lines += element.count;
+    }
+
+    auto chunks{split_lines(text, pool)};
+    pool.run(chunks.size(), [&](auto chunk_index, auto) {
+        auto& chunk{chunks[chunk_index]};
+        chunk.count = std::count(chunk.text.begin(), chunk.text.end(), '\n')
+                      + (chunk.text.back() != '\n');
+    });
+    std::size_t line_index{0};
+    for (auto& chunk : chunks) {
+        chunk.first = line_index;
+        line_index += chunk.count;
+    }
+    if (line_index < num_lines) {
+        std::cerr << "Truncated PLY file '" << filename << "'.\n";
+        return false;
+    }
+
+    mesh.positions.resize(vertex->count);
+    pool.run(chunks.size(), [&](auto chunk_index, auto) {
+        parse_ply_chunk(chunks[chunk_index], vertex, face, mesh.positions);
+    });
+    return gather_indices(filename, chunks, pool, mesh);
+}
+
+// Returns the end of the record of `element` at `data`, or null if it runs
+// past `end`. Calls `on_list(property, count, items)` for every list.
+template <typename OnList>
+static const char* walk_record(const char* data,
+                               const char* end,
+                               const PlyElement& element,
+                               bool swap,
+                               OnList&& on_list) {
+    for (const auto& property : element.properties) {
+        if (!property.is_list) {
+            data += ply_size(property.type);
+            continue;
+        }
+        if (static_cast<std::size_t>(end - data)
+            < ply_size(property.count_type)) {
+            return nullptr;
+        }
+        auto count{load(data, property.count_type, swap)};
+        data += ply_size(property.count_type);
+        if (!(count >= 0)) {
+            return nullptr;
+        }
+        auto size{static_cast<std::size_t>(count) * ply_size(property.type)};
+        if (static_cast<std::size_t>(end - data) < size) {
+            return nullptr;
+        }
+        on_list(property, static_cast<std::size_t>(count), data);
+        data += size;
+    }
+    return data <= end ? data : nullptr;
+}
+
+// Converts the faces in parallel, assuming that they are all triangles and
+// so take the same space each. Returns false, leaving the rest to the
+// sequential path, as soon as one is not.
+static bool load_binary_triangles(const char* data,
+                                  const char* end,
+                                  const PlyElement& face,
+                                  bool swap,
+                                  std::size_t num_vertices,
+                                  ThreadPool& pool,
+                                  MeshData& mesh) {
+    std::size_t stride{0};
+    std::size_t list_offset{0};
+    const PlyProperty* list{nullptr};
+    for (const auto& property : face.properties) {
+        if (property.is_list) {
+            if (list || !is_vertex_indices(property)) {
+                return false;
+            }
+            list = &property;
+            list_offset = stride;
+            stride += ply_size(property.count_type)
+                      + 3 * ply_size(property.type);
+        } else {
+            stride += ply_size(property.type);
+        }
+    }
+    if (!list || static_cast<std::size_t>(end - data) / stride < face.count) {
+        return false;
+    }
+
+    mesh.indices.resize(face.count * 3);
+    auto num_chunks{pool.size() * chunks_per_thread};
+    std::atomic<bool> all_triangles{true};
+    pool.run(num_chunks, [&](auto chunk_index, auto) {
+        auto first{face.count * chunk_index / num_chunks};
+        auto last{face.count * (chunk_index + 1) / num_chunks};
+        auto count_size{ply_size(list->count_type)};
+        auto item_size{ply_size(list->type)};
+        for (auto i{first}; i < last && all_triangles; ++i) {
+            auto record{data + i * stride + list_offset};
+            if (load(record, list->count_type, swap) != 3) {
+                all_triangles = false;
+                return;
+            }
+            for (std::size_t corner{0}; corner < 3; ++corner) {
+                auto index{load(record + count_size + corner * item_size,
+                                list->type,
+                                swap)};
+                if (!(index >= 0 && index < num_vertices)) {
+                    all_triangles = false;
+                    return;
+                }
+                mesh.indices[i * 3 + corner]
+                        = static_cast<std::uint32_t>(index);
+            }
+        }
+    });
+    return all_triangles;
+}
+
+static bool load_binary_ply(const char* filename,
+                            std::string_view text,
+                            ThreadPool& pool,
+                            const PlyHeader& header,
+                            const PlyElement* vertex,
+                            const PlyElement* face,
+                            MeshData& mesh) {
+    auto error{[&](const char* message) {
+        std::cerr << "Invalid PLY file '" << filename << "': " << message
+                  << ".\n";
+        return false;
+    }};
+
+    std::uint16_t probe{1};
+    char first_byte;
+    std::memcpy(&first_byte, &probe, 1);
+    auto big_endian_machine{first_byte == 0};
+    auto swap{(header.format == PlyFormat::binary_big_endian)
+              != big_endian_machine};
+
+    auto data{text.data()};
+    auto end{text.data() + text.size()};
+    auto no_list{[](const PlyProperty&, std::size_t, const char*) {}};
+    for (const auto& element : header.elements) {
+        if (&element == vertex) {
+            std::size_t stride{0};
+            std::size_t offsets[3]{};
+            PlyType types[3]{};
+            for (const auto& property : element.properties) {
+                if (property.is_list) {
+                    return error("lists in vertices are not supported");
+                }
+                auto axis{property.name == "x"   ? 0
+                          : property.name == "y" ? 1
+                          : property.name == "z" ? 2
+                                                 : -1};
+                if (axis >= 0) {
+                    offsets[axis] = stride;
+                    types[axis] = property.type;
+                }
+                stride += ply_size(property.type);
+            }
+            if (static_cast<std::size_t>(end - data) / stride
+                < element.count) {
+                return error("truncated vertices");
+            }
+
+            mesh.positions.resize(element.count);
+            auto num_chunks{pool.size() * chunks_per_thread};
+            pool.run(num_chunks, [&](auto chunk_index, auto) {
+                auto first{element.count * chunk_index / num_chunks};
+                auto last{element.count * (chunk_index + 1) / num_chunks};
+                for (auto i{first}; i < last; ++i) {
+                    auto record{data + i * stride};
+                    mesh.positions[i] = Vector3{
+                            static_cast<Vector3::ValueType>(
+                                    load(record + offsets[0], types[0], swap)),
+                            static_cast<Vector3::ValueType>(
+                                    load(record + offsets[1], types[1], swap)),
+                            static_cast<Vector3::ValueType>(load(
+                                    record + offsets[2], types[2], swap))};
+                }
+            });
+            data += element.count * stride;
+        } else if (&element == face) {
+            if (load_binary_triangles(data,
+                                      end,
+                                      element,
+                                      swap,
+                                      vertex->count,
+                                      pool,
+                                      mesh)) {
+                return true;
+            }
+
+            mesh.indices.clear();
+            std::vector<double> values;
+            std::vector<std::uint32_t> corners;
+            for (std::size_t i{0}; i < element.count; ++i) {
+                values.clear();
+                data = walk_record(
+                        data,
+                        end,
+                        element,
+                        swap,
+                        [&](const auto& property, auto count, auto items) {
+                            if (!is_vertex_indices(property)) {
+                                return;
+                            }
+                            for (decltype(count) j{0}; j < count; ++j) {
+                                values.emplace_back(load(
+                                        items + j * ply_size(property.type),
+                                        property.type,
+                                        swap));
+                            }
+                        });
+                if (!data
+                    || !add_ply_polygon(values,
+                                        vertex->count,
+                                        corners,
+                                        mesh.indices)) {
+                    return error("malformed face");
+                }
+            }
+            return true;
+        } else {
+            for (std::size_t i{0}; i < element.count && data; ++i) {
+                data = walk_record(data, end, element, swap, no_list);
+            }
+            if (!data) {
+                return error("truncated element");
+            }
+        }
+    }
+    return true;
+}
+
+static bool load_ply(const char* filename,
+                     std::string_view text,
+                     ThreadPool& pool,
+                     MeshData& mesh) {
+    PlyHeader header;
+    if (!parse_ply_header(filename, text, header)) {
+        return false;
+    }
+
+    const PlyElement* vertex{nullptr};
+    const PlyElement* face{nullptr};
+    for (const auto& element : header.elements) {
+        if (element.name == "vertex") {
+            vertex = &element;
+        } else if (element.name == "face") {
+            face = &element;
+        }
+    }
+    if (!vertex || !face) {
+        std::cerr << "Invalid PLY file '" << filename
+                  << "': missing vertex or face element.\n";
+        return false;
+    }
+    if (vertex->count > std::numeric_limits<std::uint32_t>::max()) {
+        std::cerr << "Too many vertices in mesh file '" << filename << "'.\n";
+        return false;
+    }
+
+    text.remove_prefix(header.size);
+    if (header.format == PlyFormat::ascii) {
+        return load_ascii_ply(filename,
+                              text,
+                              pool,
+                              header,
+                              vertex,
+                              face,
+                              mesh);
+    }
+    return load_binary_ply(filename,
+                           text,
+                           pool,
+                           header,
+                           vertex,
+                           face,
+                           mesh);
+}
+
+bool load_mesh(const char* filename, ThreadPool& pool, MeshData& mesh) {
+    auto file{MappedFile::open(filename)};
+    if (!file) {
+        return false;
+    }
+    std::string_view text{file->data(), file->size()};
+
+    mesh = MeshData{};
+    auto loaded{false};
+    if (has_extension(filename, ".obj")) {
+        loaded = load_obj(filename, text, pool, mesh);
+    } else if (has_extension(filename, ".ply")) {
+        loaded = load_ply(filename, text, pool, mesh);
+    } else {
+        std::cerr << "Unsupported mesh format: " << filename
+                  << ". Use .obj or .ply.\n";
+        return false;
+    }
+    if (loaded && mesh.indices.empty()) {
+        std::cerr << "No triangles in mesh file '" << filename << "'.\n";
+        return false;
+    }
+    return loaded;
+}
+
+}
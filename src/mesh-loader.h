@@ -0,0 +1,24 @@
+#ifndef MESH_LOADER_H
+#define MESH_LOADER_H
+
+#include "thread-pool.h"
+#include "triangle-mesh.h"
+
+namespace ray_tracing {
+
+// Loads the triangles of a Wavefront OBJ or a PLY file, told apart by the
+// extension, into `mesh`, splitting polygons into fans. Only the vertex
+// positions and the faces are read.
+//
+// The file is memory-mapped and parsed on the threads of `pool`: text is
+// cut into chunks at line breaks, which are first scanned to find where the
+// vertices of each chunk start and then parsed at the same time, and the
+// fixed-size records of binary PLY files are converted in parallel ranges.
+//
+// Prints a message and returns false if the file cannot be read, is
+// malformed, or refers to vertices that do not exist.
+bool load_mesh(const char* filename, ThreadPool& pool, MeshData& mesh);
+
+}
+
+#endif
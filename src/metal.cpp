@@ -1,23 +1,30 @@
 #include "metal.h"
 
-#include "utils.h"
+#include "warp.h"
 
 #include <cmath>
 
 namespace ray_tracing {
 
-Metal::Metal(const Color& albedo, Vector3::ValueType fuzz)
+Metal::Metal(const Radiance& albedo, Vector3::ValueType fuzz)
     : albedo{albedo}, fuzz{std::fmax(0.0f, std::fmin(1.0f, fuzz))} {}
 
 bool Metal::scatter(const Ray& incident,
                     const Hittable::HitInfo& hit_info,
+                    const ScatterSample& sample,
                     Ray& scattered,
-                    Color& attenuation) const {
+                    Radiance& attenuation) const {
     auto reflected{reflect(incident.direction.normalized(), hit_info.normal)};
-    scattered = Ray{hit_info.point,
-                    reflected + fuzz * random_vector_in_unit_sphere()};
+    auto perturbation{cube_to_uniform_ball(sample.direction.u,
+                                           sample.direction.v,
+                                           sample.choice)};
+    scattered = Ray{hit_info.point, reflected + fuzz * perturbation};
     attenuation = albedo;
     return Vector3::dot(scattered.direction, hit_info.normal) > 0;
 }
 
+Radiance Metal::reflectance() const {
+    return albedo;
+}
+
 }
@@ -1,23 +1,28 @@
 #ifndef METAL_H
 #define METAL_H
 
-#include "color.h"
-#include "material.h"
+#include "hittable.h"
+#include "radiance.h"
+#include "ray.h"
+#include "sampler.h"
 #include "vector3.h"
 
 namespace ray_tracing {
 
-class Metal : public Material {
+class Metal {
 public:
-    Metal(const Color& albedo, Vector3::ValueType fuzz);
+    Metal(const Radiance& albedo, Vector3::ValueType fuzz);
 
     bool scatter(const Ray& incident,
                  const Hittable::HitInfo& hit_info,
+                 const ScatterSample& sample,
                  Ray& scattered,
-                 Color& attenuation) const override;
+                 Radiance& attenuation) const;
+
+    Radiance reflectance() const;
 
 private:
-    Color albedo;
+    Radiance albedo;
 
     Vector3::ValueType fuzz;
 };
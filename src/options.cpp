@@ -0,0 +1,277 @@
+#include "options.h"
+
+#include "image-output.h"
+#include "thread-pool.h"
+
+#include <algorithm>
+#include <iostream>
+#include <string>
+
+#include <cmath>
+#include <cstdlib>
+
+namespace ray_tracing {
+
+static const char* next_argument(int argc, char* argv[], int& i) {
+    if (i + 1 == argc) {
+        std::cerr << "Missing value for " << argv[i] << ".\n";
+        return nullptr;
+    }
+    return argv[++i];
+}
+
+static bool parse_value(int argc, char* argv[], int& i, std::size_t& value) {
+    auto text{next_argument(argc, argv, i)};
+    if (!text) {
+        return false;
+    }
+    char* end;
+    auto parsed{std::strtoull(text, &end, 10)};
+    if (end == text || *end != '\0' || parsed == 0) {
+        std::cerr << "Invalid value for " << argv[i - 1] << ": " << text
+                  << ".\n";
+        return false;
+    }
+    value = parsed;
+    return true;
+}
+
+static bool parse_value(int argc,
+                        char* argv[],
+                        int& i,
+                        float& value,
+                        bool allow_negative = false) {
+    auto text{next_argument(argc, argv, i)};
+    if (!text) {
+        return false;
+    }
+    char* end;
+    auto parsed{std::strtof(text, &end)};
+    if (end == text || *end != '\0' || std::isnan(parsed)
+        || (!allow_negative && parsed < 0)) {
+        std::cerr << "Invalid value for " << argv[i - 1] << ": " << text
+                  << ".\n";
+        return false;
+    }
+    value = parsed;
+    return true;
+}
+
+static bool parse_value(int argc,
+                        char* argv[],
+                        int& i,
+                        ToneMapOperator& value) {
+    auto text{next_argument(argc, argv, i)};
+    if (!text) {
+        return false;
+    }
+    std::string name{text};
+    if (name == "clamp") {
+        value = ToneMapOperator::clamp;
+    } else if (name == "reinhard") {
+        value = ToneMapOperator::reinhard;
+    } else if (name == "aces") {
+        value = ToneMapOperator::aces;
+    } else {
+        std::cerr << "Invalid value for " << argv[i - 1] << ": " << text
+                  << ".\n";
+        return false;
+    }
+    return true;
+}
+
+static bool parse_value(int argc, char* argv[], int& i, SamplerType& value) {
+    auto text{next_argument(argc, argv, i)};
+    if (!text) {
+        return false;
+    }
+    std::string name{text};
+    if (name == "independent") {
+        value = SamplerType::independent;
+    } else if (name == "stratified") {
+        value = SamplerType::stratified;
+    } else if (name == "sobol") {
+        value = SamplerType::sobol;
+    } else if (name == "blue-noise") {
+        value = SamplerType::blue_noise;
+    } else {
+        std::cerr << "Invalid value for " << argv[i - 1] << ": " << text
+                  << ".\n";
+        return false;
+    }
+    return true;
+}
+
+static bool parse_value(int argc, char* argv[], int& i, Aov& value) {
+    auto text{next_argument(argc, argv, i)};
+    if (!text) {
+        return false;
+    }
+    std::string name{text};
+    if (name == "albedo") {
+        value = Aov::albedo;
+    } else if (name == "normal") {
+        value = Aov::normal;
+    } else if (name == "depth") {
+        value = Aov::depth;
+    } else if (name == "material") {
+        value = Aov::material_id;
+    } else if (name == "object") {
+        value = Aov::object_id;
+    } else {
+        std::cerr << "Invalid value for " << argv[i - 1] << ": " << text
+                  << ".\n";
+        return false;
+    }
+    return true;
+}
+
+bool parse_options(int argc, char* argv[], Options& options) {
+    options.num_threads = ThreadPool::default_size();
+
+    for (auto i{1}; i < argc; ++i) {
+        std::string argument{argv[i]};
+        if (argument == "--scene") {
+            options.scene_filename = next_argument(argc, argv, i);
+            if (!options.scene_filename) {
+                return false;
+            }
+        } else if (argument == "--export-scene") {
+            options.export_scene_filename = next_argument(argc, argv, i);
+            if (!options.export_scene_filename) {
+                return false;
+            }
+        } else if (argument == "--width") {
+            if (!parse_value(argc, argv, i, options.image_width)) {
+                return false;
+            }
+        } else if (argument == "--height") {
+            if (!parse_value(argc, argv, i, options.image_height)) {
+                return false;
+            }
+        } else if (argument == "--spp") {
+            if (!parse_value(argc, argv, i, options.samples_per_pixel)) {
+                return false;
+            }
+        } else if (argument == "--depth") {
+            if (!parse_value(argc, argv, i, options.max_depth)) {
+                return false;
+            }
+        } else if (argument == "--frames") {
+            if (!parse_value(argc, argv, i, options.num_frames)) {
+                return false;
+            }
+        } else if (argument == "--threads") {
+            if (!parse_value(argc, argv, i, options.num_threads)) {
+                return false;
+            }
+        } else if (argument == "--tile-size") {
+            if (!parse_value(argc, argv, i, options.tile_size)) {
+                return false;
+            }
+        } else if (argument == "--packet") {
+            options.packet_tracing = true;
+        } else if (argument == "--adaptive-threshold") {
+            if (!parse_value(argc, argv, i, options.adaptive_threshold)) {
+                return false;
+            }
+        } else if (argument == "--sampler") {
+            if (!parse_value(argc, argv, i, options.sampler)) {
+                return false;
+            }
+        } else if (argument == "--denoise") {
+            options.denoise = true;
+        } else if (argument == "--aov") {
+            Aov aov;
+            if (!parse_value(argc, argv, i, aov)) {
+                return false;
+            }
+            if (std::find(options.aovs.begin(), options.aovs.end(), aov)
+                == options.aovs.end()) {
+                options.aovs.push_back(aov);
+            }
+        } else if (argument == "--checkpoint") {
+            options.checkpoint_filename = next_argument(argc, argv, i);
+            if (!options.checkpoint_filename) {
+                return false;
+            }
+        } else if (argument == "--checkpoint-interval") {
+            if (!parse_value(argc, argv, i, options.checkpoint_interval)) {
+                return false;
+            }
+        } else if (argument == "--exposure") {
+            if (!parse_value(argc, argv, i, options.tone_map.exposure, true)) {
+                return false;
+            }
+        } else if (argument == "--tone-map") {
+            if (!parse_value(argc,
+                             argv,
+                             i,
+                             options.tone_map.tone_map_operator)) {
+                return false;
+            }
+        } else if (argument == "--half") {
+            options.half_float = true;
+#ifdef USE_STATS
+        } else if (argument == "--stats") {
+            options.stats_filename = next_argument(argc, argv, i);
+            if (!options.stats_filename) {
+                return false;
+            }
+        } else if (argument == "--heatmap") {
+            options.heatmap_filename = next_argument(argc, argv, i);
+            if (!options.heatmap_filename) {
+                return false;
+            }
+#endif
+        } else if (argument.size() > 1 && argument[0] == '-') {
+            std::cerr << "Unknown option: " << argument << ".\n";
+            return false;
+        } else if (!options.output_filename) {
+            options.output_filename = argv[i];
+        } else {
+            std::cerr << "Unexpected argument: " << argument << ".\n";
+            return false;
+        }
+    }
+
+    if (!options.output_filename && !options.export_scene_filename) {
+        std::cerr << "Missing output file name.\n";
+        return false;
+    }
+    ImageFormat format;
+    if (options.heatmap_filename
+        && !image_format(options.heatmap_filename, format)) {
+        return false;
+    }
+    if (!options.output_filename) {
+        return true;
+    }
+    if (!image_format(options.output_filename, format)) {
+        return false;
+    }
+    if (!options.aovs.empty() && format != ImageFormat::exr) {
+        std::cerr << "AOVs can only be written to .exr files.\n";
+        return false;
+    }
+    return true;
+}
+
+void print_usage(const char* program) {
+    std::cerr << "Usage: " << program
+              << " [--scene <file>] [--export-scene <file>]"
+                 " [--width <n>] [--height <n>] [--spp <n>] [--depth <n>]"
+                 " [--frames <n>] [--threads <n>] [--tile-size <n>] [--packet]"
+                 " [--adaptive-threshold <error>]"
+                 " [--sampler independent|stratified|sobol|blue-noise]"
+                 " [--denoise] [--aov albedo|normal|depth|material|object]"
+                 " [--checkpoint <file>] [--checkpoint-interval <seconds>]"
+                 " [--exposure <stops>] [--tone-map clamp|reinhard|aces]"
+                 " [--half]";
+#ifdef USE_STATS
+    std::cerr << " [--stats <file.json>] [--heatmap <file>]";
+#endif
+    std::cerr << " <output.png|.pfm|.exr>\n";
+}
+
+}
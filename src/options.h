@@ -0,0 +1,74 @@
+#ifndef OPTIONS_H
+#define OPTIONS_H
+
+#include "feature-buffer.h"
+#include "sampler.h"
+#include "tone-mapper.h"
+
+#include <cstddef>
+#include <vector>
+
+namespace ray_tracing {
+
+struct Options {
+    const char* output_filename{nullptr};
+
+    // Renders the built-in random scene when null.
+    const char* scene_filename{nullptr};
+
+    // Writes the scene in the binary format and exits when set.
+    const char* export_scene_filename{nullptr};
+
+    // Override the scene's settings when not zero.
+    std::size_t image_width{0};
+
+    std::size_t image_height{0};
+
+    std::size_t samples_per_pixel{0};
+
+    std::size_t max_depth{0};
+
+    std::size_t num_frames{0};
+
+    std::size_t num_threads{0};
+
+    std::size_t tile_size{16};
+
+    bool packet_tracing{false};
+
+    float adaptive_threshold{0};
+
+    SamplerType sampler{SamplerType::sobol};
+
+    // Filters the noise out of the final image, though not the previews
+    // written with checkpoints.
+    bool denoise{false};
+
+    // Written as extra channels of the output, which must be an EXR file.
+    std::vector<Aov> aovs;
+
+    const char* checkpoint_filename{nullptr};
+
+    float checkpoint_interval{300};
+
+    ToneMapSettings tone_map;
+
+    // Writes EXR channels as 16-bit halves instead of 32-bit floats.
+    bool half_float{false};
+
+    // Where to write the render statistics and the heatmap of the time spent
+    // on each pixel, in builds with USE_STATS.
+    const char* stats_filename{nullptr};
+
+    const char* heatmap_filename{nullptr};
+};
+
+// Parses the command line into `options`, printing a message and returning
+// false on malformed input.
+bool parse_options(int argc, char* argv[], Options& options);
+
+void print_usage(const char* program);
+
+}
+
+#endif
@@ -0,0 +1,239 @@
+#include "path-integrator.h"
+
+#include "render-stats.h"
+#include "utils.h"
+
+#include <algorithm>
+
+#include <cmath>
+
+namespace ray_tracing {
+
+// The sky, blending from white at the horizon to blue overhead. Rays keep
+// their directions normalized, so the clamp only guards against a blend
+// factor rounded just past 0 or 1.
+static Radiance background_radiance(const Ray& ray) {
+    auto t{std::clamp(0.5f * (static_cast<float>(ray.direction.y) + 1),
+                      0.0f,
+                      1.0f)};
+    return Radiance::lerp(Radiance::white, Radiance{0.5f, 0.7f, 1}, t);
+}
+
+// Shadow rays stop short of the light by this fraction of the distance, so
+// that they do not hit the light itself.
+static constexpr Vector3::ValueType shadow_ray_margin{1e-3};
+
+static Vector3::ValueType power_heuristic(Vector3::ValueType pdf,
+                                          Vector3::ValueType other_pdf) {
+    auto square{pdf * pdf};
+    return square / (square + other_pdf * other_pdf);
+}
+
+PathIntegrator::PathIntegrator(const Hittable& world,
+                               const std::vector<Material>& materials,
+                               const LightSampler& lights,
+                               std::size_t max_depth)
+    : world{world},
+      materials{materials},
+      lights{lights},
+      max_depth{max_depth} {}
+
+Radiance PathIntegrator::trace(const Ray& ray,
+                               SampleStream& stream) const {
+    add_stat(Stat::camera_rays);
+    Hittable::HitInfo hit_info;
+    auto hit{world.hit(ray, hit_info)};
+    return trace(ray, hit, hit_info, stream);
+}
+
+Radiance PathIntegrator::trace(const Ray& ray,
+                               bool hit,
+                               const Hittable::HitInfo& hit_info,
+                               SampleStream& stream) const {
+    std::size_t num_bounces;
+    auto radiance{trace_path(ray, hit, hit_info, stream, num_bounces)};
+    add_path_length(num_bounces);
+    return radiance;
+}
+
+Radiance PathIntegrator::trace_path(const Ray& ray,
+                                    bool hit,
+                                    const Hittable::HitInfo& hit_info,
+                                    SampleStream& stream,
+                                    std::size_t& num_bounces) const {
+    auto radiance{Radiance::black};
+    auto throughput{Radiance::white};
+    auto current_ray{ray};
+    auto current_hit_info{hit_info};
+
+    // The density the last bounce scattered with, or zero when the light
+    // its ray reaches could not also have been sampled from there.
+    Vector3::ValueType scatter_pdf{0};
+
+    for (auto depth{decltype(max_depth){0}};; ++depth) {
+        num_bounces = depth;
+        if (!hit) {
+            return radiance + throughput * background_radiance(current_ray);
+        }
+
+        const auto& material{materials[current_hit_info.material_id]};
+        auto emission{emitted(material, current_ray, current_hit_info)};
+        if (emission.max_component() > 0) {
+            auto weight{scatter_pdf > 0 ? power_heuristic(
+                                                  scatter_pdf,
+                                                  light_pdf(current_ray,
+                                                            current_hit_info,
+                                                            emission))
+                                        : 1};
+            radiance += static_cast<Radiance::ValueType>(weight) * throughput
+                        * emission;
+        }
+        if (depth == max_depth) {
+            return radiance;
+        }
+        if (!lights.empty()) {
+            radiance += throughput
+                        * sample_light(current_ray, current_hit_info, stream);
+        }
+
+        ScatterSample scatter_sample{stream.next_2d(), stream.next_1d()};
+        Ray scattered;
+        Radiance attenuation;
+        if (!scatter(material,
+                     current_ray,
+                     current_hit_info,
+                     scatter_sample,
+                     scattered,
+                     attenuation)) {
+            return radiance;
+        }
+        throughput *= attenuation;
+
+        Radiance value;
+        if (lights.empty()
+            || !evaluate(material,
+                         current_ray,
+                         current_hit_info,
+                         scattered.direction,
+                         value,
+                         scatter_pdf)) {
+            scatter_pdf = 0;
+        }
+
+        auto max_component{throughput.max_component()};
+        if (max_component < min_throughput) {
+            return radiance;
+        }
+        if (depth + 1 >= min_roulette_depth) {
+            auto survival_probability{
+                    std::min(max_component, max_survival_probability)};
+            if (stream.next_1d() >= survival_probability) {
+                add_stat(Stat::roulette_terminations);
+                return radiance;
+            }
+            throughput *= 1 / survival_probability;
+        }
+
+        current_ray = scattered;
+        add_stat(Stat::scatter_rays);
+        hit = world.hit(current_ray, current_hit_info);
+    }
+}
+
+void PathIntegrator::trace_features(const Ray& ray,
+                                    SampleStream& stream,
+                                    FeatureBuffer::Pixel& features) const {
+    features = FeatureBuffer::Pixel{};
+    auto current_ray{ray};
+    for (std::size_t depth{0};; ++depth) {
+        auto direction{current_ray.direction.normalized()};
+        Hittable::HitInfo hit_info;
+        if (!world.hit(current_ray, hit_info)) {
+            features.normal = -direction;
+            features.depth = 0;
+            return;
+        }
+        if (depth == 0) {
+            features.material_id = hit_info.material_id + 1;
+            features.object_id = hit_info.object_id + 1;
+        }
+        features.depth += static_cast<float>(
+                (hit_info.point - current_ray.origin).magnitude());
+        features.normal = Vector3::dot(direction, hit_info.normal) > 0
+                                  ? -hit_info.normal
+                                  : hit_info.normal;
+
+        const auto& material{materials[hit_info.material_id]};
+        if (!is_specular(material) || depth + 1 == max_feature_depth) {
+            features.albedo *= albedo(material);
+            return;
+        }
+        ScatterSample scatter_sample{stream.next_2d(), stream.next_1d()};
+        Ray scattered;
+        Radiance attenuation;
+        auto scattered_any{scatter(material,
+                                   current_ray,
+                                   hit_info,
+                                   scatter_sample,
+                                   scattered,
+                                   attenuation)};
+        features.albedo *= attenuation;
+        if (!scattered_any) {
+            return;
+        }
+        current_ray = scattered;
+    }
+}
+
+Radiance PathIntegrator::sample_light(const Ray& incident,
+                                      const Hittable::HitInfo& hit_info,
+                                      SampleStream& stream) const {
+    Vector3 point;
+    Vector3 normal;
+    Radiance radiance;
+    auto area_pdf{lights.sample(stream, point, normal, radiance)};
+    auto offset{point - hit_info.point};
+    auto distance_squared{offset.magnitude_sqaured()};
+    auto distance{std::sqrt(distance_squared)};
+    auto direction{offset / distance};
+    auto light_cosine{-Vector3::dot(normal, direction)};
+    if (light_cosine <= 0) {
+        return Radiance::black;
+    }
+
+    Radiance value;
+    Vector3::ValueType scatter_pdf;
+    if (!evaluate(materials[hit_info.material_id],
+                  incident,
+                  hit_info,
+                  direction,
+                  value,
+                  scatter_pdf)
+        || scatter_pdf <= 0) {
+        return Radiance::black;
+    }
+
+    add_stat(Stat::shadow_rays);
+    Hittable::HitInfo blocker;
+    if (world.hit(Ray{hit_info.point, direction},
+                  blocker,
+                  Hittable::default_min_distance,
+                  distance * (1 - shadow_ray_margin))) {
+        return Radiance::black;
+    }
+
+    auto pdf{area_pdf * distance_squared / light_cosine};
+    auto weight{power_heuristic(pdf, scatter_pdf)};
+    return static_cast<Radiance::ValueType>(weight / pdf) * value * radiance;
+}
+
+Vector3::ValueType PathIntegrator::light_pdf(
+        const Ray& ray,
+        const Hittable::HitInfo& hit_info,
+        const Radiance& radiance) const {
+    auto cosine{-Vector3::dot(ray.direction, hit_info.normal)};
+    return lights.area_pdf(radiance) * hit_info.distance * hit_info.distance
+           / cosine;
+}
+
+}
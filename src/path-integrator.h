@@ -0,0 +1,96 @@
+#ifndef PATH_INTEGRATOR_H
+#define PATH_INTEGRATOR_H
+
+#include "feature-buffer.h"
+#include "hittable.h"
+#include "light-sampler.h"
+#include "material.h"
+#include "radiance.h"
+#include "ray.h"
+#include "sampler.h"
+#include "vector3.h"
+
+#include <cstddef>
+#include <vector>
+
+namespace ray_tracing {
+
+// Estimates the radiance arriving along a camera ray by following a single
+// scattering path iteratively. The path carries its throughput, the product
+// of the attenuations so far, and after a few bounces is terminated with
+// Russian roulette in proportion to how little it can still contribute.
+//
+// At every diffuse surface a point on one of the lights is also sampled and
+// connected to it with a shadow ray. Light reaching the path both ways is
+// weighted with the power heuristic of multiple importance sampling, so
+// that small, bright lights are found by the shadow rays and large, dim
+// ones by scattering, without counting either twice.
+class PathIntegrator {
+public:
+    PathIntegrator(const Hittable& world,
+                   const std::vector<Material>& materials,
+                   const LightSampler& lights,
+                   std::size_t max_depth);
+
+    // Draws the numbers of each path vertex from `stream`, the same
+    // dimensions at the same depth in every sample.
+    Radiance trace(const Ray& ray, SampleStream& stream) const;
+
+    // Continues a path whose first intersection is already known, such as
+    // one found by tracing a packet of camera rays.
+    Radiance trace(const Ray& ray,
+                   bool hit,
+                   const Hittable::HitInfo& hit_info,
+                   SampleStream& stream) const;
+
+    // Follows `ray` through specular surfaces to the first other surface it
+    // reaches and sets `features` to what it finds there, with the ids of
+    // the surface it hits first. A ray that escapes keeps the attenuation
+    // on the way as its albedo, faces straight back and has a depth of
+    // zero.
+    void trace_features(const Ray& ray,
+                        SampleStream& stream,
+                        FeatureBuffer::Pixel& features) const;
+
+private:
+    // Follows the path, setting `num_bounces` to the number of times it
+    // scattered before it ended.
+    Radiance trace_path(const Ray& ray,
+                        bool hit,
+                        const Hittable::HitInfo& hit_info,
+                        SampleStream& stream,
+                        std::size_t& num_bounces) const;
+
+    // The light arriving at a diffuse hit directly from a sampled point on
+    // a light, weighted against finding that point by scattering.
+    Radiance sample_light(const Ray& incident,
+                          const Hittable::HitInfo& hit_info,
+                          SampleStream& stream) const;
+
+    // The density, per unit of solid angle, with which `sample_light`
+    // picks the point on an emitter of `radiance` that `ray` hit.
+    Vector3::ValueType light_pdf(const Ray& ray,
+                                 const Hittable::HitInfo& hit_info,
+                                 const Radiance& radiance) const;
+
+    static constexpr std::size_t min_roulette_depth{3};
+
+    static constexpr Radiance::ValueType max_survival_probability{0.95};
+
+    static constexpr Radiance::ValueType min_throughput{1e-4};
+
+    // Of the specular surfaces `trace_features` looks through.
+    static constexpr std::size_t max_feature_depth{8};
+
+    const Hittable& world;
+
+    const std::vector<Material>& materials;
+
+    const LightSampler& lights;
+
+    std::size_t max_depth;
+};
+
+}
+
+#endif
@@ -0,0 +1,158 @@
+#ifndef RADIANCE_H
+#define RADIANCE_H
+
+namespace ray_tracing {
+
+// Linear RGB radiance, or a reflectance that scales it, as carried along a
+// path. Unlike `BasicColor` it is never clamped, so bright contributions
+// keep their energy until the film is tone mapped, and it has no alpha.
+template <typename T>
+struct BasicRadiance {
+    using ValueType = T;
+
+    BasicRadiance() = default;
+
+    constexpr BasicRadiance(ValueType r, ValueType g, ValueType b);
+
+    static constexpr BasicRadiance lerp(const BasicRadiance& r0,
+                                        const BasicRadiance& r1,
+                                        ValueType t);
+
+    constexpr ValueType max_component() const;
+
+    // The relative luminance of the Rec. 709 primaries.
+    constexpr ValueType luminance() const;
+
+    static const BasicRadiance black;
+
+    static const BasicRadiance white;
+
+    ValueType r;
+
+    ValueType g;
+
+    ValueType b;
+};
+
+using Radiance = BasicRadiance<float>;
+
+template <typename T>
+constexpr BasicRadiance<T> operator+(const BasicRadiance<T>& lhs,
+                                     const BasicRadiance<T>& rhs);
+
+// Multiplies component-wise, as when attenuating by a reflectance.
+template <typename T>
+constexpr BasicRadiance<T> operator*(const BasicRadiance<T>& lhs,
+                                     const BasicRadiance<T>& rhs);
+
+template <typename T>
+constexpr BasicRadiance<T> operator*(
+        typename BasicRadiance<T>::ValueType lhs,
+        const BasicRadiance<T>& rhs);
+
+template <typename T>
+constexpr BasicRadiance<T> operator*(
+        const BasicRadiance<T>& lhs,
+        typename BasicRadiance<T>::ValueType rhs);
+
+template <typename T>
+constexpr BasicRadiance<T>& operator+=(BasicRadiance<T>& lhs,
+                                       const BasicRadiance<T>& rhs);
+
+template <typename T>
+constexpr BasicRadiance<T>& operator*=(BasicRadiance<T>& lhs,
+                                       const BasicRadiance<T>& rhs);
+
+template <typename T>
+constexpr BasicRadiance<T>& operator*=(
+        BasicRadiance<T>& lhs,
+        typename BasicRadiance<T>::ValueType rhs);
+
+template <typename T>
+constexpr BasicRadiance<T>::BasicRadiance(ValueType r,
+                                          ValueType g,
+                                          ValueType b)
+    : r{r}, g{g}, b{b} {}
+
+template <typename T>
+constexpr BasicRadiance<T> BasicRadiance<T>::lerp(const BasicRadiance& r0,
+                                                  const BasicRadiance& r1,
+                                                  ValueType t) {
+    return (1 - t) * r0 + t * r1;
+}
+
+template <typename T>
+constexpr T BasicRadiance<T>::max_component() const {
+    auto max_rg{r < g ? g : r};
+    return max_rg < b ? b : max_rg;
+}
+
+template <typename T>
+constexpr T BasicRadiance<T>::luminance() const {
+    return ValueType{0.2126} * r + ValueType{0.7152} * g
+           + ValueType{0.0722} * b;
+}
+
+template <typename T>
+constexpr BasicRadiance<T> BasicRadiance<T>::black{0, 0, 0};
+
+template <typename T>
+constexpr BasicRadiance<T> BasicRadiance<T>::white{1, 1, 1};
+
+template <typename T>
+constexpr BasicRadiance<T> operator+(const BasicRadiance<T>& lhs,
+                                     const BasicRadiance<T>& rhs) {
+    return BasicRadiance<T>{lhs.r + rhs.r, lhs.g + rhs.g, lhs.b + rhs.b};
+}
+
+template <typename T>
+constexpr BasicRadiance<T> operator*(const BasicRadiance<T>& lhs,
+                                     const BasicRadiance<T>& rhs) {
+    return BasicRadiance<T>{lhs.r * rhs.r, lhs.g * rhs.g, lhs.b * rhs.b};
+}
+
+template <typename T>
+constexpr BasicRadiance<T> operator*(
+        typename BasicRadiance<T>::ValueType lhs,
+        const BasicRadiance<T>& rhs) {
+    return BasicRadiance<T>{lhs * rhs.r, lhs * rhs.g, lhs * rhs.b};
+}
+
+template <typename T>
+constexpr BasicRadiance<T> operator*(
+        const BasicRadiance<T>& lhs,
+        typename BasicRadiance<T>::ValueType rhs) {
+    return rhs * lhs;
+}
+
+template <typename T>
+constexpr BasicRadiance<T>& operator+=(BasicRadiance<T>& lhs,
+                                       const BasicRadiance<T>& rhs) {
+    lhs.r += rhs.r;
+    lhs.g += rhs.g;
+    lhs.b += rhs.b;
+    return lhs;
+}
+
+template <typename T>
+constexpr BasicRadiance<T>& operator*=(BasicRadiance<T>& lhs,
+                                       const BasicRadiance<T>& rhs) {
+    lhs.r *= rhs.r;
+    lhs.g *= rhs.g;
+    lhs.b *= rhs.b;
+    return lhs;
+}
+
+template <typename T>
+constexpr BasicRadiance<T>& operator*=(
+        BasicRadiance<T>& lhs,
+        typename BasicRadiance<T>::ValueType rhs) {
+    lhs.r *= rhs;
+    lhs.g *= rhs;
+    lhs.b *= rhs;
+    return lhs;
+}
+
+}
+
+#endif
@@ -0,0 +1,47 @@
+#include "random-generator.h"
+
+namespace ray_tracing {
+
+static constexpr std::uint64_t multiplier{6364136223846793005ull};
+
+static std::uint64_t mix(std::uint64_t value) {
+    value += 0x9e3779b97f4a7c15ull;
+    value = (value ^ (value >> 30)) * 0xbf58476d1ce4e5b9ull;
+    value = (value ^ (value >> 27)) * 0x94d049bb133111ebull;
+    return value ^ (value >> 31);
+}
+
+RandomGenerator::RandomGenerator(std::uint64_t seed, std::uint64_t stream)
+    : increment{(stream << 1) | 1} {
+    next_uint32();
+    state += seed;
+    next_uint32();
+}
+
+RandomGenerator RandomGenerator::for_sample(std::uint64_t pixel_index,
+                                            std::uint64_t sample_index,
+                                            std::uint64_t frame_index) {
+    return RandomGenerator{mix(pixel_index ^ mix(frame_index)),
+                           mix(sample_index)};
+}
+
+std::uint32_t RandomGenerator::next_uint32() {
+    auto old_state{state};
+    state = old_state * multiplier + increment;
+    auto xorshifted{
+            static_cast<std::uint32_t>(((old_state >> 18) ^ old_state) >> 27)};
+    auto rotation{static_cast<std::uint32_t>(old_state >> 59)};
+    return (xorshifted >> rotation) | (xorshifted << ((-rotation) & 31));
+}
+
+float RandomGenerator::next_float() {
+    return (next_uint32() >> 8) * 0x1p-24f;
+}
+
+double RandomGenerator::next_double() {
+    auto high{static_cast<std::uint64_t>(next_uint32()) << 21};
+    auto low{static_cast<std::uint64_t>(next_uint32()) >> 11};
+    return (high | low) * 0x1p-53;
+}
+
+}
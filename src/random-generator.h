@@ -0,0 +1,36 @@
+#ifndef RANDOM_GENERATOR_H
+#define RANDOM_GENERATOR_H
+
+#include <cstdint>
+
+namespace ray_tracing {
+
+// A PCG32 generator (XSH-RR output on a 64-bit LCG). It is small enough to
+// live on the stack of every sample, so no generator state is ever shared
+// between threads.
+class RandomGenerator {
+public:
+    RandomGenerator(std::uint64_t seed = 0, std::uint64_t stream = 0);
+
+    // Returns a generator whose sequence depends only on the pixel, the
+    // sample within the pixel and the frame, never on which thread or
+    // process happens to render the sample.
+    static RandomGenerator for_sample(std::uint64_t pixel_index,
+                                      std::uint64_t sample_index,
+                                      std::uint64_t frame_index = 0);
+
+    std::uint32_t next_uint32();
+
+    float next_float();
+
+    double next_double();
+
+private:
+    std::uint64_t state{0};
+
+    std::uint64_t increment{1};
+};
+
+}
+
+#endif
@@ -0,0 +1,23 @@
+#ifndef RAY_PACKET_H
+#define RAY_PACKET_H
+
+#include "ray.h"
+#include "simd.h"
+
+#include <cstddef>
+
+namespace ray_tracing {
+
+// A group of up to one SIMD register's worth of rays that are traced
+// together, such as the camera rays of one pixel.
+struct RayPacket {
+    static constexpr std::size_t max_size{SimdFloat::width};
+
+    Ray rays[max_size];
+
+    std::size_t size{0};
+};
+
+}
+
+#endif
@@ -0,0 +1,262 @@
+#include "render-stats.h"
+
+#include "film.h"
+#include "image-output.h"
+#include "tile.h"
+#include "tone-mapper.h"
+
+#ifdef USE_MPI
+#include <mpi.h>
+#endif
+
+#include <algorithm>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <numeric>
+
+#include <cstdio>
+
+namespace ray_tracing {
+
+std::vector<float> heatmap_seconds;
+
+static std::size_t heatmap_width{0};
+
+static std::size_t heatmap_height{0};
+
+// Every block ever handed out, kept for as long as the program runs so that
+// threads may come and go.
+static std::mutex registry_mutex;
+
+static std::vector<std::unique_ptr<ThreadStats>> registry;
+
+ThreadStats& register_thread_stats() {
+    std::lock_guard<std::mutex> lock{registry_mutex};
+    registry.emplace_back(std::make_unique<ThreadStats>());
+    return *registry.back();
+}
+
+std::uint64_t RenderStats::count(Stat stat) const {
+    return counts[static_cast<std::size_t>(stat)];
+}
+
+std::uint64_t RenderStats::num_rays() const {
+    return count(Stat::camera_rays) + count(Stat::scatter_rays)
+           + count(Stat::shadow_rays);
+}
+
+void reset_stats(std::size_t image_width, std::size_t image_height) {
+    std::lock_guard<std::mutex> lock{registry_mutex};
+    for (auto& thread_stats : registry) {
+        *thread_stats = ThreadStats{};
+    }
+    heatmap_seconds.assign(image_width * image_height, 0);
+    heatmap_width = image_width;
+    heatmap_height = image_height;
+}
+
+RenderStats collect_stats() {
+    RenderStats stats{};
+    std::lock_guard<std::mutex> lock{registry_mutex};
+    for (const auto& thread_stats : registry) {
+        for (std::size_t i{0}; i < num_stats; ++i) {
+            stats.counts[i] += thread_stats->counts[i];
+        }
+        for (std::size_t i{0}; i <= max_path_length; ++i) {
+            stats.path_lengths[i] += thread_stats->path_lengths[i];
+        }
+        const auto* counts{thread_stats->counts};
+        stats.rays_per_thread.emplace_back(
+                counts[static_cast<std::size_t>(Stat::camera_rays)]
+                + counts[static_cast<std::size_t>(Stat::scatter_rays)]
+                + counts[static_cast<std::size_t>(Stat::shadow_rays)]);
+    }
+    stats.image_width = heatmap_width;
+    stats.image_height = heatmap_height;
+    stats.pixel_seconds = heatmap_seconds;
+    return stats;
+}
+
+#ifdef USE_MPI
+void reduce_stats(RenderStats& stats) {
+    int world_rank;
+    MPI_Comm_rank(MPI_COMM_WORLD, &world_rank);
+    auto reduce{[&](auto* values, int count, MPI_Datatype type) {
+        if (world_rank == 0) {
+            MPI_Reduce(MPI_IN_PLACE,
+                       values,
+                       count,
+                       type,
+                       MPI_SUM,
+                       0,
+                       MPI_COMM_WORLD);
+        } else {
+            MPI_Reduce(values,
+                       nullptr,
+                       count,
+                       type,
+                       MPI_SUM,
+                       0,
+                       MPI_COMM_WORLD);
+        }
+    }};
+    reduce(stats.counts, num_stats, MPI_UINT64_T);
+    reduce(stats.path_lengths, max_path_length + 1, MPI_UINT64_T);
+    reduce(stats.pixel_seconds.data(),
+           static_cast<int>(stats.pixel_seconds.size()),
+           MPI_FLOAT);
+
+    // The threads of every rank are listed one after the other.
+    auto num_threads{static_cast<int>(stats.rays_per_thread.size())};
+    int world_size;
+    MPI_Comm_size(MPI_COMM_WORLD, &world_size);
+    std::vector<int> counts(world_size);
+    MPI_Gather(&num_threads,
+               1,
+               MPI_INT,
+               counts.data(),
+               1,
+               MPI_INT,
+               0,
+               MPI_COMM_WORLD);
+    std::vector<int> displacements(world_size);
+    std::exclusive_scan(counts.begin(), counts.end(), displacements.begin(), 0);
+    std::vector<std::uint64_t> rays_per_thread(
+            world_rank == 0 ? displacements.back() + counts.back() : 0);
+    MPI_Gatherv(stats.rays_per_thread.data(),
+                num_threads,
+                MPI_UINT64_T,
+                rays_per_thread.data(),
+                counts.data(),
+                displacements.data(),
+                MPI_UINT64_T,
+                0,
+                MPI_COMM_WORLD);
+    if (world_rank == 0) {
+        stats.rays_per_thread = std::move(rays_per_thread);
+    }
+}
+#endif
+
+static const char* stat_name(Stat stat) {
+    switch (stat) {
+    case Stat::camera_rays:
+        return "camera_rays";
+    case Stat::scatter_rays:
+        return "scatter_rays";
+    case Stat::shadow_rays:
+        return "shadow_rays";
+    case Stat::intersection_tests:
+        return "intersection_tests";
+    case Stat::bvh_nodes_visited:
+        return "bvh_nodes_visited";
+    case Stat::roulette_terminations:
+        break;
+    }
+    return "roulette_terminations";
+}
+
+bool write_stats(const char* filename,
+                 const RenderStats& stats,
+                 std::size_t tile_size,
+                 double seconds) {
+    auto fp{std::fopen(filename, "w")};
+    if (!fp) {
+        std::cerr << "Could not open statistics file '" << filename
+                  << "'.\n";
+        return false;
+    }
+
+    std::fprintf(fp, "{\n  \"seconds\": %.6f,\n", seconds);
+    for (std::size_t i{0}; i < num_stats; ++i) {
+        std::fprintf(fp,
+                     "  \"%s\": %llu,\n",
+                     stat_name(static_cast<Stat>(i)),
+                     static_cast<unsigned long long>(stats.counts[i]));
+    }
+    std::fprintf(fp,
+                 "  \"rays\": %llu,\n  \"rays_per_second\": %.1f,\n",
+                 static_cast<unsigned long long>(stats.num_rays()),
+                 seconds > 0 ? stats.num_rays() / seconds : 0.0);
+
+    // Bin `i` counts the paths that ended after `i` bounces.
+    std::fprintf(fp, "  \"path_lengths\": [");
+    for (std::size_t i{0}; i <= max_path_length; ++i) {
+        std::fprintf(fp,
+                     "%s%llu",
+                     i > 0 ? ", " : "",
+                     static_cast<unsigned long long>(stats.path_lengths[i]));
+    }
+    std::fprintf(fp, "],\n  \"rays_per_thread\": [");
+    for (std::size_t i{0}; i < stats.rays_per_thread.size(); ++i) {
+        std::fprintf(fp,
+                     "%s%llu",
+                     i > 0 ? ", " : "",
+                     static_cast<unsigned long long>(
+                             stats.rays_per_thread[i]));
+    }
+    std::fprintf(fp, "],\n");
+
+    // Each tile's time is the sum of the time spent on its pixels, over all
+    // passes.
+    auto tiles{make_tiles(stats.image_width, 0, stats.image_height, tile_size)};
+    std::fprintf(fp, "  \"tiles\": [\n");
+    for (std::size_t i{0}; i < tiles.size(); ++i) {
+        const auto& tile{tiles[i]};
+        double tile_seconds{0};
+        for (auto y{tile.y_begin}; y < tile.y_end; ++y) {
+            for (auto x{tile.x_begin}; x < tile.x_end; ++x) {
+                tile_seconds += stats.pixel_seconds[y * stats.image_width + x];
+            }
+        }
+        std::fprintf(fp,
+                     "    {\"x\": %zu, \"y\": %zu, \"width\": %zu, "
+                     "\"height\": %zu, \"seconds\": %.6f}%s\n",
+                     tile.x_begin,
+                     tile.y_begin,
+                     tile.x_end - tile.x_begin,
+                     tile.y_end - tile.y_begin,
+                     tile_seconds,
+                     i + 1 < tiles.size() ? "," : "");
+    }
+    std::fprintf(fp, "  ]\n}\n");
+
+    if (std::fclose(fp) != 0) {
+        std::cerr << "Failed to write statistics file '" << filename
+                  << "'.\n";
+        return false;
+    }
+    return true;
+}
+
+bool write_heatmap(const char* filename,
+                   const RenderStats& stats,
+                   std::size_t band_height,
+                   bool half_float) {
+    // The scale is set by the 99th percentile rather than the maximum, which
+    // a single pixel interrupted by the scheduler would decide.
+    auto sorted_seconds{stats.pixel_seconds};
+    auto percentile{sorted_seconds.begin() + sorted_seconds.size() * 99 / 100};
+    std::nth_element(sorted_seconds.begin(), percentile, sorted_seconds.end());
+    auto max_seconds{std::max(*percentile, 1e-9f)};
+
+    Film film{stats.image_width, stats.image_height};
+    for (std::size_t i{0}; i < film.pixels.size(); ++i) {
+        // Red rises over the first third of the range, then green, then
+        // blue.
+        auto t{3 * stats.pixel_seconds[i] / max_seconds};
+        auto& pixel{film.pixels[i]};
+        pixel.r = std::clamp(t, 0.0f, 1.0f);
+        pixel.g = std::clamp(t - 1, 0.0f, 1.0f);
+        pixel.b = std::clamp(t - 2, 0.0f, 1.0f);
+        pixel.num_samples = 1;
+    }
+    return write_image(filename,
+                       film,
+                       ToneMapper{ToneMapSettings{}},
+                       band_height,
+                       half_float);
+}
+
+}
@@ -0,0 +1,166 @@
+#ifndef RENDER_STATS_H
+#define RENDER_STATS_H
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace ray_tracing {
+
+// Counters of what the renderer does, for finding out where the time goes.
+// They are only collected in builds with USE_STATS; otherwise the functions
+// recording them are empty and inline, so the hot paths compile exactly as
+// if they were not there.
+//
+// Every thread counts into its own block of counters, and the blocks are
+// only summed once rendering is done, so counting takes no locks and no
+// atomic operations and threads never share a cache line.
+enum class Stat {
+    camera_rays,
+    scatter_rays,
+    shadow_rays,
+    // Ray-primitive tests, counting each ray of a packet separately.
+    intersection_tests,
+    // BVH nodes whose bounds were tested, once per packet for packets.
+    bvh_nodes_visited,
+    roulette_terminations
+};
+
+constexpr std::size_t num_stats{6};
+
+// Path lengths from this many bounces up share the last histogram bin.
+constexpr std::size_t max_path_length{64};
+
+void add_stat(Stat stat, std::uint64_t amount = 1);
+
+// Records that a path ended after `num_bounces` scattering events.
+void add_path_length(std::size_t num_bounces);
+
+// Adds the time between its construction and destruction to the cost of a
+// pixel in the heatmap.
+class PixelTimer {
+public:
+    explicit PixelTimer(std::size_t pixel_index);
+
+    ~PixelTimer();
+
+    PixelTimer(const PixelTimer&) = delete;
+
+    PixelTimer& operator=(const PixelTimer&) = delete;
+
+#ifdef USE_STATS
+private:
+    std::size_t pixel_index;
+
+    std::chrono::steady_clock::time_point start;
+#endif
+};
+
+#ifdef USE_STATS
+
+// The counters of all threads, summed, and the time spent on each pixel.
+struct RenderStats {
+    std::uint64_t counts[num_stats];
+
+    std::uint64_t path_lengths[max_path_length + 1];
+
+    // The rays each thread traced, in the order the threads first counted.
+    std::vector<std::uint64_t> rays_per_thread;
+
+    std::size_t image_width;
+
+    std::size_t image_height;
+
+    // In seconds, row by row from the top.
+    std::vector<float> pixel_seconds;
+
+    std::uint64_t count(Stat stat) const;
+
+    std::uint64_t num_rays() const;
+};
+
+struct alignas(64) ThreadStats {
+    std::uint64_t counts[num_stats];
+
+    std::uint64_t path_lengths[max_path_length + 1];
+};
+
+// Hands out the calling thread's block of counters the first time it
+// counts anything. Only this takes a lock.
+ThreadStats& register_thread_stats();
+
+inline ThreadStats& thread_stats() {
+    thread_local auto& stats{register_thread_stats()};
+    return stats;
+}
+
+// Zeroes all counters and sizes the heatmap for the image. Must not be
+// called while rendering.
+void reset_stats(std::size_t image_width, std::size_t image_height);
+
+// Sums the counters of all threads. Must not be called while rendering.
+RenderStats collect_stats();
+
+#ifdef USE_MPI
+// Sums `stats` over the ranks of `MPI_COMM_WORLD` into rank 0, which must
+// all call this. Every rank renders different pixels, so the heatmap of
+// rank 0 ends up covering the whole image.
+void reduce_stats(RenderStats& stats);
+#endif
+
+// Writes the totals, the path length histogram, the rays of each thread and
+// the time spent on each tile of `tile_size` pixels as JSON. `seconds` is
+// the wall time of the render. Prints a message and returns false on
+// failure.
+bool write_stats(const char* filename,
+                 const RenderStats& stats,
+                 std::size_t tile_size,
+                 double seconds);
+
+// Writes the time spent on each pixel as an image in any of the output
+// formats, colored from black through red and yellow to white for the most
+// expensive percent of the pixels.
+bool write_heatmap(const char* filename,
+                   const RenderStats& stats,
+                   std::size_t band_height,
+                   bool half_float);
+
+// The heatmap `PixelTimer` adds to, in seconds.
+extern std::vector<float> heatmap_seconds;
+
+inline void add_stat(Stat stat, std::uint64_t amount) {
+    thread_stats().counts[static_cast<std::size_t>(stat)] += amount;
+}
+
+inline void add_path_length(std::size_t num_bounces) {
+    ++thread_stats().path_lengths[std::min(num_bounces, max_path_length)];
+}
+
+inline PixelTimer::PixelTimer(std::size_t pixel_index)
+    : pixel_index{pixel_index}, start{std::chrono::steady_clock::now()} {}
+
+inline PixelTimer::~PixelTimer() {
+    std::chrono::duration<float> elapsed{std::chrono::steady_clock::now()
+                                         - start};
+    if (pixel_index < heatmap_seconds.size()) {
+        heatmap_seconds[pixel_index] += elapsed.count();
+    }
+}
+
+#else
+
+inline void add_stat(Stat, std::uint64_t) {}
+
+inline void add_path_length(std::size_t) {}
+
+inline PixelTimer::PixelTimer(std::size_t) {}
+
+inline PixelTimer::~PixelTimer() {}
+
+#endif
+
+}
+
+#endif
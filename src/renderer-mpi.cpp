@@ -0,0 +1,337 @@
+#include "renderer.h"
+
+#include <mpi.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <mutex>
+#include <thread>
+
+#include <cstdlib>
+#include <cstring>
+
+namespace ray_tracing {
+
+// A worker asks rank 0 for work with a message holding the number of tiles
+// it wants next, followed by the tiles it has just finished. Rank 0 answers
+// with the tiles to render, or with an empty message when there are none
+// left. Each tile travels as its index followed by its pixels, so that
+// partly rendered tiles, from a checkpoint or from adaptive sampling, carry
+// on where they left off.
+static constexpr int request_tag{1};
+
+static constexpr int assignment_tag{2};
+
+// How long rank 0 sleeps when no request is waiting. Short enough to add
+// nothing noticeable to the time a worker waits for its next tiles, long
+// enough that the polling does not take a core from the rendering threads.
+static constexpr std::chrono::microseconds poll_interval{200};
+
+static void append_tile(std::vector<char>& buffer,
+                        std::uint64_t tile_index,
+                        const Tile& tile,
+                        const Film& film) {
+    auto row_size{(tile.x_end - tile.x_begin) * sizeof(Film::Pixel)};
+    auto offset{buffer.size()};
+    buffer.resize(offset + sizeof(tile_index)
+                  + (tile.y_end - tile.y_begin) * row_size);
+    std::memcpy(buffer.data() + offset, &tile_index, sizeof(tile_index));
+    offset += sizeof(tile_index);
+    for (auto y{tile.y_begin}; y < tile.y_end; ++y) {
+        std::memcpy(buffer.data() + offset,
+                    &film.at(tile.x_begin, y),
+                    row_size);
+        offset += row_size;
+    }
+}
+
+// Ends the whole run when a message from another rank is not what the
+// protocol says, rather than reading past it or outside the film. Ranks
+// started with different image or tile sizes disagree on the tiles.
+[[noreturn]] static void abort_on_malformed_message() {
+    std::cerr << "Malformed message from another process; all processes "
+                 "must be given the same options.\n";
+    MPI_Abort(MPI_COMM_WORLD, 1);
+    std::abort();
+}
+
+// Copies the tile that `append_tile` wrote at `offset` into `film`, moves
+// `offset` past it and returns the tile's index.
+static std::uint64_t read_tile(const std::vector<char>& buffer,
+                               std::size_t& offset,
+                               const std::vector<Tile>& tiles,
+                               Film& film) {
+    std::uint64_t tile_index;
+    if (buffer.size() - offset < sizeof(tile_index)) {
+        abort_on_malformed_message();
+    }
+    std::memcpy(&tile_index, buffer.data() + offset, sizeof(tile_index));
+    offset += sizeof(tile_index);
+    if (tile_index >= tiles.size()) {
+        abort_on_malformed_message();
+    }
+    const auto& tile{tiles[tile_index]};
+    auto row_size{(tile.x_end - tile.x_begin) * sizeof(Film::Pixel)};
+    if (buffer.size() - offset < (tile.y_end - tile.y_begin) * row_size) {
+        abort_on_malformed_message();
+    }
+    for (auto y{tile.y_begin}; y < tile.y_end; ++y) {
+        std::memcpy(&film.at(tile.x_begin, y),
+                    buffer.data() + offset,
+                    row_size);
+        offset += row_size;
+    }
+    return tile_index;
+}
+
+static void copy_tile(const Tile& tile,
+                      const Film& source,
+                      Film& destination) {
+    for (auto y{tile.y_begin}; y < tile.y_end; ++y) {
+        std::copy(&source.at(tile.x_begin, y),
+                  &source.at(tile.x_begin, y) + (tile.x_end - tile.x_begin),
+                  &destination.at(tile.x_begin, y));
+    }
+}
+
+static void receive(int source, int tag, std::vector<char>& buffer) {
+    MPI_Status status;
+    MPI_Probe(source, tag, MPI_COMM_WORLD, &status);
+    int size;
+    MPI_Get_count(&status, MPI_BYTE, &size);
+    buffer.resize(size);
+    MPI_Recv(buffer.data(),
+             size,
+             MPI_BYTE,
+             source,
+             tag,
+             MPI_COMM_WORLD,
+             MPI_STATUS_IGNORE);
+}
+
+bool Renderer::render_distributed(ThreadPool& pool,
+                                  Film& film,
+                                  const ProgressCallback& progress,
+                                  const PassCallback& on_pass,
+                                  const TileCallback& on_tile) const {
+    int world_rank;
+    MPI_Comm_rank(MPI_COMM_WORLD, &world_rank);
+
+    auto tiles{make_tiles(settings.image_width,
+                          0,
+                          settings.image_height,
+                          settings.tile_size)};
+    int completed{1};
+    if (world_rank == 0) {
+        completed = serve_tiles(pool,
+                                tiles,
+                                film,
+                                progress,
+                                on_pass,
+                                on_tile);
+    } else {
+        request_tiles(pool, tiles, film);
+    }
+    MPI_Bcast(&completed, 1, MPI_INT, 0, MPI_COMM_WORLD);
+    return completed != 0;
+}
+
+void Renderer::finish_tile(const Tile& tile, Film& film) const {
+    while (needs_samples(tile, film)) {
+        render_tile(tile, film);
+    }
+}
+
+bool Renderer::serve_tiles(ThreadPool& pool,
+                           const std::vector<Tile>& tiles,
+                           Film& film,
+                           const ProgressCallback& progress,
+                           const PassCallback& on_pass,
+                           const TileCallback& on_tile) const {
+    int world_size;
+    MPI_Comm_size(MPI_COMM_WORLD, &world_size);
+
+    std::vector<std::size_t> queue;
+    for (decltype(tiles.size()) i{0}; i < tiles.size(); ++i) {
+        if (needs_samples(tiles[i], film)) {
+            queue.emplace_back(i);
+        }
+    }
+
+    std::vector<double> costs(tiles.size());
+    pool.run(queue.size(), [&](auto task_index, auto) {
+        costs[queue[task_index]] = estimate_cost(tiles[queue[task_index]]);
+    });
+    std::stable_sort(queue.begin(), queue.end(), [&](auto lhs, auto rhs) {
+        return costs[lhs] > costs[rhs];
+    });
+
+    std::vector<std::uint64_t> num_pending(tiles.size());
+    std::uint64_t num_total_pending{0};
+    for (auto tile_index : queue) {
+        num_pending[tile_index]
+                = num_pending_samples(tiles[tile_index], film);
+        num_total_pending += num_pending[tile_index];
+    }
+
+    std::atomic<std::size_t> num_claimed{0};
+    std::atomic<bool> stopped{false};
+    auto claim_tile{[&](std::size_t& tile_index) {
+        if (stopped) {
+            return false;
+        }
+        auto task_index{num_claimed++};
+        if (task_index >= queue.size()) {
+            return false;
+        }
+        tile_index = queue[task_index];
+        return true;
+    }};
+
+    // Only ever written with the mutex held, so that `on_pass` sees whole
+    // tiles.
+    std::mutex film_mutex;
+    std::size_t num_finished{0};
+    std::uint64_t num_completed{0};
+    auto on_tile_finished{[&](std::size_t tile_index) {
+        ++num_finished;
+        num_completed += num_pending[tile_index];
+        if (progress) {
+            progress(num_completed, num_total_pending);
+        }
+        if (on_pass && !stopped && !on_pass()) {
+            stopped = true;
+        }
+    }};
+
+    std::thread server;
+    if (world_size > 1) {
+        server = std::thread{[&] {
+            std::vector<char> request;
+            std::vector<char> assignment;
+            std::vector<std::size_t> finished;
+            auto num_workers{world_size - 1};
+            while (num_workers > 0) {
+                int has_request;
+                MPI_Status status;
+                MPI_Iprobe(MPI_ANY_SOURCE,
+                           request_tag,
+                           MPI_COMM_WORLD,
+                           &has_request,
+                           &status);
+                if (!has_request) {
+                    std::this_thread::sleep_for(poll_interval);
+                    continue;
+                }
+                receive(status.MPI_SOURCE, request_tag, request);
+
+                std::uint64_t num_wanted;
+                if (request.size() < sizeof(num_wanted)) {
+                    abort_on_malformed_message();
+                }
+                std::memcpy(&num_wanted, request.data(), sizeof(num_wanted));
+                auto offset{sizeof(num_wanted)};
+                finished.clear();
+                if (offset < request.size()) {
+                    std::lock_guard<std::mutex> lock{film_mutex};
+                    while (offset < request.size()) {
+                        finished.emplace_back(
+                                read_tile(request, offset, tiles, film));
+                        on_tile_finished(finished.back());
+                    }
+                }
+                if (on_tile) {
+                    for (auto tile_index : finished) {
+                        on_tile(tiles[tile_index]);
+                    }
+                }
+
+                // Nothing else writes to an unclaimed tile, so it can be read
+                // without the mutex.
+                assignment.clear();
+                std::size_t tile_index;
+                for (decltype(num_wanted) i{0};
+                     i < num_wanted && claim_tile(tile_index);
+                     ++i) {
+                    append_tile(assignment,
+                                tile_index,
+                                tiles[tile_index],
+                                film);
+                }
+                if (assignment.empty()) {
+                    --num_workers;
+                }
+                MPI_Send(assignment.data(),
+                         static_cast<int>(assignment.size()),
+                         MPI_BYTE,
+                         status.MPI_SOURCE,
+                         assignment_tag,
+                         MPI_COMM_WORLD);
+            }
+        }};
+    }
+
+    // Rank 0's own threads render into a copy of the film, so that they do
+    // not need the mutex while rendering.
+    Film scratch{film};
+    pool.run(queue.size(), [&](auto, auto) {
+        std::size_t tile_index;
+        if (!claim_tile(tile_index)) {
+            return;
+        }
+        const auto& tile{tiles[tile_index]};
+        finish_tile(tile, scratch);
+        {
+            std::lock_guard<std::mutex> lock{film_mutex};
+            copy_tile(tile, scratch, film);
+            on_tile_finished(tile_index);
+        }
+        if (on_tile) {
+            on_tile(tile);
+        }
+    });
+
+    if (server.joinable()) {
+        server.join();
+    }
+    return num_finished == queue.size();
+}
+
+void Renderer::request_tiles(ThreadPool& pool,
+                             const std::vector<Tile>& tiles,
+                             Film& film) const {
+    std::vector<char> request;
+    std::vector<char> assignment;
+    std::vector<std::size_t> assigned;
+    while (true) {
+        std::uint64_t num_wanted{pool.size()};
+        request.resize(sizeof(num_wanted));
+        std::memcpy(request.data(), &num_wanted, sizeof(num_wanted));
+        for (auto tile_index : assigned) {
+            append_tile(request, tile_index, tiles[tile_index], film);
+        }
+        MPI_Send(request.data(),
+                 static_cast<int>(request.size()),
+                 MPI_BYTE,
+                 0,
+                 request_tag,
+                 MPI_COMM_WORLD);
+
+        receive(0, assignment_tag, assignment);
+        if (assignment.empty()) {
+            return;
+        }
+        assigned.clear();
+        std::size_t offset{0};
+        while (offset < assignment.size()) {
+            assigned.emplace_back(read_tile(assignment, offset, tiles, film));
+        }
+        pool.run(assigned.size(), [&](auto task_index, auto) {
+            finish_tile(tiles[assigned[task_index]], film);
+        });
+    }
+}
+
+}
@@ -0,0 +1,272 @@
+#include "renderer.h"
+
+#include "ray-packet.h"
+#include "ray.h"
+#include "render-stats.h"
+#include "utils.h"
+#include "vector3.h"
+
+#include <algorithm>
+#include <chrono>
+#include <mutex>
+#include <numeric>
+#include <vector>
+
+namespace ray_tracing {
+
+Renderer::Renderer(const Camera& camera,
+                   const Hittable& world,
+                   const std::vector<Material>& materials,
+                   const LightSampler& lights,
+                   const RenderSettings& settings)
+    : camera{camera},
+      world{world},
+      settings{settings},
+      sampler{settings.sampler,
+              settings.image_width,
+              settings.samples_per_pixel,
+              settings.seed},
+      integrator{world, materials, lights, settings.max_depth} {}
+
+bool Renderer::render(ThreadPool& pool,
+                      std::size_t row_begin,
+                      std::size_t row_end,
+                      Film& film,
+                      const ProgressCallback& progress,
+                      const PassCallback& on_pass,
+                      const TileCallback& on_tile) const {
+    auto tiles{make_tiles(settings.image_width,
+                          row_begin,
+                          row_end,
+                          settings.tile_size)};
+
+    std::vector<double> costs(tiles.size());
+    pool.run(tiles.size(), [&](auto tile_index, auto) {
+        costs[tile_index] = estimate_cost(tiles[tile_index]);
+    });
+
+    std::vector<std::size_t> active_tiles(tiles.size());
+    std::iota(active_tiles.begin(), active_tiles.end(), 0);
+
+    std::uint64_t num_pending{0};
+    for (const auto& tile : tiles) {
+        num_pending += num_pending_samples(tile, film);
+    }
+
+    std::mutex progress_mutex;
+    std::uint64_t num_completed{0};
+    while (!active_tiles.empty()) {
+        std::stable_sort(active_tiles.begin(),
+                         active_tiles.end(),
+                         [&](auto lhs, auto rhs) {
+                             return costs[lhs] > costs[rhs];
+                         });
+
+        pool.run(active_tiles.size(), [&](auto task_index, auto) {
+            auto tile_index{active_tiles[task_index]};
+            auto start{std::chrono::steady_clock::now()};
+            auto num_tile_completed{render_tile(tiles[tile_index], film)};
+            std::chrono::duration<double> elapsed{
+                    std::chrono::steady_clock::now() - start};
+            costs[tile_index] = elapsed.count();
+            if (on_tile && !needs_samples(tiles[tile_index], film)) {
+                on_tile(tiles[tile_index]);
+            }
+            if (progress) {
+                std::lock_guard<std::mutex> lock{progress_mutex};
+                num_completed += num_tile_completed;
+                progress(num_completed, num_pending);
+            }
+        });
+
+        active_tiles.erase(std::remove_if(active_tiles.begin(),
+                                          active_tiles.end(),
+                                          [&](auto tile_index) {
+                                              return !needs_samples(
+                                                      tiles[tile_index],
+                                                      film);
+                                          }),
+                           active_tiles.end());
+
+        if (on_pass && !on_pass() && !active_tiles.empty()) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void Renderer::render_features(ThreadPool& pool,
+                               FeatureBuffer& features) const {
+    auto num_samples{std::min(feature_samples, settings.samples_per_pixel)};
+    pool.run(settings.image_height, [&](auto y, auto) {
+        for (decltype(settings.image_width) x{0}; x < settings.image_width;
+             ++x) {
+            auto albedo{Radiance::black};
+            auto normal{Vector3::zero};
+            float depth{0};
+            std::size_t num_hits{0};
+            auto& pixel{features.at(x, y)};
+            for (decltype(num_samples) i{0}; i < num_samples; ++i) {
+                auto stream{sampler.start(x, y, i)};
+                auto ray{generate_ray(x, y, stream)};
+                FeatureBuffer::Pixel sample;
+                integrator.trace_features(ray, stream, sample);
+                if (i == 0) {
+                    pixel.material_id = sample.material_id;
+                    pixel.object_id = sample.object_id;
+                }
+                albedo += sample.albedo;
+                normal += sample.normal;
+                if (sample.depth > 0) {
+                    depth += sample.depth;
+                    ++num_hits;
+                }
+            }
+
+            pixel.albedo = albedo * (1.0f / num_samples);
+            pixel.normal = is_vector_near_zero(normal) ? Vector3::zero
+                                                       : normal.normalized();
+            pixel.depth = num_hits ? depth / num_hits : 0;
+        }
+    });
+}
+
+bool Renderer::needs_samples(const Film::Pixel& pixel) const {
+    if (pixel.num_samples >= settings.samples_per_pixel) {
+        return false;
+    }
+    return settings.adaptive_threshold <= 0
+           || pixel.num_samples < min_adaptive_samples
+           || pixel.relative_error() > settings.adaptive_threshold;
+}
+
+bool Renderer::needs_samples(const Tile& tile, const Film& film) const {
+    for (auto y{tile.y_begin}; y < tile.y_end; ++y) {
+        for (auto x{tile.x_begin}; x < tile.x_end; ++x) {
+            if (needs_samples(film.at(x, y))) {
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+std::uint64_t Renderer::num_pending_samples(const Tile& tile,
+                                            const Film& film) const {
+    std::uint64_t num_pending{0};
+    for (auto y{tile.y_begin}; y < tile.y_end; ++y) {
+        for (auto x{tile.x_begin}; x < tile.x_end; ++x) {
+            const auto& pixel{film.at(x, y)};
+            if (needs_samples(pixel)) {
+                num_pending += settings.samples_per_pixel - pixel.num_samples;
+            }
+        }
+    }
+    return num_pending;
+}
+
+double Renderer::estimate_cost(const Tile& tile) const {
+    constexpr std::size_t probes_per_axis{4};
+
+    auto start{std::chrono::steady_clock::now()};
+    for (auto i{decltype(probes_per_axis){0}}; i < probes_per_axis; ++i) {
+        for (auto j{decltype(probes_per_axis){0}}; j < probes_per_axis; ++j) {
+            auto x{tile.x_begin + (tile.x_end - tile.x_begin) * j
+                                          / probes_per_axis};
+            auto y{tile.y_begin + (tile.y_end - tile.y_begin) * i
+                                          / probes_per_axis};
+            sample(x, y, settings.samples_per_pixel);
+        }
+    }
+    std::chrono::duration<double> elapsed{std::chrono::steady_clock::now()
+                                          - start};
+    return elapsed.count();
+}
+
+std::uint64_t Renderer::render_tile(const Tile& tile, Film& film) const {
+    std::uint64_t num_completed{0};
+    for (auto y{tile.y_begin}; y < tile.y_end; ++y) {
+        for (auto x{tile.x_begin}; x < tile.x_end; ++x) {
+            auto& pixel{film.at(x, y)};
+            if (!needs_samples(pixel)) {
+                continue;
+            }
+
+            auto pixel_index{y * settings.image_width + x};
+            PixelTimer timer{pixel_index};
+            auto first_sample{static_cast<std::size_t>(pixel.num_samples)};
+            auto last_sample{std::min(first_sample + batch_size,
+                                      settings.samples_per_pixel)};
+            if (settings.packet_tracing) {
+                for (auto i{first_sample}; i < last_sample;
+                     i += RayPacket::max_size) {
+                    sample_packet(x,
+                                  y,
+                                  i,
+                                  std::min(RayPacket::max_size,
+                                           last_sample - i),
+                                  pixel);
+                }
+            } else {
+                for (auto i{first_sample}; i < last_sample; ++i) {
+                    pixel.add(sample(x, y, i));
+                }
+            }
+
+            num_completed += last_sample - first_sample;
+            if (!needs_samples(pixel)) {
+                num_completed += settings.samples_per_pixel - last_sample;
+            }
+        }
+    }
+    return num_completed;
+}
+
+Ray Renderer::generate_ray(std::size_t x,
+                           std::size_t y,
+                           SampleStream& stream) const {
+    auto row{settings.image_height - y - 1};
+    auto film_point{stream.next_2d()};
+    auto u{(static_cast<Vector3::ValueType>(x) + film_point.u)
+           / (settings.image_width - 1)};
+    auto v{(static_cast<Vector3::ValueType>(row) + film_point.v)
+           / (settings.image_height - 1)};
+    auto lens_point{stream.next_2d()};
+    return camera.generate_ray(u, v, lens_point);
+}
+
+Radiance Renderer::sample(std::size_t x,
+                          std::size_t y,
+                          std::uint64_t sample_index) const {
+    auto stream{sampler.start(x, y, sample_index)};
+    auto ray{generate_ray(x, y, stream)};
+    return integrator.trace(ray, stream);
+}
+
+void Renderer::sample_packet(std::size_t x,
+                             std::size_t y,
+                             std::size_t first_sample,
+                             std::size_t count,
+                             Film::Pixel& pixel) const {
+    SampleStream streams[RayPacket::max_size];
+    RayPacket packet;
+    packet.size = count;
+    for (auto i{decltype(count){0}}; i < count; ++i) {
+        streams[i] = sampler.start(x, y, first_sample + i);
+        packet.rays[i] = generate_ray(x, y, streams[i]);
+    }
+
+    Hittable::HitInfo hit_infos[RayPacket::max_size];
+    bool hits[RayPacket::max_size];
+    add_stat(Stat::camera_rays, count);
+    world.hit_packet(packet, hit_infos, hits);
+
+    for (auto i{decltype(count){0}}; i < count; ++i) {
+        pixel.add(integrator.trace(packet.rays[i],
+                                   hits[i],
+                                   hit_infos[i],
+                                   streams[i]));
+    }
+}
+
+}
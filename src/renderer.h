@@ -0,0 +1,171 @@
+#ifndef RENDERER_H
+#define RENDERER_H
+
+#include "camera.h"
+#include "feature-buffer.h"
+#include "film.h"
+#include "hittable.h"
+#include "light-sampler.h"
+#include "material.h"
+#include "path-integrator.h"
+#include "radiance.h"
+#include "sampler.h"
+#include "thread-pool.h"
+#include "tile.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+namespace ray_tracing {
+
+struct RenderSettings {
+    std::size_t image_width;
+
+    std::size_t image_height;
+
+    std::size_t samples_per_pixel;
+
+    std::size_t max_depth;
+
+    std::size_t tile_size;
+
+    bool packet_tracing;
+
+    float adaptive_threshold;
+
+    SamplerType sampler{SamplerType::sobol};
+
+    // Renders with different seeds draw different numbers.
+    std::uint64_t seed{0};
+};
+
+// Renders the image tile by tile on a thread pool, in passes that each add
+// a batch of samples to every pixel still needing them. Tiles are ordered by
+// cost, estimated by a one-sample prepass and then by the time each tile
+// took in the previous pass, so the most expensive ones start first and the
+// cheap ones fill in the gaps at the end.
+//
+// With a positive `adaptive_threshold`, a pixel stops receiving samples once
+// the relative standard error of its mean falls below the threshold, and
+// `samples_per_pixel` only caps the number of samples.
+class Renderer {
+public:
+    using ProgressCallback = std::function<void(std::uint64_t completed,
+                                                std::uint64_t total)>;
+
+    // Called between passes, when no thread is writing to the film. Returning
+    // false stops the render early.
+    using PassCallback = std::function<bool()>;
+
+    // Called once a tile has all its samples, from the rendering threads and
+    // possibly several at once. Nothing writes to the tile's pixels after.
+    using TileCallback = std::function<void(const Tile& tile)>;
+
+    static constexpr std::size_t batch_size{16};
+
+    static constexpr std::size_t min_adaptive_samples{32};
+
+    // Of every pixel, whose features `render_features` averages.
+    static constexpr std::size_t feature_samples{8};
+
+    Renderer(const Camera& camera,
+             const Hittable& world,
+             const std::vector<Material>& materials,
+             const LightSampler& lights,
+             const RenderSettings& settings);
+
+    // Renders the rows `[row_begin, row_end)`, counted from the top, into
+    // `film`, continuing from whatever samples it already holds. Returns
+    // false if `on_pass` stopped the render before it finished.
+    bool render(ThreadPool& pool,
+                std::size_t row_begin,
+                std::size_t row_end,
+                Film& film,
+                const ProgressCallback& progress = nullptr,
+                const PassCallback& on_pass = nullptr,
+                const TileCallback& on_tile = nullptr) const;
+
+#ifdef USE_MPI
+    // Renders the whole image across the ranks of `MPI_COMM_WORLD`, which
+    // must all call this. Rank 0 hands out tiles, most expensive first, to
+    // its own threads and to the other ranks as they ask for more, and copies
+    // each tile into its `film` as soon as it is finished; the films of the
+    // other ranks are only scratch space. `progress` and `on_pass` are only
+    // called on rank 0, `on_pass` after every finished tile while nothing
+    // writes to the film, and `on_tile` once a tile is copied in. Returns
+    // false on every rank if `on_pass` stopped the render before it
+    // finished.
+    bool render_distributed(ThreadPool& pool,
+                            Film& film,
+                            const ProgressCallback& progress = nullptr,
+                            const PassCallback& on_pass = nullptr,
+                            const TileCallback& on_tile = nullptr) const;
+#endif
+
+    // Averages the features of the first `feature_samples` samples of every
+    // pixel into `features`, along the same camera rays as those samples.
+    void render_features(ThreadPool& pool, FeatureBuffer& features) const;
+
+private:
+    bool needs_samples(const Film::Pixel& pixel) const;
+
+    bool needs_samples(const Tile& tile, const Film& film) const;
+
+    // The number of samples the pixels of `tile` may still take.
+    std::uint64_t num_pending_samples(const Tile& tile, const Film& film) const;
+
+    double estimate_cost(const Tile& tile) const;
+
+    // Adds one batch of samples to the pixels of `tile` that need them and
+    // returns the number of samples that no longer have to be taken, which
+    // includes the ones skipped by pixels that converged.
+    std::uint64_t render_tile(const Tile& tile, Film& film) const;
+
+#ifdef USE_MPI
+    // Renders batches into `tile` until none of its pixels need samples.
+    void finish_tile(const Tile& tile, Film& film) const;
+
+    // The rank 0 side of `render_distributed`.
+    bool serve_tiles(ThreadPool& pool,
+                     const std::vector<Tile>& tiles,
+                     Film& film,
+                     const ProgressCallback& progress,
+                     const PassCallback& on_pass,
+                     const TileCallback& on_tile) const;
+
+    // The side of `render_distributed` of every other rank.
+    void request_tiles(ThreadPool& pool,
+                       const std::vector<Tile>& tiles,
+                       Film& film) const;
+#endif
+
+    Ray generate_ray(std::size_t x, std::size_t y, SampleStream& stream) const;
+
+    Radiance sample(std::size_t x,
+                    std::size_t y,
+                    std::uint64_t sample_index) const;
+
+    // Traces the camera rays of samples `[first_sample, first_sample +
+    // count)` of a pixel as one packet and adds their colors to `pixel`.
+    void sample_packet(std::size_t x,
+                       std::size_t y,
+                       std::size_t first_sample,
+                       std::size_t count,
+                       Film::Pixel& pixel) const;
+
+    const Camera& camera;
+
+    const Hittable& world;
+
+    RenderSettings settings;
+
+    Sampler sampler;
+
+    PathIntegrator integrator;
+};
+
+}
+
+#endif
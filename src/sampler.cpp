@@ -0,0 +1,215 @@
+#include "sampler.h"
+
+#include "blue-noise.h"
+#include "utils.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace ray_tracing {
+
+// Chris Wellons' lowbias32 integer hash.
+static std::uint32_t hash(std::uint32_t value) {
+    value ^= value >> 16;
+    value *= 0x7feb352du;
+    value ^= value >> 15;
+    value *= 0x846ca68bu;
+    value ^= value >> 16;
+    return value;
+}
+
+static std::uint32_t hash(std::uint32_t seed, std::uint32_t value) {
+    return hash(seed ^ (value + 0x9e3779b9u + (seed << 6) + (seed >> 2)));
+}
+
+static double to_unit(std::uint32_t bits) {
+    return bits * 0x1p-32;
+}
+
+static std::uint32_t reverse_bits(std::uint32_t value) {
+    value = __builtin_bswap32(value);
+    value = ((value & 0x0f0f0f0fu) << 4) | ((value & 0xf0f0f0f0u) >> 4);
+    value = ((value & 0x33333333u) << 2) | ((value & 0xccccccccu) >> 2);
+    value = ((value & 0x55555555u) << 1) | ((value & 0xaaaaaaaau) >> 1);
+    return value;
+}
+
+// Burley's hash-based Owen scrambling, on the reversed bits of a binary
+// fraction: every digit is flipped or not depending on the digits before
+// it, which keeps every power-of-two prefix of a net a net. Working on
+// reversed bits lets the bits depend on those below them, as carries do.
+static std::uint32_t scramble_reversed(std::uint32_t value,
+                                       std::uint32_t seed) {
+    value ^= value * 0x3d20adeau;
+    value += seed;
+    value *= (seed >> 16) | 1;
+    value ^= value * 0x05526c56u;
+    value ^= value * 0x53a22864u;
+    return value;
+}
+
+// The reversed bits of the second dimension of the Sobol sequence; the
+// first is the van der Corput sequence, whose reversed bits are the index.
+// Its generator matrix is Pascal's triangle modulo 2, so by Lucas' theorem
+// each bit of the result is the parity of the index bits whose positions
+// have all of its position's bits set, summed one bit of the position at a
+// time.
+static std::uint32_t sobol_second_reversed(std::uint32_t index) {
+    index ^= (index >> 1) & 0x55555555u;
+    index ^= (index >> 2) & 0x33333333u;
+    index ^= (index >> 4) & 0x0f0f0f0fu;
+    index ^= (index >> 8) & 0x00ff00ffu;
+    index ^= (index >> 16) & 0x0000ffffu;
+    return index;
+}
+
+// Shuffles the sample indices, given with their bits reversed, in a way
+// that keeps the first power-of-two samples a net, so that each pair of
+// dimensions gets its own order.
+static std::uint32_t shuffle(std::uint32_t reversed_index,
+                             std::uint32_t seed) {
+    return reverse_bits(scramble_reversed(reversed_index, seed));
+}
+
+// Kensler's hashed permutation of `[0, length)`, from Correlated
+// Multi-Jittered Sampling.
+static std::uint32_t permute(std::uint32_t index,
+                             std::uint32_t length,
+                             std::uint32_t seed) {
+    auto mask{length - 1};
+    mask |= mask >> 1;
+    mask |= mask >> 2;
+    mask |= mask >> 4;
+    mask |= mask >> 8;
+    mask |= mask >> 16;
+    do {
+        index ^= seed;
+        index *= 0xe170893du;
+        index ^= seed >> 16;
+        index ^= (index & mask) >> 4;
+        index ^= seed >> 8;
+        index *= 0x0929eb3fu;
+        index ^= seed >> 23;
+        index ^= (index & mask) >> 1;
+        index *= 1 | seed >> 27;
+        index *= 0x6935fa69u;
+        index ^= (index & mask) >> 11;
+        index *= 0x74dcb303u;
+        index ^= (index & mask) >> 2;
+        index *= 0x9e501cc3u;
+        index ^= (index & mask) >> 2;
+        index *= 0xc860a3dfu;
+        index &= mask;
+        index ^= index >> 5;
+    } while (index >= length);
+    return (index + seed) % length;
+}
+
+Sampler::Sampler(SamplerType type,
+                 std::size_t image_width,
+                 std::size_t samples_per_pixel,
+                 std::uint64_t seed)
+    : sampler_type{type},
+      image_width{image_width},
+      samples_per_pixel{std::max<std::size_t>(samples_per_pixel, 1)},
+      strata_per_axis{static_cast<std::size_t>(
+              std::sqrt(static_cast<double>(this->samples_per_pixel)))},
+      seed{seed} {
+    if (type == SamplerType::blue_noise) {
+        blue_noise = make_blue_noise(blue_noise_size);
+    }
+}
+
+SamplerType Sampler::type() const {
+    return sampler_type;
+}
+
+SampleStream Sampler::start(std::size_t x,
+                            std::size_t y,
+                            std::uint64_t sample_index) const {
+    return SampleStream{*this, x, y, sample_index};
+}
+
+SampleStream::SampleStream(const Sampler& sampler,
+                           std::size_t x,
+                           std::size_t y,
+                           std::uint64_t sample_index)
+    : sampler{&sampler},
+      x{static_cast<std::uint32_t>(x)},
+      y{static_cast<std::uint32_t>(y)},
+      sample_index{static_cast<std::uint32_t>(sample_index)} {
+    if (sampler.sampler_type == SamplerType::independent) {
+        random_generator = RandomGenerator::for_sample(
+                y * sampler.image_width + x,
+                sample_index,
+                sampler.seed);
+        return;
+    }
+    reversed_index = reverse_bits(this->sample_index);
+    pixel_seed = hash(static_cast<std::uint32_t>(sampler.seed));
+
+    // Blue noise shares one set of points between all pixels.
+    if (sampler.sampler_type != SamplerType::blue_noise) {
+        pixel_seed = hash(pixel_seed,
+                          static_cast<std::uint32_t>(y * sampler.image_width
+                                                     + x));
+    }
+}
+
+double SampleStream::next_1d() {
+    if (sampler->sampler_type == SamplerType::independent) {
+        return random_double(random_generator);
+    }
+    auto seed{hash(pixel_seed, dimension++)};
+    if (sampler->sampler_type == SamplerType::stratified) {
+        auto length{static_cast<std::uint32_t>(sampler->samples_per_pixel)};
+        auto pass{sample_index / length};
+        auto stratum{permute(sample_index % length, length, hash(seed, pass))};
+        auto jitter{to_unit(hash(hash(seed, ~pass), sample_index))};
+        return (stratum + jitter) / length;
+    }
+    auto shuffled{shuffle(reversed_index, seed)};
+    auto value{
+            to_unit(reverse_bits(scramble_reversed(shuffled, hash(seed, 1))))};
+    return shift(value, 0);
+}
+
+SamplePoint SampleStream::next_2d() {
+    if (sampler->sampler_type == SamplerType::independent) {
+        auto u{random_double(random_generator)};
+        auto v{random_double(random_generator)};
+        return SamplePoint{u, v};
+    }
+    auto seed{hash(pixel_seed, dimension++)};
+    if (sampler->sampler_type == SamplerType::stratified) {
+        auto per_axis{static_cast<std::uint32_t>(sampler->strata_per_axis)};
+        auto length{per_axis * per_axis};
+        auto pass{sample_index / length};
+        auto stratum{permute(sample_index % length, length, hash(seed, pass))};
+        auto jitter_seed{hash(seed, ~pass)};
+        auto jitter_u{to_unit(hash(jitter_seed, sample_index))};
+        auto jitter_v{to_unit(hash(hash(jitter_seed), sample_index))};
+        return SamplePoint{(stratum % per_axis + jitter_u) / per_axis,
+                           (stratum / per_axis + jitter_v) / per_axis};
+    }
+    auto shuffled{shuffle(reversed_index, seed)};
+    auto u{to_unit(reverse_bits(scramble_reversed(shuffled, hash(seed, 1))))};
+    auto v{to_unit(reverse_bits(scramble_reversed(
+            sobol_second_reversed(shuffled),
+            hash(seed, 2))))};
+    return SamplePoint{shift(u, 0), shift(v, 1)};
+}
+
+double SampleStream::shift(double value, std::uint32_t axis) const {
+    if (sampler->blue_noise.empty()) {
+        return value;
+    }
+    constexpr auto mask{Sampler::blue_noise_size - 1};
+    auto offset{hash(dimension, axis)};
+    auto row{(y + (offset >> 16)) & mask};
+    auto column{(x + offset) & mask};
+    value += sampler->blue_noise[row * Sampler::blue_noise_size + column];
+    return value < 1 ? value : value - 1;
+}
+
+}
@@ -0,0 +1,131 @@
+#ifndef SAMPLER_H
+#define SAMPLER_H
+
+#include "random-generator.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace ray_tracing {
+
+enum class SamplerType {
+    // Independent uniform numbers, the same ones the sample's generator
+    // would give.
+    independent,
+    // One jittered stratum of each dimension per sample, in a shuffled order
+    // so that the dimensions are not correlated.
+    stratified,
+    // Sobol points with Owen scrambling, a (0, 2)-sequence in every pair of
+    // dimensions, shuffled between pairs and scrambled in every pixel.
+    sobol,
+    // The same Sobol points in every pixel, each pixel's shifted by a
+    // blue-noise mask, so that the errors of neighbouring pixels differ as
+    // much as possible and look like fine grain instead of blotches.
+    blue_noise
+};
+
+// A point in the unit square.
+struct SamplePoint {
+    double u;
+
+    double v;
+};
+
+// The numbers a material scatters with, the same count for every material:
+// a point to warp into the new direction, and one more number, for choosing
+// between reflection and refraction or how far into a ball to perturb the
+// direction.
+struct ScatterSample {
+    SamplePoint direction;
+
+    double choice;
+};
+
+class SampleStream;
+
+// Where the numbers of every sample come from. Each sample of a pixel takes
+// its own stream, whose dimensions are handed out in the order they are
+// used, one or two at a time: the film and lens positions first, then a
+// fixed set per path vertex. With the same number of samples per pixel,
+// the samples of a pixel then cover each dimension, and each pair of
+// dimensions drawn together, more evenly than independent numbers could.
+//
+// A stream depends only on the pixel, the sample index and the type, never
+// on which thread or process takes the sample.
+class Sampler {
+public:
+    // Renders with different seeds draw different numbers.
+    Sampler(SamplerType type,
+            std::size_t image_width,
+            std::size_t samples_per_pixel,
+            std::uint64_t seed = 0);
+
+    SamplerType type() const;
+
+    SampleStream start(std::size_t x,
+                       std::size_t y,
+                       std::uint64_t sample_index) const;
+
+private:
+    friend class SampleStream;
+
+    static constexpr std::size_t blue_noise_size{64};
+
+    SamplerType sampler_type;
+
+    std::size_t image_width;
+
+    std::size_t samples_per_pixel;
+
+    // Of the grid of 2D strata.
+    std::size_t strata_per_axis;
+
+    std::uint64_t seed;
+
+    std::vector<float> blue_noise;
+};
+
+class SampleStream {
+public:
+    // An empty stream, to be replaced by one from `Sampler::start`.
+    SampleStream() = default;
+
+    double next_1d();
+
+    SamplePoint next_2d();
+
+private:
+    friend class Sampler;
+
+    SampleStream(const Sampler& sampler,
+                 std::size_t x,
+                 std::size_t y,
+                 std::uint64_t sample_index);
+
+    // Shifts `value` by the blue-noise mask, read at a different offset
+    // for each dimension and axis.
+    double shift(double value, std::uint32_t axis) const;
+
+    const Sampler* sampler{nullptr};
+
+    std::uint32_t x{0};
+
+    std::uint32_t y{0};
+
+    std::uint32_t sample_index{0};
+
+    // Computed once for the Sobol samplers, which shuffle it in every
+    // dimension.
+    std::uint32_t reversed_index{0};
+
+    std::uint32_t pixel_seed{0};
+
+    std::uint32_t dimension{0};
+
+    RandomGenerator random_generator;
+};
+
+}
+
+#endif
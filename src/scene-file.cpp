@@ -0,0 +1,492 @@
+#include "scene-file.h"
+
+#include "animation.h"
+#include "mapped-file.h"
+#include "mesh-loader.h"
+#include "triangle-mesh.h"
+
+#include <charconv>
+#include <filesystem>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <unordered_map>
+#include <vector>
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+
+namespace ray_tracing {
+
+static_assert(std::is_trivially_copyable_v<Scene::MaterialRecord>);
+
+struct SceneHeader {
+    char magic[8];
+
+    std::uint32_t version;
+
+    std::uint32_t num_materials;
+
+    std::uint64_t image_width;
+
+    std::uint64_t image_height;
+
+    std::uint64_t samples_per_pixel;
+
+    std::uint64_t max_depth;
+
+    float lookfrom[3];
+
+    float lookat[3];
+
+    float viewup[3];
+
+    float vertical_fov;
+
+    float focus_distance;
+
+    float aperture;
+};
+
+static constexpr char scene_magic[8]{'R', 'T', 'S', 'C', 'E', 'N', 'E', 0};
+
+static constexpr std::uint32_t scene_version{3};
+
+// The words of one line of a text scene, read one at a time.
+class LineReader {
+public:
+    LineReader(const char* filename,
+               std::size_t line_number,
+               std::string_view line)
+        : filename{filename}, line_number{line_number}, rest{line} {}
+
+    bool at_end() {
+        skip_spaces();
+        return rest.empty();
+    }
+
+    bool read(std::string_view& word) {
+        skip_spaces();
+        auto end{rest.find_first_of(" \t\r")};
+        word = rest.substr(0, end);
+        rest.remove_prefix(word.size());
+        if (word.empty()) {
+            return error("missing value");
+        }
+        return true;
+    }
+
+    template <typename T>
+    bool read(T& value) {
+        std::string_view word;
+        if (!read(word)) {
+            return false;
+        }
+        auto [end, status]{
+                std::from_chars(word.data(), word.data() + word.size(), value)};
+        if (status != std::errc{} || end != word.data() + word.size()) {
+            return error("invalid number '" + std::string{word} + "'");
+        }
+        return true;
+    }
+
+    bool read(Vector3& value) {
+        return read(value.x) && read(value.y) && read(value.z);
+    }
+
+    bool error(const std::string& message) const {
+        std::cerr << filename << ':' << line_number << ": " << message
+                  << ".\n";
+        return false;
+    }
+
+private:
+    void skip_spaces() {
+        auto begin{rest.find_first_not_of(" \t\r")};
+        rest.remove_prefix(begin == rest.npos ? rest.size() : begin);
+    }
+
+    const char* filename;
+
+    std::size_t line_number;
+
+    std::string_view rest;
+};
+
+static bool read_material(LineReader& reader,
+                          Scene::MaterialRecord& material) {
+    using Type = Scene::MaterialRecord::Type;
+
+    std::string_view type;
+    if (!reader.read(type)) {
+        return false;
+    }
+    material = {};
+    auto& parameters{material.parameters};
+    if (type == "lambertian") {
+        material.type = Type::lambertian;
+        return reader.read(parameters[0]) && reader.read(parameters[1])
+               && reader.read(parameters[2]);
+    }
+    if (type == "metal") {
+        material.type = Type::metal;
+        return reader.read(parameters[0]) && reader.read(parameters[1])
+               && reader.read(parameters[2]) && reader.read(parameters[3]);
+    }
+    if (type == "dielectric") {
+        material.type = Type::dielectric;
+        return reader.read(parameters[0]);
+    }
+    if (type == "light") {
+        material.type = Type::diffuse_light;
+        return reader.read(parameters[0]) && reader.read(parameters[1])
+               && reader.read(parameters[2]);
+    }
+    return reader.error("unknown material type '" + std::string{type} + "'");
+}
+
+// Reads the transform operations that end the line, each applied after
+// the ones before it.
+static bool read_steps(LineReader& reader,
+                       std::vector<TransformStep>& steps) {
+    using Type = TransformStep::Type;
+
+    while (!reader.at_end()) {
+        std::string_view operation;
+        reader.read(operation);
+        TransformStep step;
+        if (operation == "translate") {
+            step.type = Type::translate;
+            if (!reader.read(step.vector)) {
+                return false;
+            }
+        } else if (operation == "rotate") {
+            step.type = Type::rotate;
+            if (!reader.read(step.vector) || !reader.read(step.degrees)) {
+                return false;
+            }
+            if (step.vector.magnitude() == 0) {
+                return reader.error("rotation about a zero axis");
+            }
+        } else if (operation == "scale") {
+            step.type = Type::scale;
+            if (!reader.read(step.vector)) {
+                return false;
+            }
+            if (step.vector.x == 0 || step.vector.y == 0
+                || step.vector.z == 0) {
+                return reader.error("scale factors must not be zero");
+            }
+        } else {
+            return reader.error("unknown transform '" + std::string{operation}
+                                + "'");
+        }
+        steps.emplace_back(step);
+    }
+    return true;
+}
+
+// Checks that a key comes after the previous one of its sequence.
+template <typename Key>
+static bool check_order(LineReader& reader,
+                        const std::vector<Key>& keys,
+                        double frame) {
+    if (!keys.empty() && frame <= keys.back().frame) {
+        return reader.error("keys must be in increasing frame order");
+    }
+    return true;
+}
+
+static bool parse_text_scene(const char* filename,
+                             std::string_view text,
+                             ThreadPool& pool,
+                             Scene& scene) {
+    // Names are views into the mapped file, which outlives the parse.
+    std::unordered_map<std::string_view, std::uint32_t> material_ids;
+    std::unordered_map<std::string_view, std::shared_ptr<const TriangleMesh>>
+            meshes;
+
+    // Mesh files are found relative to the scene file.
+    auto directory{std::filesystem::path{filename}.parent_path()};
+
+    // The instance `instance_key` directives move.
+    std::size_t last_instance{0};
+    auto has_instance{false};
+
+    std::size_t line_number{0};
+    while (!text.empty()) {
+        auto line_end{text.find('\n')};
+        auto line{text.substr(0, line_end)};
+        text.remove_prefix(line_end == text.npos ? text.size() : line_end + 1);
+        ++line_number;
+
+        line = line.substr(0, line.find('#'));
+        LineReader reader{filename, line_number, line};
+        if (reader.at_end()) {
+            continue;
+        }
+
+        std::string_view directive;
+        reader.read(directive);
+        auto valid{true};
+        if (directive == "sphere") {
+            Vector3 center;
+            Vector3::ValueType radius;
+            std::string_view material_name;
+            valid = reader.read(center) && reader.read(radius)
+                    && reader.read(material_name);
+            if (valid) {
+                auto material_id{material_ids.find(material_name)};
+                if (material_id == material_ids.end()) {
+                    return reader.error("unknown material '"
+                                        + std::string{material_name} + "'");
+                }
+                scene.spheres.add(center, radius, material_id->second);
+            }
+        } else if (directive == "mesh") {
+            std::string_view name;
+            std::string_view mesh_filename;
+            std::string_view material_name;
+            valid = reader.read(name) && reader.read(mesh_filename)
+                    && reader.read(material_name);
+            if (valid) {
+                auto material_id{material_ids.find(material_name)};
+                if (material_id == material_ids.end()) {
+                    return reader.error("unknown material '"
+                                        + std::string{material_name} + "'");
+                }
+                auto path{(directory / mesh_filename).string()};
+                MeshData mesh;
+                if (!load_mesh(path.c_str(), pool, mesh)) {
+                    return false;
+                }
+                meshes[name] = std::make_shared<const TriangleMesh>(
+                        std::move(mesh),
+                        material_id->second);
+            }
+        } else if (directive == "instance") {
+            std::string_view mesh_name;
+            std::vector<TransformStep> steps;
+            valid = reader.read(mesh_name);
+            if (valid) {
+                auto mesh{meshes.find(mesh_name)};
+                if (mesh == meshes.end()) {
+                    return reader.error("unknown mesh '"
+                                        + std::string{mesh_name} + "'");
+                }
+                valid = read_steps(reader, steps);
+                if (valid) {
+                    last_instance = scene.instances.add(mesh->second,
+                                                        compose(steps));
+                    has_instance = true;
+                }
+            }
+        } else if (directive == "instance_key") {
+            TransformKey key;
+            valid = reader.read(key.frame) && read_steps(reader, key.steps);
+            if (valid) {
+                if (!has_instance) {
+                    return reader.error("instance_key before any instance");
+                }
+                if (scene.instance_tracks.empty()
+                    || scene.instance_tracks.back().instance_index
+                               != last_instance) {
+                    scene.instance_tracks.push_back({last_instance, {}});
+                }
+                auto& keys{scene.instance_tracks.back().keys};
+                if (!check_order(reader, keys, key.frame)) {
+                    return false;
+                }
+                if (!keys.empty()) {
+                    const auto& first_steps{keys.front().steps};
+                    auto matches{first_steps.size() == key.steps.size()};
+                    for (std::size_t i{0}; matches && i < key.steps.size();
+                         ++i) {
+                        matches = first_steps[i].type == key.steps[i].type;
+                    }
+                    if (!matches) {
+                        return reader.error("the operations of the keys of "
+                                            "an instance must match");
+                    }
+                }
+                keys.emplace_back(std::move(key));
+            }
+        } else if (directive == "camera_key") {
+            CameraKey key;
+            valid = reader.read(key.frame) && reader.read(key.lookfrom)
+                    && reader.read(key.lookat);
+            if (valid) {
+                if (!check_order(reader, scene.camera_keys, key.frame)) {
+                    return false;
+                }
+                scene.camera_keys.emplace_back(key);
+            }
+        } else if (directive == "frames") {
+            valid = reader.read(scene.num_frames);
+        } else if (directive == "material") {
+            std::string_view name;
+            Scene::MaterialRecord material;
+            valid = reader.read(name) && read_material(reader, material);
+            if (valid) {
+                material_ids[name] = scene.add_material(material);
+            }
+        } else if (directive == "image") {
+            valid = reader.read(scene.image_width)
+                    && reader.read(scene.image_height);
+        } else if (directive == "samples") {
+            valid = reader.read(scene.samples_per_pixel);
+        } else if (directive == "depth") {
+            valid = reader.read(scene.max_depth);
+        } else if (directive == "camera") {
+            valid = reader.read(scene.lookfrom) && reader.read(scene.lookat)
+                    && reader.read(scene.viewup)
+                    && reader.read(scene.vertical_fov)
+                    && reader.read(scene.focus_distance)
+                    && reader.read(scene.aperture);
+        } else {
+            return reader.error("unknown directive '" + std::string{directive}
+                                + "'");
+        }
+        if (!valid) {
+            return false;
+        }
+        if (!reader.at_end()) {
+            return reader.error("unexpected trailing values");
+        }
+    }
+
+    if (scene.image_width == 0 || scene.image_height == 0
+        || scene.samples_per_pixel == 0 || scene.num_frames == 0) {
+        std::cerr << filename
+                  << ": image size, samples and frames must be positive.\n";
+        return false;
+    }
+    scene.build(pool);
+    return true;
+}
+
+static bool read_binary_scene(const char* filename,
+                              const std::shared_ptr<const MappedFile>& file,
+                              Scene& scene) {
+    SceneHeader header;
+    auto offset{sizeof(header)};
+    auto valid{file->size() >= sizeof(header)};
+    if (valid) {
+        std::memcpy(&header, file->data(), sizeof(header));
+        offset += header.num_materials * sizeof(Scene::MaterialRecord);
+        valid = header.version == scene_version && offset <= file->size()
+                && header.image_width > 0 && header.image_height > 0
+                && header.samples_per_pixel > 0;
+    }
+    if (!valid) {
+        std::cerr << "Invalid scene file: " << filename << ".\n";
+        return false;
+    }
+
+    scene.image_width = header.image_width;
+    scene.image_height = header.image_height;
+    scene.samples_per_pixel = header.samples_per_pixel;
+    scene.max_depth = header.max_depth;
+    scene.lookfrom = Vector3{header.lookfrom[0],
+                             header.lookfrom[1],
+                             header.lookfrom[2]};
+    scene.lookat = Vector3{header.lookat[0],
+                           header.lookat[1],
+                           header.lookat[2]};
+    scene.viewup = Vector3{header.viewup[0],
+                           header.viewup[1],
+                           header.viewup[2]};
+    scene.vertical_fov = header.vertical_fov;
+    scene.focus_distance = header.focus_distance;
+    scene.aperture = header.aperture;
+
+    for (auto i{decltype(header.num_materials){0}}; i < header.num_materials;
+         ++i) {
+        Scene::MaterialRecord material;
+        std::memcpy(&material,
+                    file->data() + sizeof(header)
+                            + i * sizeof(Scene::MaterialRecord),
+                    sizeof(material));
+        if (material.type > Scene::MaterialRecord::Type::diffuse_light) {
+            std::cerr << "Invalid scene file: " << filename << ".\n";
+            return false;
+        }
+        scene.add_material(material);
+    }
+
+    if (!scene.spheres.read(file, offset, header.num_materials)) {
+        std::cerr << "Invalid scene file: " << filename << ".\n";
+        return false;
+    }
+    scene.build_lights();
+    return true;
+}
+
+bool load_scene(const char* filename, ThreadPool& pool, Scene& scene) {
+    auto file{MappedFile::open(filename)};
+    if (!file) {
+        return false;
+    }
+
+    if (file->size() >= sizeof(scene_magic)
+        && std::memcmp(file->data(), scene_magic, sizeof(scene_magic)) == 0) {
+        return read_binary_scene(filename, file, scene);
+    }
+    return parse_text_scene(filename,
+                            std::string_view{file->data(), file->size()},
+                            pool,
+                            scene);
+}
+
+bool save_scene(const char* filename, const Scene& scene) {
+    if (scene.instances.size() > 0) {
+        std::cerr << "Scenes with meshes cannot be saved in the binary "
+                     "format.\n";
+        return false;
+    }
+    if (scene.num_frames > 1) {
+        std::cerr << "Animations cannot be saved in the binary format.\n";
+        return false;
+    }
+
+    auto fp{fopen(filename, "wb")};
+    if (!fp) {
+        std::cerr << "Failed to open file: " << filename << ".\n";
+        return false;
+    }
+
+    SceneHeader header{};
+    std::memcpy(header.magic, scene_magic, sizeof(header.magic));
+    header.version = scene_version;
+    header.num_materials
+            = static_cast<std::uint32_t>(scene.material_records.size());
+    header.image_width = scene.image_width;
+    header.image_height = scene.image_height;
+    header.samples_per_pixel = scene.samples_per_pixel;
+    header.max_depth = scene.max_depth;
+    for (auto axis{0}; axis < 3; ++axis) {
+        header.lookfrom[axis] = scene.lookfrom[axis];
+        header.lookat[axis] = scene.lookat[axis];
+        header.viewup[axis] = scene.viewup[axis];
+    }
+    header.vertical_fov = scene.vertical_fov;
+    header.focus_distance = scene.focus_distance;
+    header.aperture = scene.aperture;
+
+    auto written{fwrite(&header, sizeof(header), 1, fp) == 1
+                 && fwrite(scene.material_records.data(),
+                           sizeof(Scene::MaterialRecord),
+                           scene.material_records.size(),
+                           fp) == scene.material_records.size()
+                 && scene.spheres.write(fp)};
+    if (fclose(fp) != 0 || !written) {
+        std::cerr << "Failed to write scene: " << filename << ".\n";
+        return false;
+    }
+    return true;
+}
+
+}
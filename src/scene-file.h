@@ -0,0 +1,60 @@
+#ifndef SCENE_FILE_H
+#define SCENE_FILE_H
+
+#include "scene.h"
+#include "thread-pool.h"
+
+namespace ray_tracing {
+
+// Loads a scene from either the text format or the binary format written by
+// `save_scene`, telling them apart by the binary magic number. `scene` is
+// left built and ready to render. Prints a message and returns false if the
+// file cannot be read or is malformed.
+//
+// The text format has one directive per line, with the values separated by
+// spaces; `#` starts a comment, and materials and meshes must be declared
+// before whatever uses them:
+//
+//     image <width> <height>
+//     samples <samples per pixel>
+//     depth <max depth>
+//     camera <lookfrom x y z> <lookat x y z> <viewup x y z> <vertical fov>
+//            <focus distance> <aperture>
+//     material <name> lambertian <r> <g> <b>
+//     material <name> metal <r> <g> <b> <fuzz>
+//     material <name> dielectric <index of refraction>
+//     material <name> light <r> <g> <b>
+//     sphere <x> <y> <z> <radius> <material name>
+//     mesh <name> <OBJ or PLY file> <material name>
+//     instance <mesh name> [translate <x> <y> <z>]
+//              [rotate <axis x y z> <degrees>] [scale <x> <y> <z>]...
+//     frames <count>
+//     camera_key <frame> <lookfrom x y z> <lookat x y z>
+//     instance_key <frame> [translate ...] [rotate ...] [scale ...]...
+//
+// A `light` material emits the given radiance from the front of surfaces
+// only: the outside of a sphere, or the side of a triangle its corners wind
+// counterclockwise around.
+//
+// Mesh files are looked up relative to the scene file and loaded on the
+// threads of `pool`. An instance places a mesh in the scene under the
+// transform operations that follow it, applied in order; any number of
+// instances share the mesh they place.
+//
+// Scenes of more than one frame are animations. The camera follows a
+// smooth path through its keys, and an `instance_key` moves the instance
+// declared last, blending the values of its operations between keys, which
+// must all list the same operations. Keys come in increasing frame order,
+// and frames are counted from 0.
+//
+// The binary format stores the built sphere hierarchy as-is; its sphere
+// arrays are used straight from the memory-mapped file.
+bool load_scene(const char* filename, ThreadPool& pool, Scene& scene);
+
+// Writes `scene`, which must be built, in the binary format, which has no
+// room for meshes; scenes with instances are refused.
+bool save_scene(const char* filename, const Scene& scene);
+
+}
+
+#endif
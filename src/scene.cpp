@@ -0,0 +1,229 @@
+#include "scene.h"
+
+#include "triangle-mesh.h"
+#include "utils.h"
+
+#include <utility>
+
+namespace ray_tracing {
+
+static Radiance make_albedo(const double* parameters) {
+    return Radiance{static_cast<Radiance::ValueType>(parameters[0]),
+                    static_cast<Radiance::ValueType>(parameters[1]),
+                    static_cast<Radiance::ValueType>(parameters[2])};
+}
+
+static Material make_material(const Scene::MaterialRecord& material) {
+    const auto& parameters{material.parameters};
+    switch (material.type) {
+    case Scene::MaterialRecord::Type::lambertian:
+        return Lambertian{make_albedo(parameters)};
+    case Scene::MaterialRecord::Type::metal:
+        return Metal{make_albedo(parameters),
+                     static_cast<Vector3::ValueType>(parameters[3])};
+    case Scene::MaterialRecord::Type::diffuse_light:
+        return DiffuseLight{make_albedo(parameters)};
+    case Scene::MaterialRecord::Type::dielectric:
+        break;
+    }
+    return Dielectric{static_cast<Vector3::ValueType>(parameters[0])};
+}
+
+std::uint32_t Scene::add_material(const MaterialRecord& material) {
+    material_records.emplace_back(material);
+    materials.emplace_back(make_material(material));
+    return static_cast<std::uint32_t>(materials.size() - 1);
+}
+
+Scene::World::World(const SphereSet& spheres, const Hittable* instances)
+    : spheres{spheres}, instances{instances} {}
+
+bool Scene::World::hit(const Ray& ray,
+                       HitInfo& hit_info,
+                       Vector3::ValueType min_distance,
+                       Vector3::ValueType max_distance) const {
+    auto hit{spheres.hit(ray, hit_info, min_distance, max_distance)};
+    if (instances
+        && instances->hit(ray,
+                          hit_info,
+                          min_distance,
+                          hit ? hit_info.distance : max_distance)) {
+        hit_info.object_id += static_cast<std::uint32_t>(spheres.size());
+        hit = true;
+    }
+    return hit;
+}
+
+void Scene::World::hit_packet(const RayPacket& packet,
+                              HitInfo* hit_infos,
+                              bool* hits) const {
+    spheres.hit_packet(packet, hit_infos, hits);
+    if (!instances) {
+        return;
+    }
+    for (auto i{decltype(packet.size){0}}; i < packet.size; ++i) {
+        if (instances->hit(packet.rays[i],
+                           hit_infos[i],
+                           default_min_distance,
+                           hits[i] ? hit_infos[i].distance
+                                   : infinity)) {
+            hit_infos[i].object_id
+                    += static_cast<std::uint32_t>(spheres.size());
+            hits[i] = true;
+        }
+    }
+}
+
+BoundingBox Scene::World::bounding_box() const {
+    if (!instances) {
+        return spheres.bounding_box();
+    }
+    return BoundingBox::merge(spheres.bounding_box(),
+                              instances->bounding_box());
+}
+
+void Scene::build(ThreadPool& pool) {
+    spheres.build();
+    instances.build(pool);
+    build_lights();
+}
+
+void Scene::build_lights() {
+    lights.clear();
+    spheres.for_each_sphere([&](const Vector3& center,
+                                Vector3::ValueType radius,
+                                std::uint32_t material_id) {
+        auto light{std::get_if<DiffuseLight>(&materials[material_id])};
+        if (light) {
+            lights.add_sphere(center, radius, light->emitted());
+        }
+    });
+    for (std::size_t i{0}; i < instances.size(); ++i) {
+        const auto& instance{instances.instance(i)};
+        auto mesh{dynamic_cast<const TriangleMesh*>(&instance.instanced())};
+        if (!mesh) {
+            continue;
+        }
+        auto light{std::get_if<DiffuseLight>(&materials[mesh->material()])};
+        if (!light) {
+            continue;
+        }
+
+        // A mirroring transform reverses the winding of the corners, but
+        // not the side the normals of the hits face.
+        const auto& transform{instance.transform()};
+        auto x_axis{transform.apply_vector(Vector3{1, 0, 0})};
+        auto y_axis{transform.apply_vector(Vector3{0, 1, 0})};
+        auto z_axis{transform.apply_vector(Vector3{0, 0, 1})};
+        auto mirrored{
+                Vector3::dot(Vector3::cross(x_axis, y_axis), z_axis) < 0};
+        for (std::size_t j{0}; j < mesh->num_triangles(); ++j) {
+            Vector3 p0;
+            Vector3 p1;
+            Vector3 p2;
+            mesh->triangle(j, p0, p1, p2);
+            p0 = transform.apply_point(p0);
+            p1 = transform.apply_point(p1);
+            p2 = transform.apply_point(p2);
+            if (mirrored) {
+                std::swap(p1, p2);
+            }
+            lights.add_triangle(p0, p1, p2, light->emitted());
+        }
+    }
+    lights.build();
+}
+
+Scene::World Scene::world() const {
+    return World{spheres, instances.size() > 0 ? &instances : nullptr};
+}
+
+void Scene::set_frame(double frame, ThreadPool& pool) {
+    interpolate_camera(camera_keys, frame, lookfrom, lookat);
+    if (instance_tracks.empty()) {
+        return;
+    }
+    for (const auto& track : instance_tracks) {
+        instances.set_transform(track.instance_index,
+                                interpolate_transform(track.keys, frame));
+    }
+    instances.update(pool);
+    build_lights();
+}
+
+Camera Scene::camera() const {
+    return Camera{lookfrom,
+                  lookat,
+                  viewup,
+                  degrees_to_radians(vertical_fov),
+                  static_cast<Vector3::ValueType>(image_width) / image_height,
+                  focus_distance,
+                  aperture};
+}
+
+void random_scene(Scene& scene, ThreadPool& pool) {
+    using Type = Scene::MaterialRecord::Type;
+
+    constexpr auto scene_seed{42};
+    RandomGenerator generator{scene_seed};
+
+    auto ground_material{
+            scene.add_material({Type::lambertian, 0, {0.5, 0.5, 0.5}})};
+    scene.spheres.add(Vector3{0, -1000, 0}, 1000, ground_material);
+
+    for (auto a{-10}; a < 10; ++a) {
+        for (auto b{-10}; b < 10; ++b) {
+            auto center{Vector3{static_cast<Vector3::ValueType>(
+                                        a + 0.9 * random_double(generator)),
+                                0.2,
+                                static_cast<Vector3::ValueType>(
+                                        b + 0.9 * random_double(generator))}};
+            auto material_choice{random_double(generator)};
+
+            if ((center - Vector3{4, 0.2, 0}).magnitude() > 0.9) {
+                Scene::MaterialRecord material{};
+
+                // Each albedo takes a fourth draw, once its alpha channel,
+                // so that the scene stays the same as it has always been.
+                if (material_choice < 0.6) {
+                    material.type = Type::lambertian;
+                    for (auto i{0}; i < 4; ++i) {
+                        auto value{random_double(generator)
+                                   * random_double(generator)};
+                        if (i < 3) {
+                            material.parameters[i] = value;
+                        }
+                    }
+                } else if (material_choice < 0.9) {
+                    material.type = Type::metal;
+                    for (auto i{0}; i < 4; ++i) {
+                        material.parameters[i]
+                                = random_double(generator, 0.5, 1);
+                    }
+                    material.parameters[3] = random_double(generator, 0, 0.5);
+                } else {
+                    material.type = Type::dielectric;
+                    material.parameters[0] = 1.5;
+                }
+
+                scene.spheres.add(center, 0.2, scene.add_material(material));
+            }
+        }
+    }
+
+    auto dielectric_material{
+            scene.add_material({Type::dielectric, 0, {1.5}})};
+    scene.spheres.add(Vector3{0, 1, 0}, 1, dielectric_material);
+
+    auto lambertian_material{
+            scene.add_material({Type::lambertian, 0, {0.4, 0.2, 0.1}})};
+    scene.spheres.add(Vector3{-4, 1, 0}, 1, lambertian_material);
+
+    auto metal_material{
+            scene.add_material({Type::metal, 0, {0.7, 0.6, 0.5, 0}})};
+    scene.spheres.add(Vector3{4, 1, 0}, 1, metal_material);
+
+    scene.build(pool);
+}
+
+}
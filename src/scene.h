@@ -0,0 +1,141 @@
+#ifndef SCENE_H
+#define SCENE_H
+
+#include "animation.h"
+#include "camera.h"
+#include "hittable.h"
+#include "light-sampler.h"
+#include "material.h"
+#include "sphere-set.h"
+#include "thread-pool.h"
+#include "top-level-bvh.h"
+#include "vector3.h"
+
+#include <vector>
+
+#include <cstddef>
+#include <cstdint>
+
+namespace ray_tracing {
+
+// Everything needed to render an image: resolution, sampling settings, the
+// camera and the geometry with its materials.
+struct Scene {
+    // A material as plain data, so that it can be written to a scene file
+    // and turned back into the same `Material`. Unlike a `Material`, its
+    // layout does not depend on the standard library.
+    struct MaterialRecord {
+        enum class Type : std::uint32_t {
+            lambertian,
+            metal,
+            dielectric,
+            diffuse_light
+        };
+
+        Type type;
+
+        std::uint32_t reserved;
+
+        // Lambertian: albedo r, g, b. Metal: albedo r, g, b and fuzz.
+        // Dielectric: index of refraction. Diffuse light: radiance r, g, b.
+        double parameters[4];
+    };
+
+    // The spheres and the instances seen as one object. It refers to the
+    // scene, which must outlive it and not change while it is in use.
+    class World : public Hittable {
+    public:
+        World(const SphereSet& spheres, const Hittable* instances);
+
+        bool hit(const Ray& ray,
+                 HitInfo& hit_info,
+                 Vector3::ValueType min_distance,
+                 Vector3::ValueType max_distance) const override;
+
+        // Traces the packet through the spheres in one go, then each of its
+        // rays through the instances, if there are any.
+        void hit_packet(const RayPacket& packet,
+                        HitInfo* hit_infos,
+                        bool* hits) const override;
+
+        BoundingBox bounding_box() const override;
+
+    private:
+        const SphereSet& spheres;
+
+        const Hittable* instances;
+    };
+
+    // Adds the material to the material table and returns its id there.
+    std::uint32_t add_material(const MaterialRecord& material);
+
+    // Builds the sphere set, the BVH over the instances and the lights.
+    // Must be called again after adding to either; instances that only
+    // moved can be refit instead.
+    void build(ThreadPool& pool);
+
+    // Gathers the spheres and the triangles of instanced meshes that have
+    // a `DiffuseLight` material into `lights`, where they are.
+    void build_lights();
+
+    World world() const;
+
+    // Moves the camera and the instances to where their keys put them at
+    // `frame`, and refits the BVH over the instances, or rebuilds it if it
+    // has got too slow, and the lights with them.
+    void set_frame(double frame, ThreadPool& pool);
+
+    Camera camera() const;
+
+    std::size_t image_width{1920};
+
+    std::size_t image_height{1080};
+
+    std::size_t samples_per_pixel{500};
+
+    std::size_t max_depth{50};
+
+    Vector3 lookfrom{13, 2, -3};
+
+    Vector3 lookat{Vector3::zero};
+
+    Vector3 viewup{Vector3::up};
+
+    // In degrees.
+    Vector3::ValueType vertical_fov{20};
+
+    Vector3::ValueType focus_distance{10};
+
+    Vector3::ValueType aperture{0.1};
+
+    std::vector<MaterialRecord> material_records;
+
+    // Indexed by the material ids of the hit records.
+    std::vector<Material> materials;
+
+    SphereSet spheres;
+
+    // Typically of shared triangle meshes.
+    TopLevelBvh instances;
+
+    // The emitting surfaces among the spheres and instances, for sampling.
+    LightSampler lights;
+
+    // More than one makes an animation.
+    std::size_t num_frames{1};
+
+    // Sorted by frame. The camera stays where `lookfrom` and `lookat` put it
+    // when there are none.
+    std::vector<CameraKey> camera_keys;
+
+    std::vector<InstanceTrack> instance_tracks;
+};
+
+// Fills `scene` with the built-in scene, small spheres of random materials
+// scattered around three large ones, and builds it. The same seed is used
+// every time, so the scene never changes.
+void random_scene(Scene& scene, ThreadPool& pool);
+
+}
+
+#endif
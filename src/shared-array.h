@@ -0,0 +1,71 @@
+#ifndef SHARED_ARRAY_H
+#define SHARED_ARRAY_H
+
+#include <cstddef>
+#include <memory>
+#include <utility>
+#include <vector>
+
+namespace ray_tracing {
+
+// A read-only array that either owns its elements or views memory owned by
+// something else, such as a memory-mapped file, which it keeps alive.
+template <typename T>
+class SharedArray {
+public:
+    SharedArray() = default;
+
+    SharedArray(std::vector<T> values);
+
+    SharedArray(const T* elements,
+                std::size_t num_elements,
+                std::shared_ptr<const void> owner);
+
+    const T& operator[](std::size_t index) const;
+
+    const T* data() const;
+
+    std::size_t size() const;
+
+private:
+    std::shared_ptr<const void> owner;
+
+    const T* elements{nullptr};
+
+    std::size_t num_elements{0};
+};
+
+template <typename T>
+SharedArray<T>::SharedArray(std::vector<T> values) {
+    auto owned{std::make_shared<std::vector<T>>(std::move(values))};
+    elements = owned->data();
+    num_elements = owned->size();
+    owner = std::move(owned);
+}
+
+template <typename T>
+SharedArray<T>::SharedArray(const T* elements,
+                            std::size_t num_elements,
+                            std::shared_ptr<const void> owner)
+    : owner{std::move(owner)},
+      elements{elements},
+      num_elements{num_elements} {}
+
+template <typename T>
+const T& SharedArray<T>::operator[](std::size_t index) const {
+    return elements[index];
+}
+
+template <typename T>
+const T* SharedArray<T>::data() const {
+    return elements;
+}
+
+template <typename T>
+std::size_t SharedArray<T>::size() const {
+    return num_elements;
+}
+
+}
+
+#endif
@@ -0,0 +1,305 @@
+#ifndef SIMD_H
+#define SIMD_H
+
+#if defined(USE_SIMD) && defined(__AVX__)
+#include <immintrin.h>
+#elif defined(USE_SIMD) && defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#include <cmath>
+
+namespace ray_tracing {
+
+// A thin wrapper over a vector register of floats. The width is picked at
+// build time: 8 lanes with AVX, 4 lanes with SSE2 and 4 lanes of plain
+// scalar code when `USE_SIMD` is off or neither is available.
+#if defined(USE_SIMD) && defined(__AVX__)
+
+struct SimdMask {
+    int bits() const {
+        return _mm256_movemask_ps(value);
+    }
+
+    __m256 value;
+};
+
+struct SimdFloat {
+    static constexpr auto width{8};
+
+    SimdFloat() = default;
+
+    SimdFloat(__m256 value) : value{value} {}
+
+    SimdFloat(float value) : value{_mm256_set1_ps(value)} {}
+
+    static SimdFloat load(const float* values) {
+        return _mm256_loadu_ps(values);
+    }
+
+    void store(float* values) const {
+        _mm256_storeu_ps(values, value);
+    }
+
+    __m256 value;
+};
+
+inline SimdFloat operator+(SimdFloat lhs, SimdFloat rhs) {
+    return _mm256_add_ps(lhs.value, rhs.value);
+}
+
+inline SimdFloat operator-(SimdFloat lhs, SimdFloat rhs) {
+    return _mm256_sub_ps(lhs.value, rhs.value);
+}
+
+inline SimdFloat operator*(SimdFloat lhs, SimdFloat rhs) {
+    return _mm256_mul_ps(lhs.value, rhs.value);
+}
+
+inline SimdFloat operator/(SimdFloat lhs, SimdFloat rhs) {
+    return _mm256_div_ps(lhs.value, rhs.value);
+}
+
+inline SimdFloat sqrt(SimdFloat value) {
+    return _mm256_sqrt_ps(value.value);
+}
+
+inline SimdFloat min(SimdFloat lhs, SimdFloat rhs) {
+    return _mm256_min_ps(lhs.value, rhs.value);
+}
+
+inline SimdFloat max(SimdFloat lhs, SimdFloat rhs) {
+    return _mm256_max_ps(lhs.value, rhs.value);
+}
+
+inline SimdMask operator<(SimdFloat lhs, SimdFloat rhs) {
+    return SimdMask{_mm256_cmp_ps(lhs.value, rhs.value, _CMP_LT_OQ)};
+}
+
+inline SimdMask operator<=(SimdFloat lhs, SimdFloat rhs) {
+    return SimdMask{_mm256_cmp_ps(lhs.value, rhs.value, _CMP_LE_OQ)};
+}
+
+inline SimdMask operator&(SimdMask lhs, SimdMask rhs) {
+    return SimdMask{_mm256_and_ps(lhs.value, rhs.value)};
+}
+
+inline SimdMask operator|(SimdMask lhs, SimdMask rhs) {
+    return SimdMask{_mm256_or_ps(lhs.value, rhs.value)};
+}
+
+inline SimdFloat select(SimdMask mask, SimdFloat if_true, SimdFloat if_false) {
+    return _mm256_blendv_ps(if_false.value, if_true.value, mask.value);
+}
+
+#elif defined(USE_SIMD) && defined(__SSE2__)
+
+struct SimdMask {
+    int bits() const {
+        return _mm_movemask_ps(value);
+    }
+
+    __m128 value;
+};
+
+struct SimdFloat {
+    static constexpr auto width{4};
+
+    SimdFloat() = default;
+
+    SimdFloat(__m128 value) : value{value} {}
+
+    SimdFloat(float value) : value{_mm_set1_ps(value)} {}
+
+    static SimdFloat load(const float* values) {
+        return _mm_loadu_ps(values);
+    }
+
+    void store(float* values) const {
+        _mm_storeu_ps(values, value);
+    }
+
+    __m128 value;
+};
+
+inline SimdFloat operator+(SimdFloat lhs, SimdFloat rhs) {
+    return _mm_add_ps(lhs.value, rhs.value);
+}
+
+inline SimdFloat operator-(SimdFloat lhs, SimdFloat rhs) {
+    return _mm_sub_ps(lhs.value, rhs.value);
+}
+
+inline SimdFloat operator*(SimdFloat lhs, SimdFloat rhs) {
+    return _mm_mul_ps(lhs.value, rhs.value);
+}
+
+inline SimdFloat operator/(SimdFloat lhs, SimdFloat rhs) {
+    return _mm_div_ps(lhs.value, rhs.value);
+}
+
+inline SimdFloat sqrt(SimdFloat value) {
+    return _mm_sqrt_ps(value.value);
+}
+
+inline SimdFloat min(SimdFloat lhs, SimdFloat rhs) {
+    return _mm_min_ps(lhs.value, rhs.value);
+}
+
+inline SimdFloat max(SimdFloat lhs, SimdFloat rhs) {
+    return _mm_max_ps(lhs.value, rhs.value);
+}
+
+inline SimdMask operator<(SimdFloat lhs, SimdFloat rhs) {
+    return SimdMask{_mm_cmplt_ps(lhs.value, rhs.value)};
+}
+
+inline SimdMask operator<=(SimdFloat lhs, SimdFloat rhs) {
+    return SimdMask{_mm_cmple_ps(lhs.value, rhs.value)};
+}
+
+inline SimdMask operator&(SimdMask lhs, SimdMask rhs) {
+    return SimdMask{_mm_and_ps(lhs.value, rhs.value)};
+}
+
+inline SimdMask operator|(SimdMask lhs, SimdMask rhs) {
+    return SimdMask{_mm_or_ps(lhs.value, rhs.value)};
+}
+
+inline SimdFloat select(SimdMask mask, SimdFloat if_true, SimdFloat if_false) {
+    return _mm_or_ps(_mm_and_ps(mask.value, if_true.value),
+                     _mm_andnot_ps(mask.value, if_false.value));
+}
+
+#else
+
+struct SimdMask {
+    int bits() const {
+        auto result{0};
+        for (auto i{0}; i < 4; ++i) {
+            result |= value[i] << i;
+        }
+        return result;
+    }
+
+    bool value[4];
+};
+
+struct SimdFloat {
+    static constexpr auto width{4};
+
+    SimdFloat() = default;
+
+    SimdFloat(float value) : value{value, value, value, value} {}
+
+    static SimdFloat load(const float* values) {
+        SimdFloat result;
+        for (auto i{0}; i < width; ++i) {
+            result.value[i] = values[i];
+        }
+        return result;
+    }
+
+    void store(float* values) const {
+        for (auto i{0}; i < width; ++i) {
+            values[i] = value[i];
+        }
+    }
+
+    float value[4];
+};
+
+template <typename Operation>
+inline SimdFloat simd_apply(SimdFloat lhs,
+                            SimdFloat rhs,
+                            Operation operation) {
+    SimdFloat result;
+    for (auto i{0}; i < SimdFloat::width; ++i) {
+        result.value[i] = operation(lhs.value[i], rhs.value[i]);
+    }
+    return result;
+}
+
+template <typename Operation>
+inline SimdMask simd_compare(SimdFloat lhs,
+                             SimdFloat rhs,
+                             Operation operation) {
+    SimdMask result;
+    for (auto i{0}; i < SimdFloat::width; ++i) {
+        result.value[i] = operation(lhs.value[i], rhs.value[i]);
+    }
+    return result;
+}
+
+inline SimdFloat operator+(SimdFloat lhs, SimdFloat rhs) {
+    return simd_apply(lhs, rhs, [](float a, float b) { return a + b; });
+}
+
+inline SimdFloat operator-(SimdFloat lhs, SimdFloat rhs) {
+    return simd_apply(lhs, rhs, [](float a, float b) { return a - b; });
+}
+
+inline SimdFloat operator*(SimdFloat lhs, SimdFloat rhs) {
+    return simd_apply(lhs, rhs, [](float a, float b) { return a * b; });
+}
+
+inline SimdFloat operator/(SimdFloat lhs, SimdFloat rhs) {
+    return simd_apply(lhs, rhs, [](float a, float b) { return a / b; });
+}
+
+inline SimdFloat sqrt(SimdFloat value) {
+    return simd_apply(value, value, [](float a, float) {
+        return std::sqrt(a);
+    });
+}
+
+inline SimdFloat min(SimdFloat lhs, SimdFloat rhs) {
+    return simd_apply(lhs, rhs, [](float a, float b) {
+        return b < a ? b : a;
+    });
+}
+
+inline SimdFloat max(SimdFloat lhs, SimdFloat rhs) {
+    return simd_apply(lhs, rhs, [](float a, float b) {
+        return a < b ? b : a;
+    });
+}
+
+inline SimdMask operator<(SimdFloat lhs, SimdFloat rhs) {
+    return simd_compare(lhs, rhs, [](float a, float b) { return a < b; });
+}
+
+inline SimdMask operator<=(SimdFloat lhs, SimdFloat rhs) {
+    return simd_compare(lhs, rhs, [](float a, float b) { return a <= b; });
+}
+
+inline SimdMask operator&(SimdMask lhs, SimdMask rhs) {
+    SimdMask result;
+    for (auto i{0}; i < SimdFloat::width; ++i) {
+        result.value[i] = lhs.value[i] && rhs.value[i];
+    }
+    return result;
+}
+
+inline SimdMask operator|(SimdMask lhs, SimdMask rhs) {
+    SimdMask result;
+    for (auto i{0}; i < SimdFloat::width; ++i) {
+        result.value[i] = lhs.value[i] || rhs.value[i];
+    }
+    return result;
+}
+
+inline SimdFloat select(SimdMask mask, SimdFloat if_true, SimdFloat if_false) {
+    SimdFloat result;
+    for (auto i{0}; i < SimdFloat::width; ++i) {
+        result.value[i]
+                = mask.value[i] ? if_true.value[i] : if_false.value[i];
+    }
+    return result;
+}
+
+#endif
+
+}
+
+#endif
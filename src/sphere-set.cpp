@@ -0,0 +1,474 @@
+#include "sphere-set.h"
+
+#include "render-stats.h"
+#include "utils.h"
+
+#include <bitset>
+#include <memory>
+#include <limits>
+#include <utility>
+
+#include <cstring>
+
+namespace ray_tracing {
+
+void SphereSet::add(const Vector3& center,
+                    Vector3::ValueType radius,
+                    std::uint32_t material_id) {
+    // The spheres of an earlier `build` are rebuilt along with the new one.
+    unbuild();
+    add_pending(PendingSphere{center,
+                              radius,
+                              material_id,
+                              static_cast<std::uint32_t>(num_pending)});
+}
+
+void SphereSet::build() {
+    tree = BvhTree{pending_bounding_boxes(), SimdFloat::width};
+    store_in_leaf_order();
+}
+
+std::size_t SphereSet::size() const {
+    return num_spheres + num_pending;
+}
+
+void SphereSet::add_pending(const PendingSphere& sphere) {
+    if (num_pending % pending_block_size == 0) {
+        pending_blocks.push_back(
+                pending_arena.allocate<PendingSphere>(pending_block_size));
+    }
+    pending_blocks.back()[num_pending % pending_block_size] = sphere;
+    ++num_pending;
+}
+
+const SphereSet::PendingSphere& SphereSet::pending(std::size_t index) const {
+    return pending_blocks[index / pending_block_size]
+                         [index % pending_block_size];
+}
+
+void SphereSet::unbuild() {
+    for (auto i{decltype(num_spheres){0}}; i < num_spheres; ++i) {
+        add_pending(PendingSphere{
+                Vector3{center_xs[i], center_ys[i], center_zs[i]},
+                radii[i],
+                material_ids[i],
+                object_ids[i]});
+    }
+    num_spheres = 0;
+    tree = BvhTree{};
+}
+
+std::vector<BoundingBox> SphereSet::pending_bounding_boxes() const {
+    std::vector<BoundingBox> boxes;
+    boxes.reserve(num_pending);
+    for (decltype(num_pending) i{0}; i < num_pending; ++i) {
+        const auto& sphere{pending(i)};
+        auto half_extent{Vector3{sphere.radius, sphere.radius, sphere.radius}};
+        boxes.emplace_back(sphere.center - half_extent,
+                           sphere.center + half_extent);
+    }
+    return boxes;
+}
+
+void SphereSet::store_in_leaf_order() {
+    // Leaves are loaded a full register at a time, so the last leaf may read
+    // up to `SimdFloat::width - 1` entries past the end, which are zeroed.
+    // The arrays are laid out one after the other as in a scene file, in a
+    // single block that the last of them to go frees.
+    num_spheres = num_pending;
+    auto num_padded{num_spheres + SimdFloat::width - 1};
+    auto aligned_size{[](std::size_t size) {
+        return (size + Arena::alignment - 1) / Arena::alignment
+               * Arena::alignment;
+    }};
+    auto arena{std::make_shared<Arena>(
+            4 * aligned_size(num_padded * sizeof(float))
+            + 2 * aligned_size(num_spheres * sizeof(std::uint32_t)))};
+    auto xs{arena->allocate<float>(num_padded)};
+    auto ys{arena->allocate<float>(num_padded)};
+    auto zs{arena->allocate<float>(num_padded)};
+    auto rs{arena->allocate<float>(num_padded)};
+    auto ids{arena->allocate<std::uint32_t>(num_spheres)};
+    auto objects{arena->allocate<std::uint32_t>(num_spheres)};
+    for (auto i{decltype(num_spheres){0}}; i < num_spheres; ++i) {
+        const auto& sphere{pending(tree.indices[i])};
+        xs[i] = static_cast<float>(sphere.center.x);
+        ys[i] = static_cast<float>(sphere.center.y);
+        zs[i] = static_cast<float>(sphere.center.z);
+        rs[i] = static_cast<float>(sphere.radius);
+        ids[i] = sphere.material_id;
+        objects[i] = sphere.object_id;
+    }
+    for (auto i{num_spheres}; i < num_padded; ++i) {
+        xs[i] = ys[i] = zs[i] = rs[i] = 0;
+    }
+    center_xs = SharedArray<float>{xs, num_padded, arena};
+    center_ys = SharedArray<float>{ys, num_padded, arena};
+    center_zs = SharedArray<float>{zs, num_padded, arena};
+    radii = SharedArray<float>{rs, num_padded, arena};
+    material_ids = SharedArray<std::uint32_t>{ids, num_spheres, arena};
+    object_ids = SharedArray<std::uint32_t>{objects, num_spheres, arena};
+
+    tree.indices = {};
+    pending_arena = Arena{};
+    pending_blocks = {};
+    num_pending = 0;
+}
+
+bool SphereSet::hit(const Ray& ray,
+                    HitInfo& hit_info,
+                    Vector3::ValueType min_distance,
+                    Vector3::ValueType max_distance) const {
+    // The spheres are stored in single precision whatever `Vector3` uses.
+    auto a{static_cast<float>(ray.direction.magnitude_sqaured())};
+    auto inverse_a{SimdFloat{1 / a}};
+    auto origin_x{SimdFloat{static_cast<float>(ray.origin.x)}};
+    auto origin_y{SimdFloat{static_cast<float>(ray.origin.y)}};
+    auto origin_z{SimdFloat{static_cast<float>(ray.origin.z)}};
+    auto direction_x{SimdFloat{static_cast<float>(ray.direction.x)}};
+    auto direction_y{SimdFloat{static_cast<float>(ray.direction.y)}};
+    auto direction_z{SimdFloat{static_cast<float>(ray.direction.z)}};
+    auto min{SimdFloat{static_cast<float>(min_distance)}};
+
+    std::uint32_t closest_index{0};
+    auto hit_anything{tree.traverse(
+            ray,
+            min_distance,
+            max_distance,
+            [&](auto first, auto count, auto& closest_distance) {
+                add_stat(Stat::intersection_tests, count);
+                auto oc_x{origin_x - SimdFloat::load(&center_xs[first])};
+                auto oc_y{origin_y - SimdFloat::load(&center_ys[first])};
+                auto oc_z{origin_z - SimdFloat::load(&center_zs[first])};
+                auto radius{SimdFloat::load(&radii[first])};
+                auto half_b{oc_x * direction_x + oc_y * direction_y
+                            + oc_z * direction_z};
+                auto c{oc_x * oc_x + oc_y * oc_y + oc_z * oc_z
+                       - radius * radius};
+                auto discriminant{half_b * half_b - SimdFloat{a} * c};
+                auto sqrt_discriminant{sqrt(max(discriminant, 0.0f))};
+
+                // Lanes are compared with the same single-precision bound
+                // as `valid`, which may round above `closest_distance`.
+                auto bound{static_cast<float>(closest_distance)};
+                auto max{SimdFloat{bound}};
+                auto near_root{(SimdFloat{0.0f} - half_b - sqrt_discriminant)
+                               * inverse_a};
+                auto far_root{(sqrt_discriminant - half_b) * inverse_a};
+                auto root{select((min <= near_root) & (near_root <= max),
+                                 near_root,
+                                 far_root)};
+                auto valid{(SimdFloat{0.0f} <= discriminant)
+                           & (min <= root) & (root <= max)};
+
+                auto bits{valid.bits() & ((1 << count) - 1)};
+                if (!bits) {
+                    return false;
+                }
+                float roots[SimdFloat::width];
+                root.store(roots);
+                auto found{false};
+                for (auto lane{0}; lane < SimdFloat::width; ++lane) {
+                    if ((bits & (1 << lane)) && roots[lane] <= bound) {
+                        bound = roots[lane];
+                        closest_distance = roots[lane];
+                        closest_index = first + lane;
+                        found = true;
+                    }
+                }
+                return found;
+            })};
+
+    if (!hit_anything) {
+        return false;
+    }
+    fill_hit_info(ray, max_distance, closest_index, hit_info);
+    return true;
+}
+
+void SphereSet::hit_packet(const RayPacket& packet,
+                           HitInfo* hit_infos,
+                           bool* hits) const {
+    float values[SimdFloat::width]{};
+    auto load_component{[&](auto component) {
+        for (auto i{decltype(packet.size){0}}; i < packet.size; ++i) {
+            values[i] = component(packet.rays[i]);
+        }
+        return SimdFloat::load(values);
+    }};
+    auto origin_x{load_component([](auto& ray) { return ray.origin.x; })};
+    auto origin_y{load_component([](auto& ray) { return ray.origin.y; })};
+    auto origin_z{load_component([](auto& ray) { return ray.origin.z; })};
+    auto direction_x{
+            load_component([](auto& ray) { return ray.direction.x; })};
+    auto direction_y{
+            load_component([](auto& ray) { return ray.direction.y; })};
+    auto direction_z{
+            load_component([](auto& ray) { return ray.direction.z; })};
+    auto a{direction_x * direction_x + direction_y * direction_y
+           + direction_z * direction_z};
+    auto inverse_a{SimdFloat{1.0f} / a};
+    auto inverse_direction_x{SimdFloat{1.0f} / direction_x};
+    auto inverse_direction_y{SimdFloat{1.0f} / direction_y};
+    auto inverse_direction_z{SimdFloat{1.0f} / direction_z};
+    auto min{SimdFloat{static_cast<float>(default_min_distance)}};
+    auto closest{SimdFloat{std::numeric_limits<float>::infinity()}};
+    std::uint32_t closest_indices[SimdFloat::width];
+    auto active_bits{(1 << packet.size) - 1};
+
+    auto slab{[](auto box_min, auto box_max, auto origin, auto inverse) {
+        auto t0{(SimdFloat{static_cast<float>(box_min)} - origin) * inverse};
+        auto t1{(SimdFloat{static_cast<float>(box_max)} - origin) * inverse};
+        return std::make_pair(ray_tracing::min(t0, t1),
+                              ray_tracing::max(t0, t1));
+    }};
+
+    std::uint32_t stack[BvhTree::max_depth];
+    auto stack_size{0};
+    std::uint32_t node_index{0};
+    auto hit_bits{0};
+    while (!tree.nodes.empty()) {
+        const auto& node{tree.nodes[node_index]};
+        auto [near_x, far_x]{slab(node.bounds.min.x,
+                                  node.bounds.max.x,
+                                  origin_x,
+                                  inverse_direction_x)};
+        auto [near_y, far_y]{slab(node.bounds.min.y,
+                                  node.bounds.max.y,
+                                  origin_y,
+                                  inverse_direction_y)};
+        auto [near_z, far_z]{slab(node.bounds.min.z,
+                                  node.bounds.max.z,
+                                  origin_z,
+                                  inverse_direction_z)};
+        auto near{max(max(near_x, near_y), max(near_z, min))};
+        auto far{ray_tracing::min(ray_tracing::min(far_x, far_y),
+                                  ray_tracing::min(far_z, closest))};
+        auto node_bits{(near <= far).bits() & active_bits};
+        add_stat(Stat::bvh_nodes_visited);
+
+        if (node_bits && node.count > 0) {
+            add_stat(Stat::intersection_tests,
+                     node.count * std::bitset<32>(node_bits).count());
+            for (auto i{node.offset}; i < node.offset + node.count; ++i) {
+                auto oc_x{origin_x - SimdFloat{center_xs[i]}};
+                auto oc_y{origin_y - SimdFloat{center_ys[i]}};
+                auto oc_z{origin_z - SimdFloat{center_zs[i]}};
+                auto half_b{oc_x * direction_x + oc_y * direction_y
+                            + oc_z * direction_z};
+                auto c{oc_x * oc_x + oc_y * oc_y + oc_z * oc_z
+                       - SimdFloat{radii[i] * radii[i]}};
+                auto discriminant{half_b * half_b - a * c};
+                auto sqrt_discriminant{sqrt(max(discriminant, 0.0f))};
+                auto near_root{(SimdFloat{0.0f} - half_b - sqrt_discriminant)
+                               * inverse_a};
+                auto far_root{(sqrt_discriminant - half_b) * inverse_a};
+                auto root{select((min <= near_root) & (near_root <= closest),
+                                 near_root,
+                                 far_root)};
+                auto valid{(SimdFloat{0.0f} <= discriminant) & (min <= root)
+                           & (root <= closest)};
+                auto bits{valid.bits() & node_bits};
+                if (bits) {
+                    closest = select(valid, root, closest);
+                    for (auto lane{0}; lane < SimdFloat::width; ++lane) {
+                        if (bits & (1 << lane)) {
+                            closest_indices[lane] = i;
+                        }
+                    }
+                    hit_bits |= bits;
+                }
+            }
+        } else if (node_bits) {
+            if (packet.rays[0].direction[node.axis] < 0) {
+                stack[stack_size++] = node_index + 1;
+                node_index = node.offset;
+            } else {
+                stack[stack_size++] = node.offset;
+                ++node_index;
+            }
+            continue;
+        }
+        if (stack_size == 0) {
+            break;
+        }
+        node_index = stack[--stack_size];
+    }
+
+    float distances[SimdFloat::width];
+    closest.store(distances);
+    for (auto i{decltype(packet.size){0}}; i < packet.size; ++i) {
+        hits[i] = hit_bits & (1 << i);
+        if (hits[i]) {
+            fill_hit_info(packet.rays[i],
+                          distances[i],
+                          closest_indices[i],
+                          hit_infos[i]);
+        }
+    }
+}
+
+BoundingBox SphereSet::bounding_box() const {
+    return tree.bounds();
+}
+
+void SphereSet::fill_hit_info(const Ray& ray,
+                              Vector3::ValueType distance,
+                              std::uint32_t index,
+                              HitInfo& hit_info) const {
+    auto center{Vector3{center_xs[index], center_ys[index], center_zs[index]}};
+    hit_info.distance = distance;
+    hit_info.point = ray.at(distance);
+    hit_info.normal = (hit_info.point - center) / radii[index];
+    hit_info.material_id = material_ids[index];
+    hit_info.object_id = object_ids[index];
+}
+
+struct SphereSetHeader {
+    std::uint64_t num_spheres;
+
+    std::uint64_t num_nodes;
+
+    std::uint32_t simd_width;
+
+    // `sizeof(BvhTree::Node)`, which is larger when `Vector3` uses double
+    // precision.
+    std::uint32_t node_size;
+};
+
+static constexpr std::size_t section_alignment{64};
+
+static std::size_t align_offset(std::size_t offset) {
+    return (offset + section_alignment - 1) / section_alignment
+           * section_alignment;
+}
+
+bool SphereSet::write(std::FILE* fp) const {
+    auto write_section{[fp](const void* data, std::size_t size) {
+        static const char zeros[section_alignment]{};
+        auto offset{static_cast<std::size_t>(std::ftell(fp))};
+        auto padding{align_offset(offset) - offset};
+        return std::fwrite(zeros, 1, padding, fp) == padding
+               && std::fwrite(data, 1, size, fp) == size;
+    }};
+
+    SphereSetHeader header{num_spheres,
+                           tree.nodes.size(),
+                           SimdFloat::width,
+                           sizeof(BvhTree::Node)};
+    auto num_padded{num_spheres + SimdFloat::width - 1};
+    return write_section(&header, sizeof(header))
+           && write_section(tree.nodes.data(),
+                            tree.nodes.size() * sizeof(BvhTree::Node))
+           && write_section(center_xs.data(), num_padded * sizeof(float))
+           && write_section(center_ys.data(), num_padded * sizeof(float))
+           && write_section(center_zs.data(), num_padded * sizeof(float))
+           && write_section(radii.data(), num_padded * sizeof(float))
+           && write_section(material_ids.data(),
+                            num_spheres * sizeof(std::uint32_t))
+           && write_section(object_ids.data(),
+                            num_spheres * sizeof(std::uint32_t));
+}
+
+bool SphereSet::read(const std::shared_ptr<const MappedFile>& file,
+                     std::size_t& offset,
+                     std::uint32_t num_materials) {
+    auto section{[&](std::size_t size) -> const char* {
+        offset = align_offset(offset);
+        if (offset > file->size() || size > file->size() - offset) {
+            return nullptr;
+        }
+        auto data{file->data() + offset};
+        offset += size;
+        return data;
+    }};
+    // Checks the count before multiplying, so that a corrupt one cannot
+    // wrap around to a size that fits.
+    auto array{[&](std::uint64_t count,
+                   std::size_t element_size) -> const char* {
+        if (count > file->size() / element_size) {
+            return nullptr;
+        }
+        return section(static_cast<std::size_t>(count) * element_size);
+    }};
+
+    auto header_data{section(sizeof(SphereSetHeader))};
+    if (!header_data) {
+        return false;
+    }
+    SphereSetHeader header;
+    std::memcpy(&header, header_data, sizeof(header));
+    if (header.simd_width == 0 || header.node_size == 0
+        || header.num_spheres > std::numeric_limits<std::uint32_t>::max()) {
+        return false;
+    }
+
+    auto num_padded{header.num_spheres + header.simd_width - 1};
+    auto nodes{array(header.num_nodes, header.node_size)};
+    auto xs{array(num_padded, sizeof(float))};
+    auto ys{array(num_padded, sizeof(float))};
+    auto zs{array(num_padded, sizeof(float))};
+    auto rs{array(num_padded, sizeof(float))};
+    auto ids{array(header.num_spheres, sizeof(std::uint32_t))};
+    auto objects{array(header.num_spheres, sizeof(std::uint32_t))};
+    if (!nodes || !xs || !ys || !zs || !rs || !ids || !objects) {
+        return false;
+    }
+    for (decltype(header.num_spheres) i{0}; i < header.num_spheres; ++i) {
+        std::uint32_t material_id;
+        std::memcpy(&material_id,
+                    ids + i * sizeof(std::uint32_t),
+                    sizeof(material_id));
+        std::uint32_t object_id;
+        std::memcpy(&object_id,
+                    objects + i * sizeof(std::uint32_t),
+                    sizeof(object_id));
+        if (material_id >= num_materials || object_id >= header.num_spheres) {
+            return false;
+        }
+    }
+
+    num_spheres = header.num_spheres;
+    center_xs = SharedArray<float>{reinterpret_cast<const float*>(xs),
+                                   num_padded,
+                                   file};
+    center_ys = SharedArray<float>{reinterpret_cast<const float*>(ys),
+                                   num_padded,
+                                   file};
+    center_zs = SharedArray<float>{reinterpret_cast<const float*>(zs),
+                                   num_padded,
+                                   file};
+    radii = SharedArray<float>{reinterpret_cast<const float*>(rs),
+                               num_padded,
+                               file};
+    material_ids = SharedArray<std::uint32_t>{
+            reinterpret_cast<const std::uint32_t*>(ids),
+            header.num_spheres,
+            file};
+    object_ids = SharedArray<std::uint32_t>{
+            reinterpret_cast<const std::uint32_t*>(objects),
+            header.num_spheres,
+            file};
+
+    // The hierarchy fits neither a different SIMD width nor, from a build of
+    // the other precision, the layout of the nodes.
+    if (header.simd_width != SimdFloat::width
+        || header.node_size != sizeof(BvhTree::Node)) {
+        unbuild();
+        build();
+        return true;
+    }
+
+    tree.nodes.resize(header.num_nodes);
+    std::memcpy(tree.nodes.data(),
+                nodes,
+                header.num_nodes * sizeof(BvhTree::Node));
+    if (!tree.is_valid(num_spheres, SimdFloat::width)) {
+        tree = BvhTree{};
+        num_spheres = 0;
+        return false;
+    }
+    return true;
+}
+
+}
@@ -0,0 +1,135 @@
+#ifndef SPHERE_SET_H
+#define SPHERE_SET_H
+
+#include "arena.h"
+#include "bvh-tree.h"
+#include "hittable.h"
+#include "mapped-file.h"
+#include "shared-array.h"
+#include "simd.h"
+#include "vector3.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <vector>
+
+namespace ray_tracing {
+
+// A set of spheres stored as structure-of-arrays. `build` sorts the spheres
+// into a BVH whose leaves hold up to `SimdFloat::width` spheres, so a ray is
+// tested against a whole leaf with one SIMD kernel, and the hit record is
+// only filled in once for the closest sphere. Spheres are added into blocks
+// of an arena, which `build` frees at once, and the built arrays share one
+// allocation, so that scenes of millions of spheres neither copy them as a
+// vector grows nor scatter them over the heap.
+class SphereSet : public Hittable {
+public:
+    // `material_id` indexes the scene's material table.
+    void add(const Vector3& center,
+             Vector3::ValueType radius,
+             std::uint32_t material_id);
+
+    void build();
+
+    std::size_t size() const;
+
+    // Calls `visit(center, radius, material_id)` for every sphere of the
+    // last `build`.
+    template <typename Visit>
+    void for_each_sphere(Visit&& visit) const;
+
+    // Writes the built hierarchy and arrays in the layout `read` expects.
+    bool write(std::FILE* fp) const;
+
+    // Reads what `write` stored at `offset` in `file`, advancing `offset`
+    // past it. The arrays are used in place, without copying, unless the
+    // file was written with a different SIMD width or precision, in which
+    // case the set is rebuilt. Fails if the data is cut short or malformed,
+    // or a sphere's material id is not below `num_materials`.
+    bool read(const std::shared_ptr<const MappedFile>& file,
+              std::size_t& offset,
+              std::uint32_t num_materials);
+
+    bool hit(const Ray& ray,
+             HitInfo& hit_info,
+             Vector3::ValueType min_distance,
+             Vector3::ValueType max_distance) const override;
+
+    // Traverses the hierarchy once for the whole packet, testing each node
+    // against all of its rays at once, and intersects each leaf sphere with
+    // all rays that reach it.
+    void hit_packet(const RayPacket& packet,
+                    HitInfo* hit_infos,
+                    bool* hits) const override;
+
+    BoundingBox bounding_box() const override;
+
+private:
+    struct PendingSphere {
+        Vector3 center;
+
+        Vector3::ValueType radius;
+
+        std::uint32_t material_id;
+
+        std::uint32_t object_id;
+    };
+
+    // How many pending spheres each block of `pending_arena` holds.
+    static constexpr std::size_t pending_block_size{std::size_t{1} << 14};
+
+    void add_pending(const PendingSphere& sphere);
+
+    const PendingSphere& pending(std::size_t index) const;
+
+    // Moves the spheres of an earlier `build` back to the pending ones.
+    void unbuild();
+
+    std::vector<BoundingBox> pending_bounding_boxes() const;
+
+    // Stores the pending spheres in the leaf order of `tree` and frees them.
+    void store_in_leaf_order();
+
+    void fill_hit_info(const Ray& ray,
+                       Vector3::ValueType distance,
+                       std::uint32_t index,
+                       HitInfo& hit_info) const;
+
+    Arena pending_arena;
+
+    std::vector<PendingSphere*> pending_blocks;
+
+    std::size_t num_pending{0};
+
+    SharedArray<float> center_xs;
+
+    SharedArray<float> center_ys;
+
+    SharedArray<float> center_zs;
+
+    SharedArray<float> radii;
+
+    SharedArray<std::uint32_t> material_ids;
+
+    // The order each sphere was added in, which the leaf order loses.
+    SharedArray<std::uint32_t> object_ids;
+
+    std::size_t num_spheres{0};
+
+    BvhTree tree;
+};
+
+template <typename Visit>
+void SphereSet::for_each_sphere(Visit&& visit) const {
+    for (auto i{decltype(num_spheres){0}}; i < num_spheres; ++i) {
+        visit(Vector3{center_xs[i], center_ys[i], center_zs[i]},
+              static_cast<Vector3::ValueType>(radii[i]),
+              material_ids[i]);
+    }
+}
+
+}
+
+#endif
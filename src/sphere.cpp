@@ -1,18 +1,21 @@
 #include "sphere.h"
 
+#include "render-stats.h"
+
 #include <cmath>
 
 namespace ray_tracing {
 
 Sphere::Sphere(const Vector3& center,
                Vector3::ValueType radius,
-               std::shared_ptr<Material> material_ptr)
-    : center{center}, radius{radius}, material_ptr{material_ptr} {}
+               std::uint32_t material_id)
+    : center{center}, radius{radius}, material_id{material_id} {}
 
 bool Sphere::hit(const Ray& ray,
                  HitInfo& hit_info,
                  Vector3::ValueType min_distance,
                  Vector3::ValueType max_distance) const {
+    add_stat(Stat::intersection_tests);
     auto oc{ray.origin - center};
     auto a{ray.direction.magnitude_sqaured()};
     auto half_b{Vector3::dot(oc, ray.direction)};
@@ -35,9 +38,15 @@ bool Sphere::hit(const Ray& ray,
     hit_info.point = ray.at(root);
     hit_info.normal = (hit_info.point - center) / radius;
     hit_info.distance = root;
-    hit_info.material_ptr = material_ptr;
+    hit_info.material_id = material_id;
+    hit_info.object_id = 0;
 
     return true;
 }
 
+BoundingBox Sphere::bounding_box() const {
+    auto half_extent{Vector3{radius, radius, radius}};
+    return BoundingBox{center - half_extent, center + half_extent};
+}
+
 }
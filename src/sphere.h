@@ -2,10 +2,9 @@
 #define SPHERE_H
 
 #include "hittable.h"
-#include "material.h"
 #include "vector3.h"
 
-#include <memory>
+#include <cstdint>
 
 namespace ray_tracing {
 
@@ -13,19 +12,21 @@ class Sphere : public Hittable {
 public:
     Sphere(const Vector3& center,
            Vector3::ValueType radius,
-           std::shared_ptr<Material> material_ptr);
+           std::uint32_t material_id);
 
     bool hit(const Ray& ray,
              HitInfo& hit_info,
              Vector3::ValueType min_distance,
              Vector3::ValueType max_distance) const override;
 
+    BoundingBox bounding_box() const override;
+
 private:
     Vector3 center;
 
     Vector3::ValueType radius;
 
-    std::shared_ptr<Material> material_ptr;
+    std::uint32_t material_id;
 };
 
 }
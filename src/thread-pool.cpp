@@ -0,0 +1,121 @@
+#include "thread-pool.h"
+
+#ifdef USE_OPENMP
+#include <omp.h>
+#endif
+
+#include <algorithm>
+
+namespace ray_tracing {
+
+ThreadPool::ThreadPool(std::size_t num_threads)
+    : queues(std::max(num_threads, std::size_t{1})) {
+    for (auto i{std::size_t{1}}; i < queues.size(); ++i) {
+        threads.emplace_back([this, i] { worker_loop(i); });
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock{mutex};
+        stopping = true;
+    }
+    start_condition.notify_all();
+    for (auto& thread : threads) {
+        thread.join();
+    }
+}
+
+std::size_t ThreadPool::default_size() {
+#ifdef USE_OPENMP
+    return omp_get_max_threads();
+#else
+    return std::max(std::thread::hardware_concurrency(), 1u);
+#endif
+}
+
+std::size_t ThreadPool::size() const {
+    return queues.size();
+}
+
+void ThreadPool::run(std::size_t num_tasks, const Task& task) {
+    if (num_tasks == 0) {
+        return;
+    }
+
+    for (auto i{decltype(num_tasks){0}}; i < num_tasks; ++i) {
+        auto& queue{queues[i % queues.size()]};
+        std::lock_guard<std::mutex> lock{queue.mutex};
+        queue.task_indices.push_back(i);
+    }
+
+    {
+        std::lock_guard<std::mutex> lock{mutex};
+        current_task = &task;
+        num_active = threads.size();
+        ++generation;
+    }
+    start_condition.notify_all();
+
+    work(0);
+
+    std::unique_lock<std::mutex> lock{mutex};
+    done_condition.wait(lock, [this] { return num_active == 0; });
+    current_task = nullptr;
+}
+
+void ThreadPool::worker_loop(std::size_t thread_index) {
+    std::size_t seen_generation{0};
+    for (;;) {
+        {
+            std::unique_lock<std::mutex> lock{mutex};
+            start_condition.wait(lock, [&] {
+                return stopping || generation != seen_generation;
+            });
+            if (stopping) {
+                return;
+            }
+            seen_generation = generation;
+        }
+
+        work(thread_index);
+
+        std::lock_guard<std::mutex> lock{mutex};
+        if (--num_active == 0) {
+            done_condition.notify_all();
+        }
+    }
+}
+
+void ThreadPool::work(std::size_t thread_index) {
+    std::size_t task_index;
+    while (pop(thread_index, task_index) || steal(thread_index, task_index)) {
+        (*current_task)(task_index, thread_index);
+    }
+}
+
+bool ThreadPool::pop(std::size_t thread_index, std::size_t& task_index) {
+    auto& queue{queues[thread_index]};
+    std::lock_guard<std::mutex> lock{queue.mutex};
+    if (queue.task_indices.empty()) {
+        return false;
+    }
+    task_index = queue.task_indices.front();
+    queue.task_indices.pop_front();
+    return true;
+}
+
+bool ThreadPool::steal(std::size_t thread_index, std::size_t& task_index) {
+    for (auto i{std::size_t{1}}; i < queues.size(); ++i) {
+        auto& queue{queues[(thread_index + i) % queues.size()]};
+        std::lock_guard<std::mutex> lock{queue.mutex};
+        if (!queue.task_indices.empty()) {
+            task_index = queue.task_indices.back();
+            queue.task_indices.pop_back();
+            return true;
+        }
+    }
+    return false;
+}
+
+}
@@ -0,0 +1,73 @@
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace ray_tracing {
+
+// A fixed set of worker threads that run batches of indexed tasks. Each
+// batch is dealt round-robin onto per-worker queues in index order, so
+// lower indices start first; a worker that runs out of tasks steals from
+// the back of the other queues. The thread calling `run` works as well.
+class ThreadPool {
+public:
+    using Task = std::function<void(std::size_t task_index,
+                                    std::size_t thread_index)>;
+
+    explicit ThreadPool(std::size_t num_threads);
+
+    ThreadPool(const ThreadPool&) = delete;
+
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    ~ThreadPool();
+
+    static std::size_t default_size();
+
+    std::size_t size() const;
+
+    void run(std::size_t num_tasks, const Task& task);
+
+private:
+    struct Queue {
+        std::mutex mutex;
+
+        std::deque<std::size_t> task_indices;
+    };
+
+    void worker_loop(std::size_t thread_index);
+
+    void work(std::size_t thread_index);
+
+    bool pop(std::size_t thread_index, std::size_t& task_index);
+
+    bool steal(std::size_t thread_index, std::size_t& task_index);
+
+    std::vector<Queue> queues;
+
+    std::vector<std::thread> threads;
+
+    std::mutex mutex;
+
+    std::condition_variable start_condition;
+
+    std::condition_variable done_condition;
+
+    const Task* current_task{nullptr};
+
+    std::size_t generation{0};
+
+    std::size_t num_active{0};
+
+    bool stopping{false};
+};
+
+}
+
+#endif
@@ -0,0 +1,24 @@
+#include "tile.h"
+
+#include <algorithm>
+
+namespace ray_tracing {
+
+std::vector<Tile> make_tiles(std::size_t image_width,
+                             std::size_t row_begin,
+                             std::size_t row_end,
+                             std::size_t tile_size) {
+    std::vector<Tile> tiles;
+    for (auto y{row_begin}; y < row_end; y += tile_size) {
+        for (auto x{decltype(image_width){0}}; x < image_width;
+             x += tile_size) {
+            tiles.emplace_back(Tile{x,
+                                    y,
+                                    std::min(x + tile_size, image_width),
+                                    std::min(y + tile_size, row_end)});
+        }
+    }
+    return tiles;
+}
+
+}
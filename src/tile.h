@@ -0,0 +1,28 @@
+#ifndef TILE_H
+#define TILE_H
+
+#include <cstddef>
+#include <vector>
+
+namespace ray_tracing {
+
+// A rectangle of pixels in image coordinates, with rows counted from the
+// top of the image. The end coordinates are exclusive.
+struct Tile {
+    std::size_t x_begin;
+
+    std::size_t y_begin;
+
+    std::size_t x_end;
+
+    std::size_t y_end;
+};
+
+std::vector<Tile> make_tiles(std::size_t image_width,
+                             std::size_t row_begin,
+                             std::size_t row_end,
+                             std::size_t tile_size);
+
+}
+
+#endif
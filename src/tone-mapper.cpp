@@ -0,0 +1,54 @@
+#include "tone-mapper.h"
+
+#include <algorithm>
+
+#include <cmath>
+
+namespace ray_tracing {
+
+// The inverse of the sRGB transfer function, from encoded to linear.
+static double srgb_to_linear(double value) {
+    return value <= 0.04045 ? value / 12.92
+                            : std::pow((value + 0.055) / 1.055, 2.4);
+}
+
+ToneMapper::ToneMapper(const ToneMapSettings& settings)
+    : scale{std::exp2(settings.exposure)},
+      tone_map_operator{settings.tone_map_operator} {
+    // Level `i` covers encoded values in [i / 256, (i + 1) / 256), with 1
+    // itself folded into the top level.
+    for (std::size_t i{0}; i < thresholds.size(); ++i) {
+        thresholds[i] = static_cast<float>(srgb_to_linear((i + 1) / 256.0));
+    }
+}
+
+void ToneMapper::to_rgb8(const float* linear,
+                         std::size_t num_pixels,
+                         std::uint8_t* image) const {
+    for (std::size_t i{0}; i < num_pixels * 3; ++i) {
+        image[i] = encode(map(linear[i] * scale));
+    }
+}
+
+float ToneMapper::map(float value) const {
+    switch (tone_map_operator) {
+    case ToneMapOperator::clamp:
+        break;
+    case ToneMapOperator::reinhard:
+        return value / (1 + value);
+    case ToneMapOperator::aces:
+        return value * (2.51f * value + 0.03f)
+               / (value * (2.43f * value + 0.59f) + 0.14f);
+    }
+    return value;
+}
+
+std::uint8_t ToneMapper::encode(float value) const {
+    // NaN compares false against every threshold and, as before, ends up
+    // white.
+    return static_cast<std::uint8_t>(
+            std::upper_bound(thresholds.begin(), thresholds.end(), value)
+            - thresholds.begin());
+}
+
+}
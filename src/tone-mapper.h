@@ -0,0 +1,54 @@
+#ifndef TONE_MAPPER_H
+#define TONE_MAPPER_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+namespace ray_tracing {
+
+enum class ToneMapOperator {
+    // Clips everything brighter than white.
+    clamp,
+    // x / (1 + x) per channel, compressing highlights smoothly.
+    reinhard,
+    // Narkowicz's fit of the ACES filmic curve.
+    aces
+};
+
+struct ToneMapSettings {
+    // In stops: the radiance is scaled by 2^exposure before tone mapping.
+    float exposure{0};
+
+    ToneMapOperator tone_map_operator{ToneMapOperator::clamp};
+};
+
+// Turns the linear radiance of a resolved film into 8-bit sRGB, once per
+// pixel at output time. The sRGB transfer function is inverted up front into
+// the 255 linear values at which the output steps up a level, so encoding a
+// channel is a short binary search instead of a `std::pow`.
+class ToneMapper {
+public:
+    ToneMapper(const ToneMapSettings& settings);
+
+    // Maps `num_pixels` pixels of the float RGB `linear` into the 8-bit RGB
+    // `image`.
+    void to_rgb8(const float* linear,
+                 std::size_t num_pixels,
+                 std::uint8_t* image) const;
+
+private:
+    float map(float value) const;
+
+    std::uint8_t encode(float value) const;
+
+    float scale;
+
+    ToneMapOperator tone_map_operator;
+
+    std::array<float, 255> thresholds;
+};
+
+}
+
+#endif
@@ -0,0 +1,114 @@
+#include "top-level-bvh.h"
+
+#include <numeric>
+#include <utility>
+
+namespace ray_tracing {
+
+// Enough tasks per thread to even out the work stealing, each updating
+// a range of boxes.
+static constexpr std::size_t ranges_per_thread{4};
+
+std::size_t TopLevelBvh::add(std::shared_ptr<const Hittable> object,
+                             const Transform& object_to_world) {
+    indices.emplace_back(static_cast<std::uint32_t>(slots.size()));
+    slots.emplace_back(instances.size());
+    instances.emplace_back(std::move(object), object_to_world);
+    return slots.size() - 1;
+}
+
+std::size_t TopLevelBvh::size() const {
+    return instances.size();
+}
+
+const Instance& TopLevelBvh::instance(std::size_t index) const {
+    return instances[slots[index]];
+}
+
+void TopLevelBvh::set_transform(std::size_t index,
+                                const Transform& object_to_world) {
+    instances[slots[index]].set_transform(object_to_world);
+}
+
+void TopLevelBvh::update_boxes(ThreadPool& pool) {
+    boxes.resize(instances.size());
+    auto num_ranges{pool.size() * ranges_per_thread};
+    pool.run(num_ranges, [&](auto range_index, auto) {
+        auto first{instances.size() * range_index / num_ranges};
+        auto last{instances.size() * (range_index + 1) / num_ranges};
+        for (auto i{first}; i < last; ++i) {
+            boxes[i] = instances[i].bounding_box();
+        }
+    });
+}
+
+void TopLevelBvh::build(ThreadPool& pool) {
+    update_boxes(pool);
+    tree = BvhTree{boxes, max_leaf_size, pool};
+
+    // Put the instances in leaf order, and follow them with their slots.
+    std::vector<Instance> ordered_instances;
+    std::vector<BoundingBox> ordered_boxes;
+    std::vector<std::uint32_t> ordered_indices;
+    std::vector<std::size_t> new_slots(instances.size());
+    ordered_instances.reserve(instances.size());
+    ordered_boxes.reserve(boxes.size());
+    ordered_indices.reserve(indices.size());
+    for (std::size_t i{0}; i < tree.indices.size(); ++i) {
+        auto index{tree.indices[i]};
+        ordered_instances.emplace_back(std::move(instances[index]));
+        ordered_boxes.emplace_back(boxes[index]);
+        ordered_indices.emplace_back(indices[index]);
+        new_slots[index] = i;
+    }
+    for (auto& slot : slots) {
+        slot = new_slots[slot];
+    }
+    instances = std::move(ordered_instances);
+    boxes = std::move(ordered_boxes);
+    indices = std::move(ordered_indices);
+    std::iota(tree.indices.begin(), tree.indices.end(), 0);
+    built_cost = tree.traversal_cost();
+}
+
+void TopLevelBvh::refit(ThreadPool& pool) {
+    update_boxes(pool);
+    tree.refit(boxes, pool);
+}
+
+void TopLevelBvh::update(ThreadPool& pool) {
+    refit(pool);
+    if (tree.traversal_cost() > max_refit_cost * built_cost) {
+        build(pool);
+    }
+}
+
+bool TopLevelBvh::hit(const Ray& ray,
+                      HitInfo& hit_info,
+                      Vector3::ValueType min_distance,
+                      Vector3::ValueType max_distance) const {
+    return tree.traverse(
+            ray,
+            min_distance,
+            max_distance,
+            [&](auto first, auto count, auto& closest_distance) {
+                auto hit_anything{false};
+                for (auto i{first}; i < first + count; ++i) {
+                    if (instances[i].hit(ray,
+                                         hit_info,
+                                         min_distance,
+                                         closest_distance)) {
+                        hit_anything = true;
+                        closest_distance = hit_info.distance;
+                        hit_info.object_id = indices[i];
+                    }
+                }
+                return hit_anything;
+            });
+}
+
+BoundingBox TopLevelBvh::bounding_box() const {
+    return tree.bounds();
+}
+
+}
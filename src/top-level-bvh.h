@@ -0,0 +1,83 @@
+#ifndef TOP_LEVEL_BVH_H
+#define TOP_LEVEL_BVH_H
+
+#include "bvh-tree.h"
+#include "hittable.h"
+#include "instance.h"
+#include "thread-pool.h"
+#include "transform.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace ray_tracing {
+
+// The top level of a two-level hierarchy: a BVH over instances of objects
+// that each bring their own, such as `TriangleMesh`es. The objects' trees
+// are built once, and only this one follows the instances as they move,
+// either refit to their new bounds, which takes a single pass over the
+// nodes, or rebuilt when they have moved far enough to make the old tree
+// slow. Both run on a thread pool.
+//
+// Instances are kept in leaf order, so each leaf reads a contiguous range,
+// and are referred to by the index `add` returned across rebuilds, which is
+// also the object id of their hits.
+class TopLevelBvh : public Hittable {
+public:
+    // Returns the index of the new instance, which is only hit after the
+    // next `build`.
+    std::size_t add(std::shared_ptr<const Hittable> object,
+                    const Transform& object_to_world);
+
+    std::size_t size() const;
+
+    const Instance& instance(std::size_t index) const;
+
+    // Takes effect with the next `refit` or `build`.
+    void set_transform(std::size_t index, const Transform& object_to_world);
+
+    void build(ThreadPool& pool);
+
+    // Must follow a `build` with no `add` in between.
+    void refit(ThreadPool& pool);
+
+    // Refits the tree, or rebuilds it instead once refitting has made it
+    // more than `max_refit_cost` times as costly to traverse as it was when
+    // it was built.
+    void update(ThreadPool& pool);
+
+    bool hit(const Ray& ray,
+             HitInfo& hit_info,
+             Vector3::ValueType min_distance,
+             Vector3::ValueType max_distance) const override;
+
+    BoundingBox bounding_box() const override;
+
+private:
+    static constexpr std::size_t max_leaf_size{2};
+
+    static constexpr double max_refit_cost{1.5};
+
+    void update_boxes(ThreadPool& pool);
+
+    std::vector<Instance> instances;
+
+    // Where in `instances` each index returned by `add` is.
+    std::vector<std::size_t> slots;
+
+    // The index `add` returned for each of `instances`.
+    std::vector<std::uint32_t> indices;
+
+    // The bounds of `instances`, in the same order.
+    std::vector<BoundingBox> boxes;
+
+    BvhTree tree;
+
+    double built_cost{0};
+};
+
+}
+
+#endif
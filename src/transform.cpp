@@ -0,0 +1,119 @@
+#include "transform.h"
+
+#include <cmath>
+
+namespace ray_tracing {
+
+Transform::Transform()
+    : m{{1, 0, 0, 0}, {0, 1, 0, 0}, {0, 0, 1, 0}} {}
+
+Transform Transform::translation(const Vector3& offset) {
+    Transform transform;
+    transform.m[0][3] = offset.x;
+    transform.m[1][3] = offset.y;
+    transform.m[2][3] = offset.z;
+    return transform;
+}
+
+Transform Transform::scaling(const Vector3& factors) {
+    Transform transform;
+    transform.m[0][0] = factors.x;
+    transform.m[1][1] = factors.y;
+    transform.m[2][2] = factors.z;
+    return transform;
+}
+
+Transform Transform::rotation(const Vector3& axis, Vector3::ValueType angle) {
+    // Rodrigues' rotation formula.
+    auto a{axis.normalized()};
+    auto cos{std::cos(angle)};
+    auto sin{std::sin(angle)};
+    auto t{1 - cos};
+    Transform transform;
+    transform.m[0][0] = t * a.x * a.x + cos;
+    transform.m[0][1] = t * a.x * a.y - sin * a.z;
+    transform.m[0][2] = t * a.x * a.z + sin * a.y;
+    transform.m[1][0] = t * a.x * a.y + sin * a.z;
+    transform.m[1][1] = t * a.y * a.y + cos;
+    transform.m[1][2] = t * a.y * a.z - sin * a.x;
+    transform.m[2][0] = t * a.x * a.z - sin * a.y;
+    transform.m[2][1] = t * a.y * a.z + sin * a.x;
+    transform.m[2][2] = t * a.z * a.z + cos;
+    return transform;
+}
+
+Transform Transform::operator*(const Transform& rhs) const {
+    Transform product;
+    for (auto row{0}; row < 3; ++row) {
+        for (auto column{0}; column < 4; ++column) {
+            product.m[row][column] = m[row][0] * rhs.m[0][column]
+                                     + m[row][1] * rhs.m[1][column]
+                                     + m[row][2] * rhs.m[2][column];
+        }
+        product.m[row][3] += m[row][3];
+    }
+    return product;
+}
+
+Transform Transform::inverse() const {
+    // The adjugate of the linear part over its determinant, in double
+    // precision whatever `Vector3` uses.
+    double cofactors[3][3];
+    for (auto row{0}; row < 3; ++row) {
+        for (auto column{0}; column < 3; ++column) {
+            auto r0{(row + 1) % 3};
+            auto r1{(row + 2) % 3};
+            auto c0{(column + 1) % 3};
+            auto c1{(column + 2) % 3};
+            cofactors[row][column]
+                    = static_cast<double>(m[r0][c0]) * m[r1][c1]
+                      - static_cast<double>(m[r0][c1]) * m[r1][c0];
+        }
+    }
+    auto determinant{m[0][0] * cofactors[0][0] + m[0][1] * cofactors[0][1]
+                     + m[0][2] * cofactors[0][2]};
+
+    Transform inverse;
+    for (auto row{0}; row < 3; ++row) {
+        for (auto column{0}; column < 3; ++column) {
+            inverse.m[row][column] = static_cast<Vector3::ValueType>(
+                    cofactors[column][row] / determinant);
+        }
+    }
+    auto translation{inverse.apply_vector(Vector3{m[0][3], m[1][3], m[2][3]})};
+    inverse.m[0][3] = -translation.x;
+    inverse.m[1][3] = -translation.y;
+    inverse.m[2][3] = -translation.z;
+    return inverse;
+}
+
+Vector3 Transform::apply_point(const Vector3& point) const {
+    return apply_vector(point) + Vector3{m[0][3], m[1][3], m[2][3]};
+}
+
+Vector3 Transform::apply_vector(const Vector3& vector) const {
+    return Vector3{m[0][0] * vector.x + m[0][1] * vector.y + m[0][2] * vector.z,
+                   m[1][0] * vector.x + m[1][1] * vector.y + m[1][2] * vector.z,
+                   m[2][0] * vector.x + m[2][1] * vector.y
+                           + m[2][2] * vector.z};
+}
+
+Vector3 Transform::apply_transposed(const Vector3& vector) const {
+    return Vector3{m[0][0] * vector.x + m[1][0] * vector.y + m[2][0] * vector.z,
+                   m[0][1] * vector.x + m[1][1] * vector.y + m[2][1] * vector.z,
+                   m[0][2] * vector.x + m[1][2] * vector.y
+                           + m[2][2] * vector.z};
+}
+
+BoundingBox Transform::apply(const BoundingBox& box) const {
+    auto bounds{BoundingBox::empty};
+    for (auto corner{0}; corner < 8; ++corner) {
+        bounds.expand(apply_point(Vector3{corner & 1 ? box.max.x : box.min.x,
+                                          corner & 2 ? box.max.y : box.min.y,
+                                          corner & 4 ? box.max.z
+                                                     : box.min.z}));
+    }
+    return bounds;
+}
+
+}
@@ -0,0 +1,49 @@
+#ifndef TRANSFORM_H
+#define TRANSFORM_H
+
+#include "bounding-box.h"
+#include "vector3.h"
+
+namespace ray_tracing {
+
+// An affine transformation, stored as the top three rows of a 4x4 matrix
+// that multiplies column vectors: a linear part followed by a translation.
+class Transform {
+public:
+    // The identity.
+    Transform();
+
+    static Transform translation(const Vector3& offset);
+
+    static Transform scaling(const Vector3& factors);
+
+    // Rotates counterclockwise by `angle` radians around `axis`, looking
+    // down the axis towards the origin.
+    static Transform rotation(const Vector3& axis, Vector3::ValueType angle);
+
+    // Applies `rhs` first and then this transform.
+    Transform operator*(const Transform& rhs) const;
+
+    // The linear part must not be singular.
+    Transform inverse() const;
+
+    Vector3 apply_point(const Vector3& point) const;
+
+    // Applies only the linear part, as for directions.
+    Vector3 apply_vector(const Vector3& vector) const;
+
+    // Applies the transpose of the linear part. Called on the inverse of a
+    // transform, this maps the normals of the surfaces the transform itself
+    // moves.
+    Vector3 apply_transposed(const Vector3& vector) const;
+
+    // The bounds of the transformed corners of `box`.
+    BoundingBox apply(const BoundingBox& box) const;
+
+private:
+    Vector3::ValueType m[3][4];
+};
+
+}
+
+#endif
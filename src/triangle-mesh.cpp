@@ -0,0 +1,154 @@
+#include "triangle-mesh.h"
+
+#include "render-stats.h"
+
+#include <cmath>
+#include <type_traits>
+#include <utility>
+
+namespace ray_tracing {
+
+TriangleMesh::TriangleMesh(MeshData mesh, std::uint32_t material_id)
+    : positions{std::move(mesh.positions)}, material_id{material_id} {
+    std::vector<BoundingBox> boxes;
+    boxes.reserve(mesh.indices.size() / 3);
+    for (std::size_t i{0}; i + 2 < mesh.indices.size(); i += 3) {
+        auto box{BoundingBox::empty};
+        for (auto corner{0}; corner < 3; ++corner) {
+            box.expand(positions[mesh.indices[i + corner]]);
+        }
+        boxes.emplace_back(box);
+    }
+    tree = BvhTree{boxes, max_leaf_size};
+
+    indices.reserve(boxes.size() * 3);
+    for (auto index : tree.indices) {
+        for (auto corner{0}; corner < 3; ++corner) {
+            indices.emplace_back(mesh.indices[index * 3 + corner]);
+        }
+    }
+}
+
+std::size_t TriangleMesh::num_triangles() const {
+    return indices.size() / 3;
+}
+
+std::uint32_t TriangleMesh::material() const {
+    return material_id;
+}
+
+void TriangleMesh::triangle(std::size_t index,
+                            Vector3& p0,
+                            Vector3& p1,
+                            Vector3& p2) const {
+    p0 = positions[indices[index * 3]];
+    p1 = positions[indices[index * 3 + 1]];
+    p2 = positions[indices[index * 3 + 2]];
+}
+
+bool TriangleMesh::hit(const Ray& ray,
+                       HitInfo& hit_info,
+                       Vector3::ValueType min_distance,
+                       Vector3::ValueType max_distance) const {
+    // Permute the axes so that the ray runs mostly along z, keeping the
+    // winding of the triangles, and shear them so that it runs exactly
+    // along z.
+    auto abs_x{std::fabs(ray.direction.x)};
+    auto abs_y{std::fabs(ray.direction.y)};
+    auto abs_z{std::fabs(ray.direction.z)};
+    auto kz{abs_x > abs_y ? (abs_x > abs_z ? 0 : 2) : (abs_y > abs_z ? 1 : 2)};
+    auto kx{(kz + 1) % 3};
+    auto ky{(kx + 1) % 3};
+    if (ray.direction[kz] < 0) {
+        std::swap(kx, ky);
+    }
+    auto shear_x{ray.direction[kx] / ray.direction[kz]};
+    auto shear_y{ray.direction[ky] / ray.direction[kz]};
+    auto shear_z{1 / ray.direction[kz]};
+
+    std::uint32_t closest_index{0};
+    auto hit_anything{tree.traverse(
+            ray,
+            min_distance,
+            max_distance,
+            [&](auto first, auto count, auto& closest_distance) {
+                add_stat(Stat::intersection_tests, count);
+                auto found{false};
+                for (auto i{first}; i < first + count; ++i) {
+                    auto a{positions[indices[i * 3]] - ray.origin};
+                    auto b{positions[indices[i * 3 + 1]] - ray.origin};
+                    auto c{positions[indices[i * 3 + 2]] - ray.origin};
+                    auto ax{a[kx] - shear_x * a[kz]};
+                    auto ay{a[ky] - shear_y * a[kz]};
+                    auto bx{b[kx] - shear_x * b[kz]};
+                    auto by{b[ky] - shear_y * b[kz]};
+                    auto cx{c[kx] - shear_x * c[kz]};
+                    auto cy{c[ky] - shear_y * c[kz]};
+
+                    // The scaled barycentric coordinates, recomputed in
+                    // double precision when one of them comes out as zero
+                    // so that the sign of an edge is never lost to
+                    // rounding.
+                    auto u{cx * by - cy * bx};
+                    auto v{ax * cy - ay * cx};
+                    auto w{bx * ay - by * ax};
+                    if constexpr (std::is_same_v<Vector3::ValueType, float>) {
+                        if (u == 0 || v == 0 || w == 0) {
+                            u = static_cast<float>(
+                                    static_cast<double>(cx) * by
+                                    - static_cast<double>(cy) * bx);
+                            v = static_cast<float>(
+                                    static_cast<double>(ax) * cy
+                                    - static_cast<double>(ay) * cx);
+                            w = static_cast<float>(
+                                    static_cast<double>(bx) * ay
+                                    - static_cast<double>(by) * ax);
+                        }
+                    }
+                    if ((u < 0 || v < 0 || w < 0)
+                        && (u > 0 || v > 0 || w > 0)) {
+                        continue;
+                    }
+                    auto determinant{u + v + w};
+                    if (determinant == 0) {
+                        continue;
+                    }
+
+                    // The distance, scaled by the determinant.
+                    auto scaled_distance{shear_z
+                                         * (u * a[kz] + v * b[kz]
+                                            + w * c[kz])};
+                    if (determinant < 0) {
+                        scaled_distance = -scaled_distance;
+                        determinant = -determinant;
+                    }
+                    if (scaled_distance < min_distance * determinant
+                        || scaled_distance > closest_distance * determinant) {
+                        continue;
+                    }
+                    closest_distance = scaled_distance / determinant;
+                    closest_index = i;
+                    found = true;
+                }
+                return found;
+            })};
+
+    if (!hit_anything) {
+        return false;
+    }
+    const auto& p0{positions[indices[closest_index * 3]]};
+    const auto& p1{positions[indices[closest_index * 3 + 1]]};
+    const auto& p2{positions[indices[closest_index * 3 + 2]]};
+    hit_info.distance = max_distance;
+    hit_info.point = ray.at(max_distance);
+    hit_info.normal = Vector3::cross(p1 - p0, p2 - p0).normalized();
+    hit_info.material_id = material_id;
+    hit_info.object_id = 0;
+    return true;
+}
+
+BoundingBox TriangleMesh::bounding_box() const {
+    return tree.bounds();
+}
+
+}
@@ -0,0 +1,71 @@
+#ifndef TRIANGLE_MESH_H
+#define TRIANGLE_MESH_H
+
+#include "bvh-tree.h"
+#include "hittable.h"
+#include "vector3.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace ray_tracing {
+
+// Indexed triangles: every three entries of `indices` are the positions of
+// one triangle's corners.
+struct MeshData {
+    std::vector<Vector3> positions;
+
+    std::vector<std::uint32_t> indices;
+};
+
+// A triangle mesh with its own BVH over the triangles, meant to be placed in
+// a scene by any number of `Instance`s that share it.
+//
+// Rays are intersected with the watertight algorithm of Woop, Benthin and
+// Wald, which transforms each triangle into a space where the ray runs
+// along the z axis and tests the edges there, so rays through a shared edge
+// or vertex hit at least one of the triangles around it instead of slipping
+// through a gap.
+//
+// The normal faces the side from which the corners wind counterclockwise,
+// the way the normal of a sphere faces outwards, so closed meshes of
+// dielectrics need consistent winding.
+class TriangleMesh : public Hittable {
+public:
+    // `mesh` must hold whole triangles whose indices are all in range.
+    TriangleMesh(MeshData mesh, std::uint32_t material_id);
+
+    std::size_t num_triangles() const;
+
+    std::uint32_t material() const;
+
+    // The corners of the triangle at `index`, in the order they wind.
+    void triangle(std::size_t index,
+                  Vector3& p0,
+                  Vector3& p1,
+                  Vector3& p2) const;
+
+    bool hit(const Ray& ray,
+             HitInfo& hit_info,
+             Vector3::ValueType min_distance,
+             Vector3::ValueType max_distance) const override;
+
+    BoundingBox bounding_box() const override;
+
+private:
+    static constexpr std::size_t max_leaf_size{4};
+
+    std::vector<Vector3> positions;
+
+    // In leaf order, so that each leaf reads a contiguous range.
+    std::vector<std::uint32_t> indices;
+
+    std::uint32_t material_id;
+
+    BvhTree tree;
+};
+
+}
+
+#endif
@@ -1,42 +1,64 @@
 #ifndef VECTOR3_H
 #define VECTOR3_H
 
+#include <cmath>
+
 namespace ray_tracing {
 
-struct Vector3 {
-    using ValueType = float;
+class RandomGenerator;
+
+// The scalar type of the geometry, chosen at build time.
+#ifdef USE_DOUBLE
+using Real = double;
+#else
+using Real = float;
+#endif
+
+// Everything but `random` is defined inline here, so that the arithmetic in
+// the intersection and scattering code compiles down to plain scalar
+// instructions, which the compiler is free to vectorise, without needing
+// link-time optimization.
+template <typename T>
+struct BasicVector3 {
+    using ValueType = T;
 
-    Vector3() = default;
+    BasicVector3() = default;
 
-    Vector3(ValueType x, ValueType y, ValueType z);
+    constexpr BasicVector3(ValueType x, ValueType y, ValueType z);
 
-    static ValueType dot(const Vector3& lhs, const Vector3& rhs);
+    static constexpr ValueType dot(const BasicVector3& lhs,
+                                   const BasicVector3& rhs);
 
-    static Vector3 cross(const Vector3& lhs, const Vector3& rhs);
+    static constexpr BasicVector3 cross(const BasicVector3& lhs,
+                                        const BasicVector3& rhs);
 
-    static Vector3 random(ValueType min, ValueType max);
+    static BasicVector3 random(RandomGenerator& generator,
+                               ValueType min,
+                               ValueType max);
 
-    ValueType magnitude_sqaured() const;
+    constexpr ValueType magnitude_sqaured() const;
 
     ValueType magnitude() const;
 
-    Vector3 normalized() const;
+    BasicVector3 normalized() const;
+
+    constexpr ValueType operator[](int axis) const;
 
-    static const Vector3 zero;
+    static const BasicVector3 zero;
 
-    static const Vector3 one;
+    static const BasicVector3 one;
 
-    static const Vector3 up;
+    static const BasicVector3 up;
 
-    static const Vector3 down;
+    static const BasicVector3 down;
 
-    static const Vector3 left;
+    static const BasicVector3 left;
 
-    static const Vector3 right;
+    static const BasicVector3 right;
 
-    static const Vector3 forward;
+    static const BasicVector3 forward;
 
-    static const Vector3 back;
+    static const BasicVector3 back;
 
     ValueType x;
 
@@ -45,25 +67,229 @@ struct Vector3 {
     ValueType z;
 };
 
-Vector3 operator-(const Vector3& vec);
+using Vector3 = BasicVector3<Real>;
+
+// The scalar operands are taken as `ValueType` so that only the vector
+// determines `T`, and literals such as `2 * vec` convert as they would for a
+// non-template.
+template <typename T>
+constexpr BasicVector3<T> operator-(const BasicVector3<T>& vec);
+
+template <typename T>
+constexpr BasicVector3<T> operator+(const BasicVector3<T>& lhs,
+                                    const BasicVector3<T>& rhs);
+
+template <typename T>
+constexpr BasicVector3<T> operator-(const BasicVector3<T>& lhs,
+                                    const BasicVector3<T>& rhs);
+
+template <typename T>
+constexpr BasicVector3<T> operator*(
+        typename BasicVector3<T>::ValueType lhs,
+        const BasicVector3<T>& rhs);
+
+template <typename T>
+constexpr BasicVector3<T> operator*(
+        const BasicVector3<T>& lhs,
+        typename BasicVector3<T>::ValueType rhs);
+
+template <typename T>
+constexpr BasicVector3<T> operator/(
+        const BasicVector3<T>& lhs,
+        typename BasicVector3<T>::ValueType rhs);
+
+template <typename T>
+constexpr BasicVector3<T>& operator+=(BasicVector3<T>& lhs,
+                                      const BasicVector3<T>& rhs);
+
+template <typename T>
+constexpr BasicVector3<T>& operator-=(BasicVector3<T>& lhs,
+                                      const BasicVector3<T>& rhs);
+
+template <typename T>
+constexpr BasicVector3<T>& operator*=(
+        BasicVector3<T>& lhs,
+        typename BasicVector3<T>::ValueType rhs);
+
+template <typename T>
+constexpr BasicVector3<T>& operator/=(
+        BasicVector3<T>& lhs,
+        typename BasicVector3<T>::ValueType rhs);
+
+template <typename T>
+bool is_vector_near_zero(const BasicVector3<T>& vec);
+
+template <typename T>
+constexpr BasicVector3<T> reflect(const BasicVector3<T>& v,
+                                  const BasicVector3<T>& n);
+
+template <typename T>
+BasicVector3<T> refract(const BasicVector3<T>& v,
+                        const BasicVector3<T>& n,
+                        typename BasicVector3<T>::ValueType refraction_ratio);
+
+template <typename T>
+constexpr BasicVector3<T>::BasicVector3(ValueType x, ValueType y, ValueType z)
+    : x{x}, y{y}, z{z} {}
+
+template <typename T>
+constexpr T BasicVector3<T>::dot(const BasicVector3& lhs,
+                                 const BasicVector3& rhs) {
+    return lhs.x * rhs.x + lhs.y * rhs.y + lhs.z * rhs.z;
+}
 
-Vector3 operator+(const Vector3& lhs, const Vector3& rhs);
+template <typename T>
+constexpr BasicVector3<T> BasicVector3<T>::cross(const BasicVector3& lhs,
+                                                 const BasicVector3& rhs) {
+    return BasicVector3{lhs.y * rhs.z - lhs.z * rhs.y,
+                        lhs.z * rhs.x - lhs.x * rhs.z,
+                        lhs.x * rhs.y - lhs.y * rhs.x};
+}
 
-Vector3 operator-(const Vector3& lhs, const Vector3& rhs);
+template <typename T>
+constexpr T BasicVector3<T>::magnitude_sqaured() const {
+    return x * x + y * y + z * z;
+}
 
-Vector3 operator*(Vector3::ValueType lhs, const Vector3& rhs);
+template <typename T>
+T BasicVector3<T>::magnitude() const {
+    return std::sqrt(magnitude_sqaured());
+}
 
-Vector3 operator*(const Vector3& lhs, Vector3::ValueType rhs);
+template <typename T>
+BasicVector3<T> BasicVector3<T>::normalized() const {
+    return *this / magnitude();
+}
 
-Vector3 operator/(const Vector3& lhs, Vector3::ValueType rhs);
+template <typename T>
+constexpr T BasicVector3<T>::operator[](int axis) const {
+    return axis == 0 ? x : axis == 1 ? y : z;
+}
 
-Vector3& operator+=(Vector3& lhs, const Vector3& rhs);
+template <typename T>
+constexpr BasicVector3<T> BasicVector3<T>::zero{0, 0, 0};
 
-Vector3& operator-=(Vector3& lhs, const Vector3& rhs);
+template <typename T>
+constexpr BasicVector3<T> BasicVector3<T>::one{1, 1, 1};
 
-Vector3& operator*=(Vector3& lhs, Vector3::ValueType rhs);
+template <typename T>
+constexpr BasicVector3<T> BasicVector3<T>::up{0, 1, 0};
 
-Vector3& operator/=(Vector3& lhs, Vector3::ValueType rhs);
+template <typename T>
+constexpr BasicVector3<T> BasicVector3<T>::down{0, -1, 0};
+
+template <typename T>
+constexpr BasicVector3<T> BasicVector3<T>::left{-1, 0, 0};
+
+template <typename T>
+constexpr BasicVector3<T> BasicVector3<T>::right{1, 0, 0};
+
+template <typename T>
+constexpr BasicVector3<T> BasicVector3<T>::forward{0, 0, 1};
+
+template <typename T>
+constexpr BasicVector3<T> BasicVector3<T>::back{0, 0, -1};
+
+template <typename T>
+constexpr BasicVector3<T> operator-(const BasicVector3<T>& vec) {
+    return BasicVector3<T>{-vec.x, -vec.y, -vec.z};
+}
+
+template <typename T>
+constexpr BasicVector3<T> operator+(const BasicVector3<T>& lhs,
+                                    const BasicVector3<T>& rhs) {
+    return BasicVector3<T>{lhs.x + rhs.x, lhs.y + rhs.y, lhs.z + rhs.z};
+}
+
+template <typename T>
+constexpr BasicVector3<T> operator-(const BasicVector3<T>& lhs,
+                                    const BasicVector3<T>& rhs) {
+    return BasicVector3<T>{lhs.x - rhs.x, lhs.y - rhs.y, lhs.z - rhs.z};
+}
+
+template <typename T>
+constexpr BasicVector3<T> operator*(
+        typename BasicVector3<T>::ValueType lhs,
+        const BasicVector3<T>& rhs) {
+    return BasicVector3<T>{lhs * rhs.x, lhs * rhs.y, lhs * rhs.z};
+}
+
+template <typename T>
+constexpr BasicVector3<T> operator*(
+        const BasicVector3<T>& lhs,
+        typename BasicVector3<T>::ValueType rhs) {
+    return rhs * lhs;
+}
+
+// Multiplies by the reciprocal, trading the last bit of precision for one
+// division instead of three.
+template <typename T>
+constexpr BasicVector3<T> operator/(
+        const BasicVector3<T>& lhs,
+        typename BasicVector3<T>::ValueType rhs) {
+    return (1 / rhs) * lhs;
+}
+
+template <typename T>
+constexpr BasicVector3<T>& operator+=(BasicVector3<T>& lhs,
+                                      const BasicVector3<T>& rhs) {
+    lhs.x += rhs.x;
+    lhs.y += rhs.y;
+    lhs.z += rhs.z;
+    return lhs;
+}
+
+template <typename T>
+constexpr BasicVector3<T>& operator-=(BasicVector3<T>& lhs,
+                                      const BasicVector3<T>& rhs) {
+    lhs.x -= rhs.x;
+    lhs.y -= rhs.y;
+    lhs.z -= rhs.z;
+    return lhs;
+}
+
+template <typename T>
+constexpr BasicVector3<T>& operator*=(
+        BasicVector3<T>& lhs,
+        typename BasicVector3<T>::ValueType rhs) {
+    lhs.x *= rhs;
+    lhs.y *= rhs;
+    lhs.z *= rhs;
+    return lhs;
+}
+
+template <typename T>
+constexpr BasicVector3<T>& operator/=(
+        BasicVector3<T>& lhs,
+        typename BasicVector3<T>::ValueType rhs) {
+    lhs *= (1 / rhs);
+    return lhs;
+}
+
+template <typename T>
+bool is_vector_near_zero(const BasicVector3<T>& vec) {
+    constexpr auto epsilon{1e-8};
+    return std::fabs(vec.x) < epsilon && std::fabs(vec.y) < epsilon
+           && std::fabs(vec.z) < epsilon;
+}
+
+template <typename T>
+constexpr BasicVector3<T> reflect(const BasicVector3<T>& v,
+                                  const BasicVector3<T>& n) {
+    return v - 2 * BasicVector3<T>::dot(v, n) * n;
+}
+
+template <typename T>
+BasicVector3<T> refract(const BasicVector3<T>& v,
+                        const BasicVector3<T>& n,
+                        typename BasicVector3<T>::ValueType refraction_ratio) {
+    auto uv{v.normalized()};
+    auto cos_theta{std::fmin(BasicVector3<T>::dot(-uv, n), 1)};
+    auto r_out_perp{refraction_ratio * (uv + cos_theta * n)};
+    auto r_out_parallel{
+            -std::sqrt(std::fabs(1 - r_out_perp.magnitude_sqaured())) * n};
+    return r_out_perp + r_out_parallel;
+}
 
 }
 
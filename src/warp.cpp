@@ -0,0 +1,112 @@
+#include "warp.h"
+
+#include "utils.h"
+
+#include <algorithm>
+
+#include <cmath>
+
+namespace ray_tracing {
+
+// The sine and cosine of an angle within a quarter of pi of zero, by their
+// Taylor series, which are as close as floats get there by the tenth power,
+// and much faster than the library's, which reduce the angle first.
+static void small_angle_sin_cos(Vector3::ValueType angle,
+                                Vector3::ValueType& sine,
+                                Vector3::ValueType& cosine) {
+    using ValueType = Vector3::ValueType;
+    constexpr ValueType s3{-1.0 / 6};
+    constexpr ValueType s5{1.0 / 120};
+    constexpr ValueType s7{-1.0 / 5040};
+    constexpr ValueType s9{1.0 / 362880};
+    constexpr ValueType c2{-1.0 / 2};
+    constexpr ValueType c4{1.0 / 24};
+    constexpr ValueType c6{-1.0 / 720};
+    constexpr ValueType c8{1.0 / 40320};
+    constexpr ValueType c10{-1.0 / 3628800};
+    auto square{angle * angle};
+    auto sine_tail{s5 + square * (s7 + square * s9)};
+    sine = angle * (1 + square * (s3 + square * sine_tail));
+    auto cosine_tail{c6 + square * (c8 + square * c10)};
+    cosine = 1 + square * (c2 + square * (c4 + square * cosine_tail));
+}
+
+Vector3 square_to_concentric_disk(double u, double v) {
+    using ValueType = Vector3::ValueType;
+    auto a{static_cast<ValueType>(2 * u - 1)};
+    auto b{static_cast<ValueType>(2 * v - 1)};
+    if (a == 0 && b == 0) {
+        return Vector3::zero;
+    }
+
+    // Each point goes to the circle of the radius of the square it lies on,
+    // at the angle its position along that square's side gives, within a
+    // quarter of pi of an axis. Measured from the diagonal of its quadrant,
+    // the angle is the same whichever side it lies on, up to the sign, so
+    // there is no branch on the side to mispredict half of the time.
+    auto abs_a{std::abs(a)};
+    auto abs_b{std::abs(b)};
+    auto radius{std::max(abs_a, abs_b)};
+    constexpr auto quarter_pi{static_cast<ValueType>(pi / 4)};
+    auto from_diagonal{
+            std::copysign(quarter_pi * (1 - std::min(abs_a, abs_b) / radius),
+                          abs_b - abs_a)};
+    ValueType sine;
+    ValueType cosine;
+    small_angle_sin_cos(from_diagonal, sine, cosine);
+    auto scale{radius * static_cast<ValueType>(std::sqrt(0.5))};
+    return Vector3{std::copysign(scale * (cosine - sine), a),
+                   std::copysign(scale * (cosine + sine), b),
+                   0};
+}
+
+Vector3 square_to_uniform_sphere(double u, double v) {
+    using ValueType = Vector3::ValueType;
+    auto z{static_cast<ValueType>(1 - 2 * u)};
+    auto radius{std::sqrt(std::max(ValueType{0}, 1 - z * z))};
+    auto phi{static_cast<ValueType>(2 * pi * v)};
+    return Vector3{radius * std::cos(phi), radius * std::sin(phi), z};
+}
+
+Vector3::ValueType uniform_sphere_pdf() {
+    return static_cast<Vector3::ValueType>(1 / (4 * pi));
+}
+
+Vector3 square_to_cosine_hemisphere(double u, double v) {
+    auto disk{square_to_concentric_disk(u, v)};
+    auto z{std::sqrt(std::max(Vector3::ValueType{0},
+                              1 - disk.x * disk.x - disk.y * disk.y))};
+    return Vector3{disk.x, disk.y, z};
+}
+
+Vector3::ValueType cosine_hemisphere_pdf(Vector3::ValueType cosine) {
+    return cosine / static_cast<Vector3::ValueType>(pi);
+}
+
+Vector3 cube_to_uniform_ball(double u, double v, double w) {
+    return std::cbrt(static_cast<Vector3::ValueType>(w))
+           * square_to_uniform_sphere(u, v);
+}
+
+void square_to_triangle(double u,
+                        double v,
+                        Vector3::ValueType& weight1,
+                        Vector3::ValueType& weight2) {
+    auto root{std::sqrt(u)};
+    weight1 = static_cast<Vector3::ValueType>(root * (1 - v));
+    weight2 = static_cast<Vector3::ValueType>(root * v);
+}
+
+void orthonormal_basis(const Vector3& normal,
+                       Vector3& tangent,
+                       Vector3& bitangent) {
+    auto sign{std::copysign(Vector3::ValueType{1}, normal.z)};
+    auto a{-1 / (sign + normal.z)};
+    auto b{normal.x * normal.y * a};
+    tangent = Vector3{1 + sign * normal.x * normal.x * a,
+                      sign * b,
+                      -sign * normal.x};
+    bitangent = Vector3{b, sign + normal.y * normal.y * a, -normal.y};
+}
+
+}
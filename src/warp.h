@@ -0,0 +1,54 @@
+#ifndef WARP_H
+#define WARP_H
+
+#include "vector3.h"
+
+namespace ray_tracing {
+
+// Closed-form maps from the unit square, or cube, onto the domains that
+// directions and points are sampled on. Unlike rejection sampling, each
+// takes a fixed count of numbers and has no loop to mispredict, and points
+// spread evenly over the square stay spread evenly over the domain, so they
+// keep what a stratified or low-discrepancy sampler gives them.
+
+// Onto the unit disk in the xy plane, uniformly, by Shirley and Chiu's
+// concentric map, which sends the square's concentric squares to
+// concentric circles and so distorts areas much less than polar
+// coordinates do.
+Vector3 square_to_concentric_disk(double u, double v);
+
+// Onto the unit sphere, uniformly: uniform in height, and so in area, by
+// Archimedes' hat-box theorem.
+Vector3 square_to_uniform_sphere(double u, double v);
+
+Vector3::ValueType uniform_sphere_pdf();
+
+// Onto the unit hemisphere around +z, with a density proportional to the
+// cosine to +z, by lifting the concentric disk straight up onto it.
+Vector3 square_to_cosine_hemisphere(double u, double v);
+
+// With respect to solid angle.
+Vector3::ValueType cosine_hemisphere_pdf(Vector3::ValueType cosine);
+
+// Into the unit ball, uniformly: a direction from `u` and `v`, and a
+// distance from the center from `w`.
+Vector3 cube_to_uniform_ball(double u, double v, double w);
+
+// Onto a triangle, uniformly, as the barycentric weights of its second and
+// third corners. Folding the square along the square root of `u` keeps the
+// points uniform.
+void square_to_triangle(double u,
+                        double v,
+                        Vector3::ValueType& weight1,
+                        Vector3::ValueType& weight2);
+
+// Sets `tangent` and `bitangent` to unit vectors that make a right-handed
+// orthonormal basis with the unit vector `normal`, with Duff et al.'s
+// construction, which has no branch on the direction of the normal.
+void orthonormal_basis(const Vector3& normal,
+                       Vector3& tangent,
+                       Vector3& bitangent);
+
+}
+
+#endif